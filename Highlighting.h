@@ -0,0 +1,41 @@
+// Highlighting.h
+//  Colours and tooltips for highlight reason masks, shared by both tables
+
+#pragma once
+
+#include "Highlights.h"
+
+#include <QColor>
+#include <QString>
+#include <QStringList>
+
+// Indexed by a HighlightMask (Difficulty | Topics | Hours), so a cell's
+// colour is a table lookup instead of building a reason set.
+inline const QColor &colorForReason(HighlightMask reasons) {
+    // We use bright strong colors, handle overlapping combinations by combining colors or using predefined ones
+    static const QColor colors[8] = {
+        QColor(),          // no color
+        QColor("#FF0000"), // Difficulty: Red
+        QColor("#FFA500"), // Topics: Orange
+        QColor("#FF4500"), // Difficulty + Topics: OrangeRed
+        QColor("#0000FF"), // Hours: Blue
+        QColor("#FF8C00"), // Difficulty + Hours: DarkOrange
+        QColor("#1E90FF"), // Topics + Hours: DodgerBlue
+        QColor("#800080"), // Purple all combined
+    };
+    return colors[reasons & ALL_HIGHLIGHTS];
+}
+
+// Text colour that stays readable on top of a highlight colour
+inline QColor textColorFor(const QColor &bgColor) {
+    if (!bgColor.isValid()) return QColor("#001f3f"); // dark navy text
+    return (bgColor.lightness() < 128) ? QColor(Qt::white) : QColor(Qt::black);
+}
+
+inline QString reasonsText(HighlightMask reasons) {
+    QStringList parts;
+    if (reasons & Difficulty) parts << "Highest Difficulty sum";
+    if (reasons & Topics) parts << "Most Topics covered";
+    if (reasons & Hours) parts << "Most Study Hours";
+    return parts.join(", ");
+}
@@ -1,4 +1,4 @@
-// main.cpp
+// Project.cpp
 //  Study Schedule Generator 
 
 #include <QApplication>
@@ -13,6 +13,7 @@
 #include <QDoubleSpinBox>
 #include <QPushButton>
 #include <QTableWidget>
+#include <QTableView>
 #include <QHeaderView>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -21,136 +22,58 @@
 #include <QGroupBox>
 #include <QScrollArea>
 #include <QFile>
-#include <QTextStream>
 #include <QDate>
 #include <QBrush>
 #include <QColor>
 #include <QComboBox>
+#include <QStatusBar>
+#include <QCheckBox>
+#include <QDateEdit>
+#include <QTimeEdit>
+#include <QProgressBar>
+#include <QTimer>
+#include <QSlider>
+#include <QElapsedTimer>
+#include <QKeySequence>
+#include <QSignalBlocker>
+#include <QInputDialog>
+
+#include "BackgroundGenerator.h"
+#include "Calendar.h"
+#include "ClockPlacement.h"
+#include "EditHistory.h"
+#include "Highlighting.h"
+#include "PerfStats.h"
+#include "ProfileStore.h"
+#include "ProgressJournal.h"
+#include "Replan.h"
+#include "Schedule.h"
+#include "ScheduleConfig.h"
+#include "ScheduleIO.h"
+#include "ScheduleIndex.h"
+#include "ScheduleTableModel.h"
+#include "Subject.h"
+#include "SyllabusImport.h"
+#include "WhatIf.h"
+#include "WorkStealingPool.h"
 
 #include <vector>
 #include <string>
-#include <queue>
 #include <algorithm>
 #include <fstream>
-#include <iomanip>
-#include <stdexcept>
-#include <set>
+#include <memory>
+#include <unordered_map>
 
 using namespace std;
 
-static constexpr double EPSILON = 0.01;
-static constexpr int DEFAULT_DAYS = 14;
-static constexpr double DEFAULT_HOURS_PER_DAY = 4.0;
-static constexpr int MAX_DAYS = 365;
-
-// Subject model class
-class Subject {
-private:
-    string name;
-    int difficulty;
-    int importance;
-    int topics;
-    double remainingHours;
-    vector<string> topicsList;
-public:
-    Subject() : name(""), difficulty(1), importance(1), topics(0), remainingHours(0.0) {}
-    Subject(const string &n, int diff, int imp, int t, const vector<string> &topicNames)
-        : name(n), difficulty(diff), importance(imp), topics(t), remainingHours(0.0), topicsList(topicNames) {}
-
-    string getName() const { return name; }
-    int getDifficulty() const { return difficulty; }
-    int getImportance() const { return importance; }
-    int getTopicsCount() const { return topics; }
-    double getRemainingHours() const { return remainingHours; }
-    void setRemainingHours(double hrs) { remainingHours = hrs; }
-
-    bool hasTopics() const { return !topicsList.empty(); }
-
-    string getTopicAtIndex(size_t idx) const {
-        if (topicsList.empty()) return string("Topic");
-        return topicsList[idx % topicsList.size()];
-    }
-
-    void addTopic(const string &t) { topicsList.push_back(t); }
-    void setName(const string &n) { name = n; }
-    void setDifficulty(int d) { difficulty = d; }
-    void setImportance(int i) { importance = i; }
-    void setTopics(int t) { topics = t; }
-    void setTopicsList(const vector<string> &tlist) { topicsList = tlist; topics = (int)tlist.size(); }
-};
-
-// Task and ScheduleGenerator class
-class Task {
-public:
-    string subject;
-    string topic;
-    double hours;
-    Task(const string &s, const string &t, double h) : subject(s), topic(t), hours(h) {}
-};
-
-class ScheduleGenerator {
-private:
-    vector<Subject> subjects;
-    vector<vector<Task>> schedule;
-    int days;
-    double hoursPerDay;
-public:
-    ScheduleGenerator(int d, double hpd) : days(d), hoursPerDay(hpd) {
-        schedule.resize(days);
-    }
-
-    void setSubjects(const vector<Subject> &s) { subjects = s; }
-
-    void generateSchedule() {
-        vector<double> weights;
-        double totalWeight = 0.0;
-        for (auto &s : subjects) {
-            double w = s.getDifficulty() * s.getImportance() * max(1, s.getTopicsCount());
-            weights.push_back(w);
-            totalWeight += w;
-        }
-
-        double totalAvailableHours = days * hoursPerDay;
-        for (int i = 0; i < (int)subjects.size(); ++i) {
-            double assignedHours = (totalWeight > 0) ? (weights[i] / totalWeight) * totalAvailableHours : 0;
-            subjects[i].setRemainingHours(assignedHours);
-        }
-
-        schedule.clear();
-        schedule.resize(days);
-        vector<size_t> topicIndices(subjects.size(), 0);
-
-        for (int d = 0; d < days; ++d) {
-            double left = hoursPerDay;
-            bool assignedSomething = true;
-
-            while (left > EPSILON && assignedSomething) {
-                assignedSomething = false;
-
-                for (int i = 0; i < (int)subjects.size() && left > EPSILON; ++i) {
-                    if (subjects[i].getRemainingHours() <= EPSILON) continue;
-
-                    double toAssign = min(left, subjects[i].getRemainingHours());
-                    string topic = subjects[i].getTopicAtIndex(topicIndices[i]);
-                    topicIndices[i]++;
-                    schedule[d].push_back(Task(subjects[i].getName(), topic, toAssign));
-                    subjects[i].setRemainingHours(subjects[i].getRemainingHours() - toAssign);
-                    left -= toAssign;
-                    assignedSomething = true;
-                }
-            }
-        }
-    }
-
-    const vector<vector<Task>>& getSchedule() const { return schedule; }
-};
+Q_DECLARE_METATYPE(std::shared_ptr<GenerationResult>)
 
 // AddSubjectDialog 
 
 class AddSubjectDialog : public QDialog {
     Q_OBJECT
 public:
-    AddSubjectDialog(QWidget *parent = nullptr) : QDialog(parent) {
+    AddSubjectDialog(const QDate &planStart, QWidget *parent = nullptr) : QDialog(parent), start(planStart) {
         setWindowTitle("Add Subject");
         QVBoxLayout *main = new QVBoxLayout;
         QFormLayout *form = new QFormLayout;
@@ -161,11 +84,19 @@ public:
         topicsEdit = new QPlainTextEdit;
         topicsEdit->setPlaceholderText("Enter one topic per line");
         topicsEdit->setFixedHeight(120);
+        examCheck = new QCheckBox("Exam on:");
+        examEdit = new QDateEdit(planStart.addDays(DEFAULT_DAYS));
+        examEdit->setCalendarPopup(true);
+        examEdit->setEnabled(false);
+        QHBoxLayout *examRow = new QHBoxLayout;
+        examRow->addWidget(examCheck);
+        examRow->addWidget(examEdit);
 
         form->addRow("Name:", nameEdit);
         form->addRow("Difficulty (1-10):", diffSpin);
         form->addRow("Importance (1-10):", impSpin);
         form->addRow("Topics (one per line):", topicsEdit);
+        form->addRow("Exam date:", examRow);
 
         main->addLayout(form);
 
@@ -179,12 +110,14 @@ public:
 
         connect(ok, &QPushButton::clicked, this, &AddSubjectDialog::onOk);
         connect(cancel, &QPushButton::clicked, this, &AddSubjectDialog::reject);
+        connect(examCheck, &QCheckBox::toggled, examEdit, &QDateEdit::setEnabled);
     }
 
     string getName() const { return name.toStdString(); }
     int getDifficulty() const { return diff; }
     int getImportance() const { return imp; }
     vector<string> getTopics() const { return topics; }
+    int getExamDay() const { return examDay; }
 
 private slots:
     void onOk() {
@@ -196,18 +129,26 @@ private slots:
         diff = diffSpin->value();
         imp = impSpin->value();
 
-        QString ttext = topicsEdit->toPlainText().trimmed();
-        QStringList lines = ttext.split('\n', Qt::SkipEmptyParts);
+        // One UTF-8 conversion for the whole text; lines are split in place.
         topics.clear();
-        for (const QString &l : lines) {
-            QString trimmed = l.trimmed();
-            if (!trimmed.isEmpty()) topics.push_back(trimmed.toStdString());
-        }
+        splitTopicLines(topicsEdit->toPlainText().toStdString(), topics);
         if (topics.empty()) {
             QMessageBox::warning(this, "Input error", "Please enter at least one topic.");
             return;
         }
 
+        // Plan day of the exam, counting the start date as day 1
+        examDay = 0;
+        if (examCheck->isChecked()) {
+            qint64 offset = start.daysTo(examEdit->date());
+            if (offset < 1 || offset >= MAX_DAYS) {
+                QMessageBox::warning(this, "Input error",
+                                     QString("The exam must be between 1 and %1 days after the start date.").arg(MAX_DAYS - 1));
+                return;
+            }
+            examDay = (int)offset + 1;
+        }
+
         accept();
     }
 
@@ -216,13 +157,250 @@ private:
     QSpinBox *diffSpin;
     QSpinBox *impSpin;
     QPlainTextEdit *topicsEdit;
+    QCheckBox *examCheck;
+    QDateEdit *examEdit;
 
+    QDate start;
     QString name;
     int diff;
     int imp;
+    int examDay = 0;
     vector<string> topics;
 };
 
+// WhatIfDialog: generates a grid of days × hours per day (optionally with
+// one subject's weight changed) and lists summary metrics per variant
+
+class WhatIfDialog : public QDialog {
+    Q_OBJECT
+public:
+    WhatIfDialog(const PlanInput &plan, QWidget *parent = nullptr)
+        : QDialog(parent), explorer(pool), subjects(plan.subjects) {
+        setWindowTitle("What-if");
+        explorer.setPlan(plan);
+        QVBoxLayout *main = new QVBoxLayout;
+        QFormLayout *form = new QFormLayout;
+
+        daysFromSpin = new QSpinBox; daysFromSpin->setRange(1,MAX_DAYS); daysFromSpin->setValue(max(1, plan.days - 7));
+        daysToSpin = new QSpinBox; daysToSpin->setRange(1,MAX_DAYS); daysToSpin->setValue(min(MAX_DAYS, plan.days + 7));
+        daysStepSpin = new QSpinBox; daysStepSpin->setRange(1,MAX_DAYS); daysStepSpin->setValue(7);
+        daysSlider = new QSlider(Qt::Horizontal); daysSlider->setRange(1,MAX_DAYS); daysSlider->setValue(daysToSpin->value());
+        QHBoxLayout *daysRow = new QHBoxLayout;
+        daysRow->addWidget(daysFromSpin); daysRow->addWidget(new QLabel("to")); daysRow->addWidget(daysToSpin);
+        daysRow->addWidget(new QLabel("step")); daysRow->addWidget(daysStepSpin); daysRow->addWidget(daysSlider);
+
+        hoursFromSpin = new QDoubleSpinBox; hoursFromSpin->setRange(0.5,24.0); hoursFromSpin->setSingleStep(0.5); hoursFromSpin->setValue(max(0.5, plan.minutesPerDay / 60.0 - 1.0));
+        hoursToSpin = new QDoubleSpinBox; hoursToSpin->setRange(0.5,24.0); hoursToSpin->setSingleStep(0.5); hoursToSpin->setValue(min(24.0, plan.minutesPerDay / 60.0 + 1.0));
+        hoursStepSpin = new QDoubleSpinBox; hoursStepSpin->setRange(0.25,24.0); hoursStepSpin->setSingleStep(0.25); hoursStepSpin->setValue(0.5);
+        QHBoxLayout *hoursRow = new QHBoxLayout;
+        hoursRow->addWidget(hoursFromSpin); hoursRow->addWidget(new QLabel("to")); hoursRow->addWidget(hoursToSpin);
+        hoursRow->addWidget(new QLabel("step")); hoursRow->addWidget(hoursStepSpin); hoursRow->addStretch();
+
+        // Optional second weight set: one subject's weight times a factor
+        weightCombo = new QComboBox;
+        weightCombo->addItem("Plan weights only");
+        for (const Subject &sub : subjects) weightCombo->addItem(QString::fromStdString(sub.getName()));
+        factorSpin = new QDoubleSpinBox; factorSpin->setRange(0.0,10.0); factorSpin->setSingleStep(0.25); factorSpin->setValue(2.0);
+        factorSpin->setPrefix("× ");
+        QHBoxLayout *weightRow = new QHBoxLayout;
+        weightRow->addWidget(weightCombo); weightRow->addWidget(factorSpin); weightRow->addStretch();
+
+        form->addRow("Days:", daysRow);
+        form->addRow("Hours per day:", hoursRow);
+        form->addRow("Also compare:", weightRow);
+        main->addLayout(form);
+
+        resultTable = new QTableWidget(0,9);
+        resultTable->setHorizontalHeaderLabels({"Days","Hours/day","Weights","Planned","Peak day","Peak time",
+                                                "Peak difficulty","Min coverage","Exam shortfalls"});
+        resultTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        resultTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        resultTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        resultTable->setSelectionMode(QAbstractItemView::SingleSelection);
+        main->addWidget(resultTable);
+
+        summaryLabel = new QLabel;
+        main->addWidget(summaryLabel);
+
+        QHBoxLayout *btns = new QHBoxLayout;
+        QPushButton *use = new QPushButton("Use Selected");
+        QPushButton *close = new QPushButton("Close");
+        btns->addStretch(); btns->addWidget(use); btns->addWidget(close);
+        main->addLayout(btns);
+
+        setLayout(main);
+        resize(900, 560);
+
+        // Every change regenerates the whole grid at once; it takes
+        // milliseconds, so dragging the slider updates the table live.
+        for (QSpinBox *spin : {daysFromSpin, daysToSpin, daysStepSpin})
+            connect(spin, qOverload<int>(&QSpinBox::valueChanged), this, &WhatIfDialog::recompute);
+        for (QDoubleSpinBox *spin : {hoursFromSpin, hoursToSpin, hoursStepSpin, factorSpin})
+            connect(spin, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &WhatIfDialog::recompute);
+        connect(weightCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &WhatIfDialog::recompute);
+        connect(daysSlider, &QSlider::valueChanged, daysToSpin, &QSpinBox::setValue);
+        connect(daysToSpin, qOverload<int>(&QSpinBox::valueChanged), daysSlider, &QSlider::setValue);
+        connect(use, &QPushButton::clicked, this, &WhatIfDialog::onUse);
+        connect(close, &QPushButton::clicked, this, &WhatIfDialog::reject);
+
+        recompute();
+    }
+
+    int getDays() const { return chosenDays; }
+    int getMinutesPerDay() const { return chosenMinutes; }
+
+private slots:
+    void recompute() {
+        WhatIfGrid grid;
+        for (int d = daysFromSpin->value(); d <= daysToSpin->value(); d += daysStepSpin->value())
+            grid.days.push_back(d);
+        int step = max(1, hoursToMinutes(hoursStepSpin->value()));
+        for (int m = hoursToMinutes(hoursFromSpin->value()); m <= hoursToMinutes(hoursToSpin->value()); m += step)
+            grid.minutesPerDay.push_back(m);
+        int boosted = weightCombo->currentIndex() - 1;
+        if (boosted >= 0)
+            grid.weightSets.push_back(scaleWeights(explorer.subjectTable(), {{(uint32_t)boosted, factorSpin->value()}}));
+
+        rowPlans.clear();
+        resultTable->setRowCount(0);
+        if (grid.size() > MAX_VARIANTS) {
+            summaryLabel->setText(QString("%1 variants; narrow the ranges to at most %2.").arg(grid.size()).arg(MAX_VARIANTS));
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const vector<WhatIfResult> &results = explorer.run(grid);
+        qint64 elapsed = timer.elapsed();
+
+        QString boostedLabel = boosted >= 0 ? QString("%1 × %2").arg(weightCombo->currentText()).arg(factorSpin->value()) : QString();
+        const vector<uint32_t> &topicBase = explorer.subjectTable().names->topicBase;
+        resultTable->setRowCount((int)results.size());
+        for (size_t r = 0; r < results.size(); ++r) {
+            const WhatIfResult &res = results[r];
+            QTableWidgetItem *items[9] = {
+                new QTableWidgetItem(QString::number(res.days)),
+                new QTableWidgetItem(QString::fromStdString(formatTime(res.minutesPerDay))),
+                new QTableWidgetItem(res.weightSet == 0 ? QString("Plan") : boostedLabel),
+                new QTableWidgetItem(QString::fromStdString(formatTime((int)res.totalMinutes))),
+                new QTableWidgetItem(QString::number(res.peakDay + 1)),
+                new QTableWidgetItem(QString::fromStdString(formatTime(res.peakMinutes))),
+                new QTableWidgetItem(QString::number(res.peakDifficulty)),
+                new QTableWidgetItem(QString("%1%").arg(qRound(res.minCoverage * 100.0))),
+                new QTableWidgetItem(QString::number(res.shortfalls)),
+            };
+
+            // Per-subject time and topic coverage on hover
+            QStringList lines;
+            for (size_t i = 0; i < res.subjects.size(); ++i) {
+                lines << QString("%1: %2, %3 of %4 topics")
+                             .arg(QString::fromStdString(subjects[i].getName()))
+                             .arg(QString::fromStdString(formatTime((int)res.subjects[i].minutes)))
+                             .arg(res.subjects[i].topicsCovered)
+                             .arg(topicBase[i + 1] - topicBase[i]);
+            }
+            QString tooltip = lines.join("\n");
+            for (int c = 0; c < 9; ++c) {
+                items[c]->setToolTip(tooltip);
+                resultTable->setItem((int)r, c, items[c]);
+            }
+            rowPlans.push_back({res.days, res.minutesPerDay});
+        }
+        summaryLabel->setText(QString("%1 variants generated in %2 ms").arg(results.size()).arg(elapsed));
+    }
+
+    void onUse() {
+        int row = resultTable->currentRow();
+        if (row < 0 || row >= (int)rowPlans.size()) {
+            QMessageBox::information(this, "What-if", "Select a variant first.");
+            return;
+        }
+        chosenDays = rowPlans[row].first;
+        chosenMinutes = rowPlans[row].second;
+        accept();
+    }
+
+private:
+    static constexpr size_t MAX_VARIANTS = 2000;
+
+    QSpinBox *daysFromSpin;
+    QSpinBox *daysToSpin;
+    QSpinBox *daysStepSpin;
+    QSlider *daysSlider;
+    QDoubleSpinBox *hoursFromSpin;
+    QDoubleSpinBox *hoursToSpin;
+    QDoubleSpinBox *hoursStepSpin;
+    QComboBox *weightCombo;
+    QDoubleSpinBox *factorSpin;
+    QTableWidget *resultTable;
+    QLabel *summaryLabel;
+
+    WorkStealingPool pool;
+    WhatIfExplorer explorer;
+    vector<Subject> subjects;
+    vector<pair<int, int>> rowPlans; // days, minutes per day of each table row
+    int chosenDays = 0;
+    int chosenMinutes = 0;
+};
+
+// TimelineDialog: one subject's study days, read off the schedule index,
+// with the time and topics of each day
+
+class TimelineDialog : public QDialog {
+public:
+    TimelineDialog(const Schedule &schedule, const ScheduleIndex &index, uint32_t subject, const QDate &start,
+                   QWidget *parent = nullptr) : QDialog(parent) {
+        setWindowTitle("Timeline: " + QString::fromStdString(schedule.nameTables()->subjects[subject]));
+        QVBoxLayout *main = new QVBoxLayout;
+
+        QTableWidget *table = new QTableWidget(0,4);
+        table->setHorizontalHeaderLabels({"Day","Date","Time","Topics"});
+        table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+        // The subject's slots are in plan order, so each day's slots follow
+        // one another and one walk pairs them with the subject's days.
+        Postings days = index.subjectDays(subject);
+        Postings slotRows = index.subjectSlots(subject);
+        table->setRowCount((int)days.size());
+        size_t p = 0;
+        int total = 0;
+        for (size_t r = 0; r < days.size(); ++r) {
+            int d = (int)days[r];
+            int minutes = 0;
+            QStringList topics;
+            for (; p < slotRows.size() && index.dayOfSlot(slotRows[p]) == d; ++p) {
+                const ScheduleSlot &t = schedule.allSlots()[slotRows[p]];
+                minutes += t.minutes;
+                QString topic = QString::fromStdString(schedule.topicName(t));
+                topics << (t.kind == SlotKind::Review ? QString::fromLatin1(REVIEW_PREFIX) + topic : topic);
+            }
+            total += minutes;
+            QTableWidgetItem *items[4] = {
+                new QTableWidgetItem(QString::number(d + 1)),
+                new QTableWidgetItem(start.addDays(d).toString("yyyy-MM-dd")),
+                new QTableWidgetItem(QString::fromStdString(formatTime(minutes))),
+                new QTableWidgetItem(topics.join("; ")),
+            };
+            for (int c = 0; c < 4; ++c) table->setItem((int)r, c, items[c]);
+        }
+        main->addWidget(table);
+        main->addWidget(new QLabel(QString("%1 study days, %2 in total")
+                                       .arg(days.size())
+                                       .arg(QString::fromStdString(formatTime(total)))));
+
+        QHBoxLayout *btns = new QHBoxLayout;
+        QPushButton *close = new QPushButton("Close");
+        btns->addStretch(); btns->addWidget(close);
+        main->addLayout(btns);
+
+        setLayout(main);
+        resize(700, 480);
+
+        connect(close, &QPushButton::clicked, this, &TimelineDialog::accept);
+    }
+};
+
 // MainWindow 
 
 class MainWindow : public QMainWindow {
@@ -237,10 +415,73 @@ public:
         QFormLayout *controlsLayout = new QFormLayout;
 
         daysSpin = new QSpinBox; daysSpin->setRange(1,MAX_DAYS); daysSpin->setValue(DEFAULT_DAYS);
-        hoursSpin = new QDoubleSpinBox; hoursSpin->setRange(0.5,24.0); hoursSpin->setSingleStep(0.5); hoursSpin->setValue(DEFAULT_HOURS_PER_DAY);
-
+        hoursSpin = new QDoubleSpinBox; hoursSpin->setRange(0.5,24.0); hoursSpin->setSingleStep(0.5); hoursSpin->setValue(DEFAULT_MINUTES_PER_DAY / 60.0);
+        maxChunkSpin = new QDoubleSpinBox; maxChunkSpin->setRange(0.25,24.0); maxChunkSpin->setSingleStep(0.25); maxChunkSpin->setValue(DEFAULT_MAX_CHUNK_MINUTES / 60.0);
+        minSlotSpin = new QDoubleSpinBox; minSlotSpin->setRange(0.05,24.0); minSlotSpin->setSingleStep(0.25); minSlotSpin->setValue(DEFAULT_MIN_SLOT_MINUTES / 60.0);
+        startDate = QDate::currentDate();
+        startEdit = new QDateEdit(startDate); startEdit->setCalendarPopup(true);
+
+        // Weekdays to study on; unchecked days get no study time
+        QHBoxLayout *weekdayRow = new QHBoxLayout;
+        const char *weekdayNames[7] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+        for (int w = 0; w < 7; ++w) {
+            weekdayChecks[w] = new QCheckBox(weekdayNames[w]);
+            weekdayChecks[w]->setChecked(true);
+            weekdayRow->addWidget(weekdayChecks[w]);
+        }
+        weekdayRow->addStretch();
+
+        // Spaced-repetition reviews: length of one review and the share of each day kept for them
+        QHBoxLayout *reviewRow = new QHBoxLayout;
+        reviewCheck = new QCheckBox("Review studied topics");
+        reviewMinutesSpin = new QSpinBox; reviewMinutesSpin->setRange(5,120); reviewMinutesSpin->setSingleStep(5); reviewMinutesSpin->setSuffix(" min"); reviewMinutesSpin->setValue(DEFAULT_REVIEW_MINUTES);
+        reviewShareSpin = new QSpinBox; reviewShareSpin->setRange(5,95); reviewShareSpin->setSingleStep(5); reviewShareSpin->setSuffix("% of day"); reviewShareSpin->setValue(DEFAULT_REVIEW_SHARE_PERCENT);
+        reviewMinutesSpin->setEnabled(false);
+        reviewShareSpin->setEnabled(false);
+        reviewRow->addWidget(reviewCheck);
+        reviewRow->addWidget(reviewMinutesSpin);
+        reviewRow->addWidget(reviewShareSpin);
+        reviewRow->addStretch();
+
+        // Weighting and topic order policies, in SchedulePolicies.h enum order
+        QHBoxLayout *policyRow = new QHBoxLayout;
+        weightingCombo = new QComboBox;
+        weightingCombo->addItem("Difficulty x importance");
+        weightingCombo->addItem("Log-scaled difficulty");
+        weightingCombo->addItem("Importance squared");
+        rotationCombo = new QComboBox;
+        rotationCombo->addItem("Topics in list order");
+        rotationCombo->addItem("Least recently studied first");
+        policyRow->addWidget(weightingCombo);
+        policyRow->addWidget(rotationCombo);
+        policyRow->addStretch();
+
+        // Clock times: sessions go between these hours, with a break after
+        // each, around the busy events of an imported calendar
+        QHBoxLayout *clockRow = new QHBoxLayout;
+        dayStartEdit = new QTimeEdit(QTime(DEFAULT_DAY_START_MINUTE / 60, DEFAULT_DAY_START_MINUTE % 60)); dayStartEdit->setDisplayFormat("HH:mm");
+        dayEndEdit = new QTimeEdit(QTime(DEFAULT_DAY_END_MINUTE / 60, DEFAULT_DAY_END_MINUTE % 60)); dayEndEdit->setDisplayFormat("HH:mm");
+        breakSpin = new QSpinBox; breakSpin->setRange(0,120); breakSpin->setSingleStep(5); breakSpin->setSuffix(" min break"); breakSpin->setValue(DEFAULT_BREAK_MINUTES);
+        QPushButton *busyBtn = new QPushButton("Busy Calendar...");
+        busyBtn->setToolTip("Import classes and other commitments from an iCalendar (.ics) file; sessions are placed around them.");
+        busyLabel = new QLabel;
+        clockRow->addWidget(dayStartEdit);
+        clockRow->addWidget(new QLabel("to"));
+        clockRow->addWidget(dayEndEdit);
+        clockRow->addWidget(breakSpin);
+        clockRow->addWidget(busyBtn);
+        clockRow->addWidget(busyLabel);
+        clockRow->addStretch();
+
+        controlsLayout->addRow("Start date:", startEdit);
         controlsLayout->addRow("Days:", daysSpin);
         controlsLayout->addRow("Hours per day:", hoursSpin);
+        controlsLayout->addRow("Study on:", weekdayRow);
+        controlsLayout->addRow("Longest session (h):", maxChunkSpin);
+        controlsLayout->addRow("Shortest session (h):", minSlotSpin);
+        controlsLayout->addRow("Reviews:", reviewRow);
+        controlsLayout->addRow("Weighting:", policyRow);
+        controlsLayout->addRow("Study hours:", clockRow);
         controlsBox->setLayout(controlsLayout);
 
         mainLayout->addWidget(controlsBox);
@@ -259,34 +500,120 @@ public:
         mainLayout->addLayout(filterLayout);
 
         // Subject table
-        subjectTable = new QTableWidget(0,4);
-        subjectTable->setHorizontalHeaderLabels({"Name","Difficulty","Importance","#Topics"});
+        subjectTable = new QTableWidget(0,5);
+        subjectTable->setHorizontalHeaderLabels({"Name","Difficulty","Importance","#Topics","Exam"});
         subjectTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
         subjectTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
         QPushButton *addSubjectBtn = new QPushButton("Add Subject");
         QPushButton *removeSubjectBtn = new QPushButton("Remove Selected");
+        QPushButton *importSyllabusBtn = new QPushButton("Import Syllabus...");
+        QPushButton *timelineBtn = new QPushButton("Timeline...");
+        undoBtn = new QPushButton("Undo");
+        redoBtn = new QPushButton("Redo");
+        undoBtn->setShortcut(QKeySequence::Undo);
+        redoBtn->setShortcut(QKeySequence::Redo);
 
         QHBoxLayout *subjectBtns = new QHBoxLayout;
         subjectBtns->addWidget(addSubjectBtn);
         subjectBtns->addWidget(removeSubjectBtn);
+        subjectBtns->addWidget(importSyllabusBtn);
+        subjectBtns->addWidget(timelineBtn);
         subjectBtns->addStretch();
+        subjectBtns->addWidget(undoBtn);
+        subjectBtns->addWidget(redoBtn);
 
         // Action buttons
         QPushButton *generateBtn = new QPushButton("Generate Schedule");
         QPushButton *saveBtn = new QPushButton("Save CSV");
         QPushButton *clearBtn = new QPushButton("Clear Schedule");
+        QPushButton *saveProfileBtn = new QPushButton("Save Profile");
+        QPushButton *openProfileBtn = new QPushButton("Open Profile");
+        QPushButton *whatIfBtn = new QPushButton("What-if...");
 
         QHBoxLayout *actionBtns = new QHBoxLayout;
         actionBtns->addWidget(generateBtn);
         actionBtns->addWidget(saveBtn);
         actionBtns->addWidget(clearBtn);
+        actionBtns->addWidget(saveProfileBtn);
+        actionBtns->addWidget(openProfileBtn);
+        actionBtns->addWidget(whatIfBtn);
         actionBtns->addStretch();
 
+        // Progress of a background generation; hidden while idle
+        progressBar = new QProgressBar;
+        progressBar->setMaximumWidth(200);
+        progressBar->hide();
+        actionBtns->addWidget(progressBar);
+        progressTimer = new QTimer(this);
+        progressTimer->setInterval(50);
+
+        // Search over the generated schedule; Enter moves to the next match
+        searchEdit = new QLineEdit;
+        searchEdit->setPlaceholderText("Subject or topic");
+        searchEdit->setClearButtonEnabled(true);
+        searchLabel = new QLabel;
+        QHBoxLayout *searchRow = new QHBoxLayout;
+        searchRow->addWidget(new QLabel("Search:"));
+        searchRow->addWidget(searchEdit);
+        searchRow->addWidget(searchLabel);
+
+        // Progress on the selected sessions goes to the journal; replanning
+        // keeps every day before today and redistributes what was missed
+        QPushButton *doneBtn = new QPushButton("Done");
+        QPushButton *partialBtn = new QPushButton("Partly Done...");
+        QPushButton *skippedBtn = new QPushButton("Skipped");
+        QPushButton *journalBtn = new QPushButton("Journal...");
+        QPushButton *replanBtn = new QPushButton("Replan from Today");
+        replanBtn->setToolTip("Plan the remaining days again, carrying missed study forward. "
+                              "Days before today, and days with recorded progress, stay as they are.");
+        journalLabel = new QLabel;
+        QHBoxLayout *progressRow = new QHBoxLayout;
+        progressRow->addWidget(new QLabel("Progress:"));
+        progressRow->addWidget(doneBtn);
+        progressRow->addWidget(partialBtn);
+        progressRow->addWidget(skippedBtn);
+        progressRow->addWidget(replanBtn);
+        progressRow->addWidget(journalBtn);
+        progressRow->addWidget(journalLabel);
+        progressRow->addStretch();
+
         // Schedule table
-        scheduleTable = new QTableWidget(0,4);
-        scheduleTable->setHorizontalHeaderLabels({"Day","Subject","Topic","Time"});
+        scheduleModel = new ScheduleTableModel(this);
+        scheduleTable = new QTableView;
+        scheduleTable->setModel(scheduleModel);
+        scheduleModel->setJournal(&journal);
         scheduleTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        // Fixed row heights let the view skip measuring rows it never shows
+        scheduleTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        scheduleTable->verticalHeader()->setDefaultSectionSize(scheduleTable->fontMetrics().height() + 8);
+
+        // Collapsible performance panel; refreshed only while expanded
+        statsBox = new QGroupBox("Performance");
+        statsBox->setCheckable(true);
+        statsBox->setChecked(false);
+        statsContent = new QWidget;
+        QVBoxLayout *statsLayout = new QVBoxLayout;
+        statsTable = new QTableWidget(0,7);
+        statsTable->setHorizontalHeaderLabels({"Probe","Calls","Last (ms)","Avg (ms)","Max (ms)","Last items","Last allocs"});
+        statsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        statsTable->setFixedHeight(statsTable->fontMetrics().height() * 12);
+        QPushButton *dumpStatsBtn = new QPushButton("Save JSON...");
+        QPushButton *resetStatsBtn = new QPushButton("Reset");
+        QHBoxLayout *statsBtns = new QHBoxLayout;
+        statsBtns->addWidget(dumpStatsBtn);
+        statsBtns->addWidget(resetStatsBtn);
+        statsBtns->addStretch();
+        statsLayout->addWidget(statsTable);
+        statsLayout->addLayout(statsBtns);
+        statsContent->setLayout(statsLayout);
+        statsContent->setVisible(false);
+        QVBoxLayout *statsBoxLayout = new QVBoxLayout;
+        statsBoxLayout->addWidget(statsContent);
+        statsBox->setLayout(statsBoxLayout);
+        statsTimer = new QTimer(this);
+        statsTimer->setInterval(500);
 
         // Layout assembly
         mainLayout->addWidget(new QLabel("Subjects"));
@@ -294,7 +621,10 @@ public:
         mainLayout->addLayout(subjectBtns);
         mainLayout->addLayout(actionBtns);
         mainLayout->addWidget(new QLabel("Generated Schedule"));
+        mainLayout->addLayout(searchRow);
         mainLayout->addWidget(scheduleTable);
+        mainLayout->addLayout(progressRow);
+        mainLayout->addWidget(statsBox);
 
         central->setLayout(mainLayout);
         setCentralWidget(central);
@@ -303,20 +633,67 @@ public:
 
         // Connections
         connect(addSubjectBtn, &QPushButton::clicked, this, &MainWindow::onAddSubject);
+        connect(importSyllabusBtn, &QPushButton::clicked, this, &MainWindow::onImportSyllabus);
         connect(removeSubjectBtn, &QPushButton::clicked, this, &MainWindow::onRemoveSubject);
+        connect(timelineBtn, &QPushButton::clicked, this, &MainWindow::onShowTimeline);
+        connect(subjectTable, &QTableWidget::cellDoubleClicked, this, &MainWindow::onSubjectDoubleClicked);
+        connect(searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchChanged);
+        connect(searchEdit, &QLineEdit::returnPressed, this, &MainWindow::onSearchNext);
+        connect(undoBtn, &QPushButton::clicked, this, &MainWindow::onUndo);
+        connect(redoBtn, &QPushButton::clicked, this, &MainWindow::onRedo);
+        connect(doneBtn, &QPushButton::clicked, this, &MainWindow::onMarkDone);
+        connect(partialBtn, &QPushButton::clicked, this, &MainWindow::onMarkPartial);
+        connect(skippedBtn, &QPushButton::clicked, this, &MainWindow::onMarkSkipped);
+        connect(journalBtn, &QPushButton::clicked, this, &MainWindow::onOpenJournal);
+        connect(replanBtn, &QPushButton::clicked, this, &MainWindow::onReplan);
         connect(generateBtn, &QPushButton::clicked, this, &MainWindow::onGenerate);
         connect(saveBtn, &QPushButton::clicked, this, &MainWindow::onSave);
         connect(clearBtn, &QPushButton::clicked, this, &MainWindow::onClearSchedule);
+        connect(saveProfileBtn, &QPushButton::clicked, this, &MainWindow::onSaveProfile);
+        connect(openProfileBtn, &QPushButton::clicked, this, &MainWindow::onOpenProfile);
+        connect(whatIfBtn, &QPushButton::clicked, this, &MainWindow::onWhatIf);
         connect(daysSpin, qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onDaysChanged);
+        connect(hoursSpin, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &MainWindow::cancelGeneration);
+        connect(maxChunkSpin, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &MainWindow::cancelGeneration);
+        connect(minSlotSpin, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &MainWindow::cancelGeneration);
+        connect(startEdit, &QDateEdit::dateChanged, this, &MainWindow::onStartDateChanged);
+        for (QCheckBox *check : weekdayChecks)
+            connect(check, &QCheckBox::toggled, this, &MainWindow::cancelGeneration);
+        connect(reviewCheck, &QCheckBox::toggled, reviewMinutesSpin, &QSpinBox::setEnabled);
+        connect(reviewCheck, &QCheckBox::toggled, reviewShareSpin, &QSpinBox::setEnabled);
+        connect(reviewCheck, &QCheckBox::toggled, this, &MainWindow::cancelGeneration);
+        connect(reviewMinutesSpin, qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::cancelGeneration);
+        connect(reviewShareSpin, qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::cancelGeneration);
+        connect(weightingCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::cancelGeneration);
+        connect(rotationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::cancelGeneration);
+        // Clock times only depend on the schedule as it is, so they are placed again at once
+        connect(dayStartEdit, &QTimeEdit::timeChanged, this, &MainWindow::updateClockTimes);
+        connect(dayEndEdit, &QTimeEdit::timeChanged, this, &MainWindow::updateClockTimes);
+        connect(breakSpin, qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::updateClockTimes);
+        connect(busyBtn, &QPushButton::clicked, this, &MainWindow::onImportBusyCalendar);
+        connect(progressTimer, &QTimer::timeout, this, &MainWindow::onProgressTick);
+        connect(statsBox, &QGroupBox::toggled, this, &MainWindow::onStatsToggled);
+        connect(statsTimer, &QTimer::timeout, this, &MainWindow::refreshStatsPanel);
+        connect(dumpStatsBtn, &QPushButton::clicked, this, &MainWindow::onDumpStats);
+        connect(resetStatsBtn, &QPushButton::clicked, this, &MainWindow::onResetStats);
+
+        // Results are produced on the generator's thread and delivered here
+        // through the event loop, so the window keeps repainting meanwhile.
+        qRegisterMetaType<std::shared_ptr<GenerationResult>>();
+        connect(this, &MainWindow::scheduleReady, this, &MainWindow::onScheduleReady, Qt::QueuedConnection);
         connect(filterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onFilterChanged);
 
         currentFilter = HighlightFilter::All;
         updateHighlightSpinRange();
+        recordEdit("Start");
     }
 
+signals:
+    void scheduleReady(std::shared_ptr<GenerationResult> result);
+
 private slots:
     void onAddSubject() {
-        AddSubjectDialog dlg(this);
+        AddSubjectDialog dlg(startDate, this);
         if (dlg.exec() == QDialog::Accepted) {
             Subject s;
             s.setName(dlg.getName());
@@ -324,16 +701,28 @@ private slots:
             s.setImportance(dlg.getImportance());
             vector<string> topics = dlg.getTopics();
             s.setTopicsList(topics);
+            s.setExamDay(dlg.getExamDay());
+            cancelGeneration();
             subjects.push_back(s);
+            scheduleMatchesSubjects = false;
             refreshSubjectTable();
+            recordEdit("Add " + QString::fromStdString(s.getName()));
         }
     }
 
     void onRemoveSubject() {
         int r = subjectTable->currentRow();
         if (r >= 0 && r < (int)subjects.size()) {
+            cancelGeneration();
+            QString label = "Remove " + QString::fromStdString(subjects[r].getName());
+            clampedExams.erase(subjects[r].getId());
             subjects.erase(subjects.begin() + r);
+            // Drop the row itself, so the rows below keep their contents
+            subjectTable->removeRow(r);
+            subjectRows.erase(subjectRows.begin() + r);
+            scheduleMatchesSubjects = false;
             refreshSubjectTable();
+            recordEdit(label);
         }
     }
 
@@ -342,19 +731,132 @@ private slots:
             QMessageBox::warning(this, "No subjects", "Please add at least one subject.");
             return;
         }
-        int days = daysSpin->value();
-        double hoursPerDay = hoursSpin->value();
+        PlanInput plan = currentPlan();
+        int days = plan.days;
 
-        ScheduleGenerator gen(days, hoursPerDay);
-        vector<Subject> copySubs = subjects;
-        gen.setSubjects(copySubs);
-        gen.generateSchedule();
+        // Supersedes a generation that is still running
+        background.start(move(plan));
 
-        lastSchedule = gen.getSchedule();
+        progressBar->setRange(0, days);
+        progressBar->setValue(0);
+        progressBar->show();
+        progressTimer->start();
+    }
 
-        analyzeHighlights();
+    void onScheduleReady(std::shared_ptr<GenerationResult> result) {
+        // A result can still be queued after the inputs changed
+        if (!background.isCurrent(result->ticket)) return;
+        stopProgress();
+
+        lastSchedule = move(result->schedule);
+        highlights = move(result->highlights);
+        scheduleIndex = move(result->index);
+        scheduleMatchesSubjects = true;
+
+        populateScheduleTable(lastSchedule);
+        updateSearch();
+        refreshSubjectTable();
+        reportShortfalls(result->shortfalls);
+        recordEdit("Generate");
+    }
+
+    void onStartDateChanged(const QDate &date) {
+        cancelGeneration();
+        // Keep exam dates fixed on the calendar. Exams that now fall on or
+        // before the start date move to day 1 (no study time), those past
+        // the longest plan to its last day; their real date is kept, so
+        // moving the start back puts them where they were.
+        for (Subject &s : subjects) {
+            if (!s.hasExam()) continue;
+            qint64 exam = examDate(s).toJulianDay();
+            qint64 day = exam - date.toJulianDay() + 1;
+            s.setExamDay((int)clamp<qint64>(day, 1, MAX_DAYS));
+            if (s.getExamDay() != day) clampedExams[s.getId()] = exam;
+            else clampedExams.erase(s.getId());
+        }
+        startDate = date;
+        scheduleMatchesSubjects = false;
+        refreshSubjectTable();
+        // Busy events are fixed on the calendar too
+        if (!busyPath.isEmpty()) loadBusyCalendar();
+        recordEdit("Change Start Date");
+    }
+
+    void onImportBusyCalendar() {
+        QString fname = QFileDialog::getOpenFileName(this, "Busy Calendar", QString(),
+                                                     "iCalendar (*.ics);;All Files (*)");
+        if (fname.isEmpty()) return;
+        busyPath = fname;
+        loadBusyCalendar();
+    }
+
+    // Places every session of the shown schedule at a clock time.
+    void updateClockTimes() {
+        if (lastSchedule.empty()) {
+            clockStarts.clear();
+            scheduleModel->setClockTimes(clockStarts);
+            return;
+        }
+        size_t placed = clockPlacer.place(lastSchedule, clockSettings(), clockStarts);
+        scheduleModel->setClockTimes(clockStarts);
+        if (placed < lastSchedule.slotCount())
+            statusBar()->showMessage(QString("%1 of %2 sessions do not fit into the study hours")
+                                         .arg((qulonglong)(lastSchedule.slotCount() - placed))
+                                         .arg((qulonglong)lastSchedule.slotCount()));
+    }
+
+    void onProgressTick() {
+        progressBar->setValue(background.daysDone());
+    }
+
+    void cancelGeneration() {
+        background.cancel();
+        stopProgress();
+    }
+
+    void onMarkDone() { markSelected(ProgressStatus::Done); }
+    void onMarkPartial() { markSelected(ProgressStatus::Partial); }
+    void onMarkSkipped() { markSelected(ProgressStatus::Skipped); }
+
+    void onOpenJournal() {
+        QString fname = QFileDialog::getSaveFileName(this, "Progress Journal", "study_progress.adxj", "Adexa Journals (*.adxj)",
+                                                     nullptr, QFileDialog::DontConfirmOverwrite);
+        if (fname.isEmpty()) return;
+        string error;
+        if (!journal.open(QFile::encodeName(fname).toStdString(), error))
+            QMessageBox::warning(this, "Journal", QString::fromStdString(error));
+        scheduleModel->setJournal(&journal);
+        updateJournalLabel();
+    }
+
+    void onReplan() {
+        if (lastSchedule.empty() || !scheduleMatchesSubjects) {
+            QMessageBox::information(this, "Replan", "Generate a schedule for the current subjects first.");
+            return;
+        }
+        int today = (int)max<qint64>(0, startDate.daysTo(QDate::currentDate()));
+        for (const ProgressRecord &r : journal.records()) today = max(today, (int)r.day + 1);
+        if (today >= lastSchedule.dayCount()) {
+            QMessageBox::information(this, "Replan", "The plan has no days left to replan.");
+            return;
+        }
+
+        cancelGeneration();
+        Schedule replanned;
+        string error;
+        if (!replanner.replan(currentPlan(), lastSchedule, journal, today, replanned, error)) {
+            QMessageBox::warning(this, "Replan", QString::fromStdString(error));
+            return;
+        }
+        lastSchedule = move(replanned);
+        analyzeSchedule();
         populateScheduleTable(lastSchedule);
+        updateSearch();
         refreshSubjectTable();
+        recordEdit("Replan");
+        statusBar()->showMessage(QString("Replanned from %1; %2 of missed study carried forward")
+                                     .arg(startDate.addDays(today).toString("yyyy-MM-dd"))
+                                     .arg(QString::fromStdString(formatTime((int)replanner.totalDebtMinutes()))));
     }
 
     void onSave() {
@@ -367,16 +869,193 @@ private slots:
             QMessageBox::information(this, "Saved", "Schedule saved to " + fname);
     }
 
+    void onStatsToggled(bool expanded) {
+        statsContent->setVisible(expanded);
+        if (expanded) {
+            refreshStatsPanel();
+            statsTimer->start();
+        } else {
+            statsTimer->stop();
+        }
+    }
+
+    void refreshStatsPanel() {
+        PerfSnapshot snap = perfSnapshot();
+        if (!snap.enabled) {
+            statsTable->setRowCount(1);
+            statsTable->setItem(0, 0, new QTableWidgetItem("Built without ADEXA_INSTRUMENT"));
+            return;
+        }
+        statsTable->setRowCount(PERF_PROBE_COUNT);
+        for (int i = 0; i < PERF_PROBE_COUNT; ++i) {
+            const PerfProbeStats &p = snap.probes[i];
+            double avgMs = p.calls ? p.totalNs / 1e6 / p.calls : 0.0;
+            QString cells[7] = {
+                QString::fromLatin1(p.name),
+                QString::number(p.calls),
+                QString::number(p.lastNs / 1e6, 'f', 3),
+                QString::number(avgMs, 'f', 3),
+                QString::number(p.maxNs / 1e6, 'f', 3),
+                QString("%1 %2").arg(p.lastItems).arg(QString::fromLatin1(p.itemName)),
+                QString::number(p.lastAllocations),
+            };
+            for (int c = 0; c < 7; ++c) statsTable->setItem(i, c, new QTableWidgetItem(cells[c]));
+        }
+    }
+
+    void onDumpStats() {
+        QString fname = QFileDialog::getSaveFileName(this, "Save Performance Stats", "adexa_stats.json", "JSON Files (*.json)");
+        if (fname.isEmpty()) return;
+        string error;
+        if (!writePerfJson(QFile::encodeName(fname).toStdString(), error))
+            QMessageBox::warning(this, "Save failed", QString::fromStdString(error));
+    }
+
+    void onResetStats() {
+        resetPerfStats();
+        refreshStatsPanel();
+    }
+
     void onClearSchedule() {
-        scheduleTable->setRowCount(0);
+        cancelGeneration();
+        scheduleModel->clear();
+        clockStarts.clear();
         subjectTable->setRowCount(0);
+        subjectRows.clear();
         subjects.clear();
+        clampedExams.clear();
         lastSchedule.clear();
-        highlightReasons.clear();
-        subjectHighlightReasons.clear();
+        highlights.clear();
+        scheduleIndex.clear();
+        journal.close();
+        updateJournalLabel();
+        updateSearch();
+        statusBar()->clearMessage();
+        recordEdit("Clear");
+    }
+
+    void onSaveProfile() {
+        QString fname = QFileDialog::getSaveFileName(this, "Save Profile", "study_profile.adxp", "Adexa Profiles (*.adxp)");
+        if (fname.isEmpty()) return;
+
+        PlanInput plan = currentPlan();
+
+        // The schedule is only stored while it still belongs to this subject list
+        string error;
+        const Schedule *schedule = scheduleMatchesSubjects && !lastSchedule.empty() ? &lastSchedule : nullptr;
+        if (!saveProfile(QFile::encodeName(fname).toStdString(), plan, schedule, error))
+            QMessageBox::warning(this, "Save failed", QString::fromStdString(error));
+        else
+            QMessageBox::information(this, "Saved", "Profile saved to " + fname);
+    }
+
+    void onImportSyllabus() {
+        QString fname = QFileDialog::getOpenFileName(this, "Import Syllabus", QString(),
+                                                     "Syllabus (*.csv *.txt);;All Files (*)");
+        if (fname.isEmpty()) return;
+
+        cancelGeneration();
+        string error;
+        SyllabusImportStats stats;
+        if (!importSyllabus(QFile::encodeName(fname).toStdString(), subjects, error, SyllabusFormat::Auto, &stats)) {
+            QMessageBox::warning(this, "Import failed", QString::fromStdString(error));
+            return;
+        }
+        scheduleMatchesSubjects = false;
+        refreshSubjectTable();
+        recordEdit("Import Syllabus");
+        statusBar()->showMessage(QString("Imported %1 topics: %2 new subjects, %3 extended")
+                                     .arg((qulonglong)stats.topics)
+                                     .arg((qulonglong)stats.subjectsAdded)
+                                     .arg((qulonglong)stats.subjectsExtended));
+    }
+
+    void onOpenProfile() {
+        QString fname = QFileDialog::getOpenFileName(this, "Open Profile", QString(), "Adexa Profiles (*.adxp)");
+        if (fname.isEmpty()) return;
+
+        MappedProfile profile;
+        string error;
+        if (!profile.open(QFile::encodeName(fname).toStdString(), error)) {
+            QMessageBox::warning(this, "Open failed", QString::fromStdString(error));
+            return;
+        }
+
+        cancelGeneration();
+        PlanInput plan = profile.toPlan();
+        subjects = plan.subjects;
+        clampedExams.clear();
+        daysSpin->setValue(plan.days);
+        hoursSpin->setValue(plan.minutesPerDay / 60.0);
+        maxChunkSpin->setValue(plan.maxChunkMinutes / 60.0);
+        minSlotSpin->setValue(plan.minSlotMinutes / 60.0);
+        reviewCheck->setChecked(plan.reviewMinutes > 0);
+        if (plan.reviewMinutes > 0) reviewMinutesSpin->setValue(plan.reviewMinutes);
+        reviewShareSpin->setValue(plan.reviewSharePercent);
+        weightingCombo->setCurrentIndex((int)plan.policies.weighting);
+        rotationCombo->setCurrentIndex((int)plan.policies.rotation);
+        lastSchedule = profile.toSchedule();
+        scheduleMatchesSubjects = true;
+        // The journal tracks the old plan's sessions
+        journal.close();
+        updateJournalLabel();
+
+        analyzeSchedule();
+        populateScheduleTable(lastSchedule);
+        updateSearch();
+        refreshSubjectTable();
+        recordEdit("Open Profile");
+    }
+
+    void onUndo() {
+        if (!history.canUndo()) return;
+        QString label = QString::fromStdString(history.undoLabel());
+        const EditState &from = history.current();
+        showEdit(history.undo(), from);
+        statusBar()->showMessage("Undid " + label, 3000);
+    }
+
+    void onRedo() {
+        if (!history.canRedo()) return;
+        QString label = QString::fromStdString(history.redoLabel());
+        const EditState &from = history.current();
+        showEdit(history.redo(), from);
+        statusBar()->showMessage("Redid " + label, 3000);
+    }
+
+    void onSearchChanged() {
+        updateSearch();
+        if (!searchHits.empty()) showHit(0);
+    }
+
+    void onSearchNext() {
+        if (searchHits.empty()) return;
+        currentHit = (currentHit + 1) % searchHits.size();
+        showHit(currentHit);
+    }
+
+    void onShowTimeline() {
+        showTimeline(subjectTable->currentRow());
+    }
+
+    void onSubjectDoubleClicked(int row, int column) {
+        showTimeline(row);
+    }
+
+    void onWhatIf() {
+        if (subjects.empty()) {
+            QMessageBox::warning(this, "No subjects", "Add at least one subject before exploring variants.");
+            return;
+        }
+        WhatIfDialog dlg(currentPlan(), this);
+        if (dlg.exec() == QDialog::Accepted) {
+            daysSpin->setValue(dlg.getDays());
+            hoursSpin->setValue(dlg.getMinutesPerDay() / 60.0);
+        }
     }
 
     void onDaysChanged(int newDays) {
+        cancelGeneration();
         updateHighlightSpinRange();
     }
 
@@ -387,278 +1066,363 @@ private slots:
             case 2: currentFilter = HighlightFilter::TopicsOnly; break;
             case 3: currentFilter = HighlightFilter::HoursOnly; break;
         }
-        if (!lastSchedule.empty()) {
-            populateScheduleTable(lastSchedule);
+        scheduleModel->setFilter(currentFilter);
+        if (!lastSchedule.empty())
             refreshSubjectTable();
-        }
     }
 
 private:
-    // Highlight reasons enum
-    enum HighlightReason { Difficulty, Topics, Hours };
-
-    enum class HighlightFilter {
-        All,
-        DifficultyOnly,
-        TopicsOnly,
-        HoursOnly
-    };
-
     HighlightFilter currentFilter;
 
     QSpinBox *daysSpin;
     QDoubleSpinBox *hoursSpin;
+    QDoubleSpinBox *maxChunkSpin;
+    QDoubleSpinBox *minSlotSpin;
+    QDateEdit *startEdit;
+    QCheckBox *weekdayChecks[7];
+    QCheckBox *reviewCheck;
+    QSpinBox *reviewMinutesSpin;
+    QSpinBox *reviewShareSpin;
+    QComboBox *weightingCombo;
+    QComboBox *rotationCombo;
+    QTimeEdit *dayStartEdit;
+    QTimeEdit *dayEndEdit;
+    QSpinBox *breakSpin;
+    QLabel *busyLabel;
+    QDate startDate;
+    // Real exam dates of subjects whose exam day is clamped after a start
+    // date change, by Subject id, so later edits of the subject keep them.
+    // Entries go when the exam fits the plan again or the subject goes.
+    unordered_map<uint64_t, qint64> clampedExams;
     QTableWidget *subjectTable;
-    QTableWidget *scheduleTable;
+    QTableView *scheduleTable;
+    QGroupBox *statsBox;
+    QWidget *statsContent;
+    QTableWidget *statsTable;
+    QTimer *statsTimer;
+    ScheduleTableModel *scheduleModel;
     QComboBox *filterCombo;
+    QProgressBar *progressBar;
+    QTimer *progressTimer;
+    QPushButton *undoBtn;
+    QPushButton *redoBtn;
+    QLineEdit *searchEdit;
+    QLabel *searchLabel;
+    QLabel *journalLabel;
 
     vector<Subject> subjects;
-    vector<vector<Task>> lastSchedule;
+    Schedule lastSchedule;
+
+    // What each subject table row shows; revisions start at 1, so a
+    // default key never matches.
+    struct SubjectRowKey {
+        uint64_t revision = 0;
+        HighlightMask highlight = 0;
+        qint64 examDate = 0; // Julian day, 0 without an exam
+        bool operator==(const SubjectRowKey &o) const {
+            return revision == o.revision && highlight == o.highlight && examDate == o.examDate;
+        }
+    };
+    vector<SubjectRowKey> subjectRows;
+    bool scheduleMatchesSubjects = false; // lastSchedule's subject indices refer to subjects
+
+    // Highlight reason masks per day and per subject index
+    HighlightAnalysis highlights;
+
+    // Subject, day and topic postings of lastSchedule, for search and timelines
+    ScheduleIndex scheduleIndex;
+    static constexpr size_t MAX_MARKED_MATCHES = 10000;
+    vector<uint32_t> searchHits; // marked rows, ascending
+    size_t currentHit = 0;
+
+    // Done, partly done and skipped sessions of lastSchedule, appended to a file once one is chosen
+    ProgressJournal journal;
+    Replanner replanner;
+
+    // Busy periods of the imported calendar from startDate on, and the
+    // clock time of every session of lastSchedule
+    QString busyPath;
+    ClockPlacer clockPlacer;
+    vector<uint16_t> clockStarts;
+
+    // Subjects, schedule and start date after each edit; unchanged parts are shared between steps
+    EditHistory history;
+
+    // Declared last: destroyed first, so its thread is joined while the window is intact
+    BackgroundGenerator background{[this](std::shared_ptr<GenerationResult> result) {
+        emit scheduleReady(move(result));
+    }};
+
+    QDate examDate(const Subject &s) const {
+        auto it = clampedExams.find(s.getId());
+        return it != clampedExams.end() ? QDate::fromJulianDay(it->second) : startDate.addDays(s.getExamDay() - 1);
+    }
 
-    // Highlight data structures
-    vector<set<HighlightReason>> highlightReasons; // per day
-    vector<set<HighlightReason>> subjectHighlightReasons; // per subject index
+    PlanInput currentPlan() const {
+        PlanInput plan;
+        plan.days = daysSpin->value();
+        plan.minutesPerDay = hoursToMinutes(hoursSpin->value());
+        plan.maxChunkMinutes = hoursToMinutes(maxChunkSpin->value());
+        plan.minSlotMinutes = hoursToMinutes(minSlotSpin->value());
+        plan.reviewMinutes = reviewCheck->isChecked() ? reviewMinutesSpin->value() : 0;
+        plan.reviewSharePercent = reviewShareSpin->value();
+        plan.policies.weighting = (WeightingPolicy)weightingCombo->currentIndex();
+        plan.policies.rotation = (RotationPolicy)rotationCombo->currentIndex();
+        for (int d = 0; d < plan.days; ++d) {
+            if (!weekdayChecks[startDate.addDays(d).dayOfWeek() - 1]->isChecked())
+                plan.availability.push_back(DayAvailability{d, 0});
+        }
+        plan.subjects = subjects;
+        return plan;
+    }
 
-    void updateHighlightSpinRange() {
-        int d = daysSpin->value();
+    void reportShortfalls(const vector<DeadlineShortfall> &shortfalls) {
+        if (shortfalls.empty()) {
+            statusBar()->clearMessage();
+            return;
+        }
+        QStringList parts;
+        for (const DeadlineShortfall &s : shortfalls) {
+            parts << QString("%1 (%2 of %3)")
+                         .arg(QString::fromStdString(subjects[s.subject].getName()))
+                         .arg(QString::fromStdString(formatTime((int)s.plannedMinutes)))
+                         .arg(QString::fromStdString(formatTime((int)s.wantedMinutes)));
+        }
+        statusBar()->showMessage("Exams leave less time than planned for: " + parts.join(", "));
     }
 
-    QString formatTime(double hours) const {
-        int h = (int)hours;
-        int m = (int)((hours - h) * 60 + 0.5);
-        if (h == 0 && m > 0)
-            return QString("%1 min").arg(m);
-        if (m == 0)
-            return QString("%1h").arg(h);
-        return QString("%1h %2m").arg(h).arg(m, 2, 10, QChar('0'));
-    }
-
-    // Filter reasons based on current filter
-    set<HighlightReason> filteredReasons(const set<HighlightReason>& reasons) const {
-        switch (currentFilter) {
-            case HighlightFilter::All:
-                return reasons;
-            case HighlightFilter::DifficultyOnly:
-                return reasons.count(Difficulty) ? set<HighlightReason>{Difficulty} : set<HighlightReason>{};
-            case HighlightFilter::TopicsOnly:
-                return reasons.count(Topics) ? set<HighlightReason>{Topics} : set<HighlightReason>{};
-            case HighlightFilter::HoursOnly:
-                return reasons.count(Hours) ? set<HighlightReason>{Hours} : set<HighlightReason>{};
-        }
-        return reasons;
-    }
-
-    void analyzeHighlights() {
-        int days = (int)lastSchedule.size();
-        highlightReasons.clear();
-        highlightReasons.resize(days);
-
-        // Calculate sums for each day
-        vector<int> difficultySum(days, 0);
-        vector<int> topicCount(days, 0);
-        vector<double> hoursSum(days, 0.0);
-
-        for (int d = 0; d < days; ++d) {
-            for (const Task &task : lastSchedule[d]) {
-                // Find subject difficulty
-                auto it = find_if(subjects.begin(), subjects.end(), [&](const Subject &s){ return s.getName() == task.subject; });
-                int diff = (it != subjects.end()) ? it->getDifficulty() : 1;
-                difficultySum[d] += diff;
-                topicCount[d]++;
-                hoursSum[d] += task.hours;
+    void recordEdit(const QString &label) {
+        history.record(label.toStdString(), subjects, lastSchedule, scheduleMatchesSubjects, startDate.toJulianDay());
+        updateUndoButtons();
+    }
+
+    void updateUndoButtons() {
+        undoBtn->setEnabled(history.canUndo());
+        redoBtn->setEnabled(history.canRedo());
+        undoBtn->setToolTip(history.canUndo() ? "Undo " + QString::fromStdString(history.undoLabel()) : QString());
+        redoBtn->setToolTip(history.canRedo() ? "Redo " + QString::fromStdString(history.redoLabel()) : QString());
+    }
+
+    // Shows a recorded state; whatever it shares with from is left as it is.
+    void showEdit(const EditState &to, const EditState &from) {
+        cancelGeneration();
+        if (!to.subjects.sameAs(from.subjects))
+            restoreSubjects(to, from, subjects);
+        if (to.calendarStart != from.calendarStart) {
+            startDate = QDate::fromJulianDay(to.calendarStart);
+            // The exam days are restored as they were; do not shift them again
+            QSignalBlocker blocker(startEdit);
+            startEdit->setDate(startDate);
+            if (!busyPath.isEmpty()) loadBusyCalendar();
+        }
+        if (to.schedule != from.schedule) {
+            restoreSchedule(*to.schedule, *from.schedule, lastSchedule);
+            if (lastSchedule.empty()) {
+                scheduleModel->clear();
+                clockStarts.clear();
+                highlights.clear();
+                scheduleIndex.clear();
+            } else {
+                analyzeSchedule();
+                populateScheduleTable(lastSchedule);
             }
+            updateSearch();
+        }
+        scheduleMatchesSubjects = to.scheduleMatchesSubjects;
+        refreshSubjectTable();
+        updateUndoButtons();
+    }
+
+    void showTimeline(int row) {
+        if (row < 0 || row >= (int)subjects.size()) {
+            QMessageBox::information(this, "Timeline", "Select a subject first.");
+            return;
         }
+        if (lastSchedule.empty() || !scheduleMatchesSubjects) {
+            QMessageBox::information(this, "Timeline", "Generate a schedule for the current subjects first.");
+            return;
+        }
+        TimelineDialog dlg(lastSchedule, scheduleIndex, (uint32_t)row, startDate, this);
+        dlg.exec();
+    }
 
-        // Find max values
-        int maxDifficulty = *max_element(difficultySum.begin(), difficultySum.end());
-        int maxTopics = *max_element(topicCount.begin(), topicCount.end());
-        double maxHours = *max_element(hoursSum.begin(), hoursSum.end());
-
-        // Mark highlight reasons per day
-        for (int d = 0; d < days; ++d) {
-            if (difficultySum[d] == maxDifficulty) highlightReasons[d].insert(Difficulty);
-            if (topicCount[d] == maxTopics) highlightReasons[d].insert(Topics);
-            if (abs(hoursSum[d] - maxHours) < EPSILON) highlightReasons[d].insert(Hours);
-        }
-
-        // Analyze subject highlights: for each subject, find days where it appears and reasons that day has
-        subjectHighlightReasons.clear();
-        subjectHighlightReasons.resize(subjects.size());
-
-        for (size_t si = 0; si < subjects.size(); ++si) {
-            const string &subjName = subjects[si].getName();
-            set<HighlightReason> subjReasons;
-            for (int d = 0; d < days; ++d) {
-                bool subjectOnDay = false;
-                for (const Task &task : lastSchedule[d]) {
-                    if (task.subject == subjName) {
-                        subjectOnDay = true;
-                        break;
-                    }
-                }
-                if (subjectOnDay) {
-                    // Add filtered reasons of that day to subject reasons
-                    for (HighlightReason r : highlightReasons[d])
-                        subjReasons.insert(r);
-                }
+    // Appends a record for every selected session, asking for a journal
+    // file first when none is open.
+    void markSelected(ProgressStatus status) {
+        if (lastSchedule.empty() || !scheduleMatchesSubjects) {
+            QMessageBox::information(this, "Progress", "Generate a schedule for the current subjects first.");
+            return;
+        }
+        QModelIndexList rows = scheduleTable->selectionModel()->selectedRows();
+        if (rows.isEmpty()) {
+            QMessageBox::information(this, "Progress", "Select one or more sessions in the schedule first.");
+            return;
+        }
+        if (!journal.isOpen()) {
+            onOpenJournal();
+            if (!journal.isOpen()) return;
+        }
+        int minutes = 0;
+        if (status == ProgressStatus::Partial) {
+            bool ok = false;
+            minutes = QInputDialog::getInt(this, "Partly Done", "Minutes studied:", 0, 0, 24 * 60, 5, &ok);
+            if (!ok) return;
+        }
+
+        string error;
+        for (const QModelIndex &index : rows) {
+            uint32_t row = (uint32_t)index.row();
+            const ScheduleSlot &t = lastSchedule.allSlots()[row];
+            int d = scheduleIndex.dayOfSlot(row);
+            uint16_t done = status == ProgressStatus::Done ? t.minutes
+                          : status == ProgressStatus::Partial ? (uint16_t)min<int>(minutes, t.minutes) : 0;
+            ProgressRecord r{(uint32_t)d, row - lastSchedule.dayOffset(d), t.topic, done, status, 0};
+            if (!journal.append(r, error)) {
+                QMessageBox::warning(this, "Progress", QString::fromStdString(error));
+                break;
             }
-            subjectHighlightReasons[si] = subjReasons;
+            scheduleModel->progressChanged((int)row);
         }
+        updateJournalLabel();
     }
 
-    QColor colorForReason(const set<HighlightReason> &reasons) const {
-        // We use bright strong colors, handle overlapping combinations by combining colors or using predefined ones
-        bool diff = reasons.count(Difficulty);
-        bool top = reasons.count(Topics);
-        bool hrs = reasons.count(Hours);
+    ClockSettings clockSettings() const {
+        ClockSettings settings;
+        settings.dayStartMinute = dayStartEdit->time().hour() * 60 + dayStartEdit->time().minute();
+        settings.dayEndMinute = dayEndEdit->time().hour() * 60 + dayEndEdit->time().minute();
+        settings.breakMinutes = breakSpin->value();
+        return settings;
+    }
 
-        if (diff && top && hrs) return QColor("#800080"); // Purple all combined
-        if (diff && top) return QColor("#FF4500"); // OrangeRed
-        if (diff && hrs) return QColor("#FF8C00"); // DarkOrange
-        if (top && hrs) return QColor("#1E90FF"); // DodgerBlue
+    // Reads busyPath for every day a plan can have from startDate, then places the sessions again.
+    void loadBusyCalendar() {
+        CivilDate start{startDate.year(), startDate.month(), startDate.day()};
+        vector<TimeInterval> busy;
+        CalendarImportStats stats;
+        string error;
+        if (!readCalendar(QFile::encodeName(busyPath).toStdString(), start, MAX_DAYS, busy, error, &stats)) {
+            QMessageBox::warning(this, "Busy Calendar", QString::fromStdString(error));
+            busyPath.clear();
+        }
+        clockPlacer.setBusy(busy);
+        if (busyPath.isEmpty())
+            busyLabel->clear();
+        else
+            busyLabel->setText(QString("%1 busy blocks from %2 events%3")
+                                   .arg((qulonglong)clockPlacer.busy().size())
+                                   .arg((qulonglong)stats.events)
+                                   .arg(stats.unsupported ? QString(", %1 not understood").arg((qulonglong)stats.unsupported)
+                                                          : QString()));
+        updateClockTimes();
+    }
 
-        if (diff) return QColor("#FF0000"); // Red
-        if (top) return QColor("#FFA500"); // Orange
-        if (hrs) return QColor("#0000FF"); // Blue
+    void updateJournalLabel() {
+        if (!journal.isOpen())
+            journalLabel->clear();
+        else
+            journalLabel->setText(QString("%1 records").arg((qulonglong)journal.size()));
+    }
 
-        return QColor(); // no color
+    void stopProgress() {
+        progressTimer->stop();
+        progressBar->hide();
     }
 
-    QString reasonsText(const set<HighlightReason> &reasons) const {
-        QStringList parts;
-        for (HighlightReason r : reasons) {
-            switch (r) {
-                case Difficulty: parts << "Highest Difficulty sum"; break;
-                case Topics: parts << "Most Topics covered"; break;
-                case Hours: parts << "Most Study Hours"; break;
-            }
-        }
-        return parts.join(", ");
-    }
-
-    void populateScheduleTable(const vector<vector<Task>> &schedule) {
-        scheduleTable->clearContents();
-        scheduleTable->setRowCount(0);
-        int row = 0;
-        for (size_t d = 0; d < schedule.size(); ++d) {
-            for (const Task &t : schedule[d]) {
-                scheduleTable->insertRow(row);
-                QTableWidgetItem *dayItem = new QTableWidgetItem(QString::number(d+1));
-                QTableWidgetItem *subjectItem = new QTableWidgetItem(QString::fromStdString(t.subject));
-                QTableWidgetItem *topicItem = new QTableWidgetItem(QString::fromStdString(t.topic));
-                QTableWidgetItem *timeItem = new QTableWidgetItem(formatTime(t.hours));
-
-                // Set contrasting text colors
-                QBrush bgBrush = QBrush(Qt::white);
-
-                // Highlight day row background by combined reason filter
-                set<HighlightReason> reasons = highlightReasons[d];
-                set<HighlightReason> filtered = filteredReasons(reasons);
-
-                QColor bgColor = colorForReason(filtered);
-                if (bgColor.isValid()) {
-                    bgBrush = QBrush(bgColor);
-                    // set text color contrast: if bg is dark, text white else black
-                    QColor textColor = (bgColor.lightness() < 128) ? QColor(Qt::white) : QColor(Qt::black);
-                    dayItem->setForeground(textColor);
-                    subjectItem->setForeground(textColor);
-                    topicItem->setForeground(textColor);
-                    timeItem->setForeground(textColor);
-                } else {
-                    QColor textColor = QColor("#001f3f"); // dark navy for text
-                    dayItem->setForeground(textColor);
-                    subjectItem->setForeground(textColor);
-                    topicItem->setForeground(textColor);
-                    timeItem->setForeground(textColor);
-                }
-                dayItem->setBackground(bgBrush);
-                subjectItem->setBackground(bgBrush);
-                topicItem->setBackground(bgBrush);
-                timeItem->setBackground(bgBrush);
-
-                // Tooltip for day reasons
-                if (!filtered.empty()) {
-                    QString tooltip = QString("Day %1 highlight reason(s): %2").arg(d+1).arg(reasonsText(filtered));
-                    dayItem->setToolTip(tooltip);
-                }
+    void updateHighlightSpinRange() {
+        int d = daysSpin->value();
+    }
 
-                scheduleTable->setItem(row, 0, dayItem);
-                scheduleTable->setItem(row, 1, subjectItem);
-                scheduleTable->setItem(row, 2, topicItem);
-                scheduleTable->setItem(row, 3, timeItem);
-                ++row;
-            }
+    // Highlights and index for a schedule that did not come from the
+    // background generator, which builds both itself.
+    void analyzeSchedule() {
+        highlights.analyze(lastSchedule, subjects.size());
+        scheduleIndex.build(lastSchedule);
+    }
+
+    // Marks the matches of the search text in the schedule table.
+    void updateSearch() {
+        string query = searchEdit->text().trimmed().toStdString();
+        size_t total = query.empty() ? 0 : scheduleIndex.search(query, searchHits, MAX_MARKED_MATCHES);
+        if (query.empty()) searchHits.clear();
+        currentHit = 0;
+        scheduleModel->setMatches(searchHits);
+        if (query.empty())
+            searchLabel->clear();
+        else if (total > searchHits.size())
+            searchLabel->setText(QString("%1 matches, first %2 marked").arg(total).arg(searchHits.size()));
+        else
+            searchLabel->setText(QString("%1 matches").arg(total));
+    }
+
+    void showHit(size_t i) {
+        int row = (int)searchHits[i];
+        scheduleTable->scrollTo(scheduleModel->index(row, 0), QAbstractItemView::PositionAtCenter);
+        scheduleTable->selectRow(row);
+    }
+
+    void populateScheduleTable(const Schedule &schedule) {
+        {
+            PerfScope perf(PerfProbe::Populate);
+            scheduleModel->setSchedule(schedule, highlights.allDayMasks());
+            perf.addItems(schedule.slotCount());
         }
+        updateClockTimes();
     }
 
+    // Rewrites only the rows whose subject, highlight or exam date changed
+    // since they were last shown.
     void refreshSubjectTable() {
-        subjectTable->clearContents();
+        PerfScope perf(PerfProbe::RefreshSubjects);
         subjectTable->setRowCount((int)subjects.size());
+        subjectRows.resize(subjects.size());
+        size_t rewritten = 0;
         for (size_t i = 0; i < subjects.size(); ++i) {
             const Subject &s = subjects[i];
-            QTableWidgetItem *nameItem = new QTableWidgetItem(QString::fromStdString(s.getName()));
-            QTableWidgetItem *diffItem = new QTableWidgetItem(QString::number(s.getDifficulty()));
-            QTableWidgetItem *impItem = new QTableWidgetItem(QString::number(s.getImportance()));
-            QTableWidgetItem *topicsItem = new QTableWidgetItem(QString::number(s.getTopicsCount()));
-
-            set<HighlightReason> reasons = subjectHighlightReasons.size() > i ? subjectHighlightReasons[i] : set<HighlightReason>{};
-            set<HighlightReason> filtered = filteredReasons(reasons);
+            HighlightMask filtered = highlights.subjectMask(i) & filterMask(currentFilter);
+            SubjectRowKey key{s.getRevision(), filtered, s.hasExam() ? examDate(s).toJulianDay() : 0};
+            if (subjectRows[i] == key) continue;
+            subjectRows[i] = key;
+            rewritten++;
+
+            QString exam = s.hasExam() ? examDate(s).toString("yyyy-MM-dd") : QString("-");
+            QTableWidgetItem *items[5] = {
+                new QTableWidgetItem(QString::fromStdString(s.getName())),
+                new QTableWidgetItem(QString::number(s.getDifficulty())),
+                new QTableWidgetItem(QString::number(s.getImportance())),
+                new QTableWidgetItem(QString::number(s.getTopicsCount())),
+                new QTableWidgetItem(exam),
+            };
 
             QColor bgColor = colorForReason(filtered);
             if (bgColor.isValid()) {
                 QBrush bgBrush(bgColor);
-                nameItem->setBackground(bgBrush);
-                diffItem->setBackground(bgBrush);
-                impItem->setBackground(bgBrush);
-                topicsItem->setBackground(bgBrush);
-
                 QColor textColor = (bgColor.lightness() < 128) ? QColor(Qt::white) : QColor(Qt::black);
-                nameItem->setForeground(textColor);
-                diffItem->setForeground(textColor);
-                impItem->setForeground(textColor);
-                topicsItem->setForeground(textColor);
-
                 QString tooltip = QString("Subject highlight reason(s): %1").arg(reasonsText(filtered));
-                nameItem->setToolTip(tooltip);
-                diffItem->setToolTip(tooltip);
-                impItem->setToolTip(tooltip);
-                topicsItem->setToolTip(tooltip);
+                for (QTableWidgetItem *item : items) {
+                    item->setBackground(bgBrush);
+                    item->setForeground(textColor);
+                    item->setToolTip(tooltip);
+                }
             } else {
                 QColor textColor = QColor("#001f3f"); // dark navy text
-                nameItem->setForeground(textColor);
-                diffItem->setForeground(textColor);
-                impItem->setForeground(textColor);
-                topicsItem->setForeground(textColor);
+                for (QTableWidgetItem *item : items) item->setForeground(textColor);
             }
 
-            subjectTable->setItem((int)i, 0, nameItem);
-            subjectTable->setItem((int)i, 1, diffItem);
-            subjectTable->setItem((int)i, 2, impItem);
-            subjectTable->setItem((int)i, 3, topicsItem);
+            for (int c = 0; c < 5; ++c) subjectTable->setItem((int)i, c, items[c]);
         }
+        perf.addItems(rewritten);
     }
 
     bool saveCsv(const QString &filename) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        ofstream out(QFile::encodeName(filename).toStdString(), ios::binary);
+        if (!out)
             return false;
 
-        QTextStream out(&file);
-        out << "Day,Subject,Topic,Time\n";
-        for (size_t d = 0; d < lastSchedule.size(); ++d) {
-            for (const Task &t : lastSchedule[d]) {
-                out << QString::number(d+1) << ","
-                    << QString::fromStdString(t.subject) << ","
-                    << QString::fromStdString(t.topic) << ","
-                    << formatTime(t.hours) << "\n";
-            }
-        }
-        file.close();
-        return true;
+        return writeCsv(out, lastSchedule, clockStarts.size() == lastSchedule.slotCount() ? &clockStarts : nullptr);
     }
 };
 
-#include "main.moc"
+#include "Project.moc"
 
 int main(int argc, char *argv[]) {
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
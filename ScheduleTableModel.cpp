@@ -0,0 +1,212 @@
+// ScheduleTableModel.cpp
+
+#include "ScheduleTableModel.h"
+#include "ClockPlacement.h"
+#include "ScheduleIO.h"
+
+#include <QBrush>
+#include <QFont>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+bool sameSlot(const ScheduleSlot &a, const ScheduleSlot &b) {
+    return a.subject == b.subject && a.topic == b.topic && a.minutes == b.minutes && a.kind == b.kind;
+}
+
+HighlightMask reasonOf(const vector<HighlightMask> &reasons, int d) {
+    return d < (int)reasons.size() ? reasons[d] : 0;
+}
+}
+
+void ScheduleTableModel::setSchedule(const Schedule &s, const vector<HighlightMask> &dayReasons) {
+    size_t oldRows = schedule.slotCount();
+    size_t newRows = s.slotCount();
+    if (oldRows == 0 || newRows == 0) {
+        beginResetModel();
+        schedule = s;
+        reasons = dayReasons;
+        matches.clear();
+        clockStarts.clear();
+        endResetModel();
+        return;
+    }
+
+    // Rows that look the same before and after: the longest common prefix
+    // and suffix (same slot, day and highlight). Only the rows between them
+    // are replaced, so the view keeps its scroll position and selection.
+    size_t prefix = 0, suffix = 0;
+    if (s.nameTables() == schedule.nameTables()) {
+        const vector<ScheduleSlot> &before = schedule.allSlots();
+        const vector<ScheduleSlot> &after = s.allSlots();
+        size_t limit = min(oldRows, newRows);
+        int dOld = 0, dNew = 0;
+        for (; prefix < limit; ++prefix) {
+            while (schedule.dayOffset(dOld + 1) <= prefix) ++dOld;
+            while (s.dayOffset(dNew + 1) <= prefix) ++dNew;
+            if (dOld != dNew || !sameSlot(before[prefix], after[prefix]) ||
+                reasonOf(reasons, dOld) != reasonOf(dayReasons, dNew))
+                break;
+        }
+        dOld = schedule.dayCount() - 1;
+        dNew = s.dayCount() - 1;
+        for (; suffix < limit - prefix; ++suffix) {
+            size_t ro = oldRows - 1 - suffix, rn = newRows - 1 - suffix;
+            while (schedule.dayOffset(dOld) > ro) --dOld;
+            while (s.dayOffset(dNew) > rn) --dNew;
+            if (dOld != dNew || !sameSlot(before[ro], after[rn]) || reasonOf(reasons, dOld) != reasonOf(dayReasons, dNew))
+                break;
+        }
+    }
+
+    size_t oldChanged = oldRows - prefix - suffix;
+    size_t newChanged = newRows - prefix - suffix;
+    if (newChanged < oldChanged) beginRemoveRows(QModelIndex(), (int)(prefix + newChanged), (int)(prefix + oldChanged - 1));
+    if (newChanged > oldChanged) beginInsertRows(QModelIndex(), (int)(prefix + oldChanged), (int)(prefix + newChanged - 1));
+    schedule = s;
+    reasons = dayReasons;
+    // The clock times were placed for the old schedule; the owner places the new one.
+    clockStarts.clear();
+    if (newChanged < oldChanged) endRemoveRows();
+    if (newChanged > oldChanged) endInsertRows();
+
+    size_t rewritten = min(oldChanged, newChanged);
+    if (rewritten > 0)
+        emit dataChanged(index((int)prefix, 0), index((int)(prefix + rewritten - 1), ColumnCount - 1));
+    setMatches(vector<uint32_t>());
+}
+
+void ScheduleTableModel::setFilter(HighlightFilter f) {
+    visible = filterMask(f);
+    if (schedule.slotCount() > 0)
+        emit dataChanged(index(0, 0), index(rowCount() - 1, ColumnCount - 1),
+                         {Qt::BackgroundRole, Qt::ForegroundRole, Qt::ToolTipRole});
+}
+
+void ScheduleTableModel::setMatches(const vector<uint32_t> &rows) {
+    if (rows.empty() && matches.empty()) return;
+    matches = rows;
+    if (schedule.slotCount() > 0)
+        emit dataChanged(index(0, 0), index(rowCount() - 1, ColumnCount - 1), {Qt::FontRole});
+}
+
+void ScheduleTableModel::setJournal(const ProgressJournal *j) {
+    journal = j;
+    if (schedule.slotCount() > 0)
+        emit dataChanged(index(0, 0), index(rowCount() - 1, ColumnCount - 1), {Qt::DisplayRole, Qt::FontRole});
+}
+
+void ScheduleTableModel::progressChanged(int row) {
+    if (row >= 0 && row < rowCount())
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1), {Qt::DisplayRole, Qt::FontRole});
+}
+
+void ScheduleTableModel::setClockTimes(const vector<uint16_t> &starts) {
+    if (starts.empty() && clockStarts.empty()) return;
+    clockStarts = starts;
+    if (schedule.slotCount() > 0)
+        emit dataChanged(index(0, ClockColumn), index(rowCount() - 1, ClockColumn), {Qt::DisplayRole});
+}
+
+const ProgressRecord *ScheduleTableModel::progress(int row, int d) const {
+    if (!journal || journal->empty()) return nullptr;
+    return journal->find(d, (uint32_t)row - schedule.dayOffset(d), schedule.allSlots()[row].topic);
+}
+
+void ScheduleTableModel::clear() {
+    beginResetModel();
+    schedule.clear();
+    reasons.clear();
+    matches.clear();
+    clockStarts.clear();
+    endResetModel();
+}
+
+int ScheduleTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : (int)schedule.slotCount();
+}
+
+int ScheduleTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ScheduleTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= (int)schedule.slotCount())
+        return QVariant();
+
+    int d = schedule.dayOfSlot((size_t)index.row());
+    switch (role) {
+        case Qt::DisplayRole: {
+            const ScheduleSlot &t = schedule.allSlots()[index.row()];
+            switch (index.column()) {
+                case DayColumn: return d + 1;
+                case ClockColumn: {
+                    if ((size_t)index.row() >= clockStarts.size()) return QVariant();
+                    uint16_t start = clockStarts[index.row()];
+                    if (start == NO_CLOCK_TIME) return QString("No time left");
+                    char text[16];
+                    size_t n = formatClockTo(text, start);
+                    text[n++] = '-';
+                    n += formatClockTo(text + n, start + t.minutes);
+                    return QString::fromLatin1(text, (int)n);
+                }
+                case SubjectColumn: return QString::fromStdString(schedule.subjectName(t));
+                case TopicColumn:
+                    if (t.kind == SlotKind::Review)
+                        return QString::fromLatin1(REVIEW_PREFIX) + QString::fromStdString(schedule.topicName(t));
+                    return QString::fromStdString(schedule.topicName(t));
+                case TimeColumn: return QString::fromStdString(formatTime((int)t.minutes));
+                case ProgressColumn: {
+                    const ProgressRecord *r = progress(index.row(), d);
+                    if (!r) return QVariant();
+                    switch (r->status) {
+                        case ProgressStatus::Done: return QString("Done");
+                        case ProgressStatus::Partial: return QString("Partly (%1)").arg(QString::fromStdString(formatTime((int)r->minutes)));
+                        case ProgressStatus::Skipped: return QString("Skipped");
+                    }
+                    return QVariant();
+                }
+            }
+            return QVariant();
+        }
+        case Qt::BackgroundRole: {
+            const QColor &bgColor = colorForReason(dayReasons(d));
+            return QBrush(bgColor.isValid() ? bgColor : QColor(Qt::white));
+        }
+        case Qt::FontRole: {
+            bool match = binary_search(matches.begin(), matches.end(), (uint32_t)index.row());
+            const ProgressRecord *r = progress(index.row(), d);
+            bool done = r && r->status == ProgressStatus::Done;
+            if (!match && !done) return QVariant();
+            QFont font;
+            font.setBold(match);
+            font.setStrikeOut(done);
+            return font;
+        }
+        case Qt::ForegroundRole:
+            return QBrush(textColorFor(colorForReason(dayReasons(d))));
+        case Qt::ToolTipRole:
+            if (index.column() == DayColumn && dayReasons(d) != 0)
+                return QString("Day %1 highlight reason(s): %2").arg(d+1).arg(reasonsText(dayReasons(d)));
+            if (index.column() == TopicColumn && schedule.allSlots()[index.row()].kind == SlotKind::Review)
+                return QString("Spaced-repetition review of a topic studied earlier");
+            return QVariant();
+    }
+    return QVariant();
+}
+
+QVariant ScheduleTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1;
+    switch (section) {
+        case DayColumn: return QString("Day");
+        case ClockColumn: return QString("Clock");
+        case SubjectColumn: return QString("Subject");
+        case TopicColumn: return QString("Topic");
+        case TimeColumn: return QString("Time");
+        case ProgressColumn: return QString("Progress");
+    }
+    return QVariant();
+}
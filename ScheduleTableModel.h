@@ -0,0 +1,58 @@
+// ScheduleTableModel.h
+//  Read-only table model over a generated Schedule. Rows are produced on
+//  demand from the flat slot array; highlight colours and tooltips come
+//  from data roles, so re-filtering, search matches, progress records and
+//  clock times only repaint.
+
+#pragma once
+
+#include "Highlighting.h"
+#include "ProgressJournal.h"
+#include "Schedule.h"
+
+#include <QAbstractTableModel>
+
+#include <vector>
+
+class ScheduleTableModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column { DayColumn, ClockColumn, SubjectColumn, TopicColumn, TimeColumn, ProgressColumn, ColumnCount };
+
+    explicit ScheduleTableModel(QObject *parent = nullptr) : QAbstractTableModel(parent) {}
+
+    // Replaces the whole schedule; dayReasons holds one mask per schedule day.
+    // Rows that stay the same at the start and end are kept, and only the
+    // rows between them are reported as changed, inserted or removed.
+    void setSchedule(const Schedule &s, const std::vector<HighlightMask> &dayReasons);
+    void setFilter(HighlightFilter f);
+    // Rows (slot indices, ascending) shown in bold as search matches.
+    void setMatches(const std::vector<uint32_t> &rows);
+    // Journal whose latest records fill the progress column, or nullptr. It
+    // is read on demand, so it must outlive the model or be replaced first.
+    void setJournal(const ProgressJournal *j);
+    // Repaints row after a record for it was appended to the journal.
+    void progressChanged(int row);
+    // Start of every slot from ClockPlacer::place(), shown with its end in
+    // the clock column; empty to leave the column blank. setSchedule()
+    // clears them.
+    void setClockTimes(const std::vector<uint16_t> &starts);
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    Schedule schedule;
+    std::vector<HighlightMask> reasons; // per day, unfiltered
+    HighlightMask visible = ALL_HIGHLIGHTS;
+    std::vector<uint32_t> matches;
+    const ProgressJournal *journal = nullptr;
+    std::vector<uint16_t> clockStarts; // per slot, or empty
+
+    const ProgressRecord *progress(int row, int d) const;
+
+    HighlightMask dayReasons(int d) const { return d < (int)reasons.size() ? (reasons[d] & visible) : 0; }
+};
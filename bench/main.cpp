@@ -0,0 +1,536 @@
+// main.cpp
+//  adexa-bench: timings, allocation counts and peak memory for the
+//  generation, highlight, render and export hot paths on synthetic plans.
+
+#include "AllocCounter.h"
+#include "Calendar.h"
+#include "ClockPlacement.h"
+#include "CohortAnalytics.h"
+#include "CsvWriter.h"
+#include "EditHistory.h"
+#include "Highlights.h"
+#include "ProgressJournal.h"
+#include "Replan.h"
+#include "ScheduleConfig.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "ScheduleIndex.h"
+#include "Subject.h"
+#include "SyllabusImport.h"
+#include "WhatIf.h"
+#include "WorkStealingPool.h"
+
+#ifdef ADEXA_BENCH_QT
+#include "ScheduleTableModel.h"
+#include <QGuiApplication>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct BenchResult {
+    string name;
+    size_t iterations = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+    double bytesPerOp = 0.0;
+    size_t peakHeapBytes = 0;
+    long maxRssKb = 0;
+};
+
+struct BenchOptions {
+    double minSeconds = 0.2;
+    string filter;
+    string jsonPath;
+    string comparePath;
+};
+
+// Peak resident set of the process in KiB; 0 where the platform has no way to ask.
+long maxRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024; // bytes there, KiB elsewhere
+#else
+    return ru.ru_maxrss;
+#endif
+#elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc)) return 0;
+    return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    return 0;
+#endif
+}
+
+// Runs op until minSeconds have elapsed (at least 3 times) after one
+// untimed warm-up call, so buffers reused between runs are already grown.
+template <class Op>
+BenchResult runBench(const string &name, const BenchOptions &opts, Op &&op) {
+    BenchResult r;
+    r.name = name;
+    op();
+
+    resetPeakHeap();
+    AllocSnapshot before = allocSnapshot();
+    auto started = chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (r.iterations < 3 || elapsed < opts.minSeconds) {
+        op();
+        ++r.iterations;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    }
+    AllocSnapshot after = allocSnapshot();
+
+    r.nsPerOp = elapsed * 1e9 / r.iterations;
+    r.allocsPerOp = double(after.allocations - before.allocations) / r.iterations;
+    r.bytesPerOp = double(after.bytes - before.bytes) / r.iterations;
+    r.peakHeapBytes = peakHeapSinceReset();
+    r.maxRssKb = maxRssKb();
+    return r;
+}
+
+// Deterministic synthetic subjects: difficulty/importance spread over 1-10
+// and topicsPerSubject topics each, with realistic topic name lengths.
+vector<Subject> makeSubjects(int count, int topicsPerSubject) {
+    uint32_t seed = 12345u;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+    vector<Subject> subjects;
+    subjects.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        vector<string> topics;
+        topics.reserve(topicsPerSubject);
+        for (int t = 0; t < topicsPerSubject; ++t)
+            topics.push_back("Subject " + to_string(i) + " chapter " + to_string(t) + ": review notes");
+        Subject s;
+        s.setName("Subject " + to_string(i));
+        s.setDifficulty(1 + (int)(next() % 10));
+        s.setImportance(1 + (int)(next() % 10));
+        s.setTopicsList(topics);
+        subjects.push_back(s);
+    }
+    return subjects;
+}
+
+// A busy term as an iCalendar file starting on BENCH_TERM_START: 40 weekly
+// classes, a daily commute and lunch, and 500 one-off appointments, which
+// over MAX_DAYS expand to about 3,300 busy blocks.
+const CivilDate BENCH_TERM_START{2026, 9, 7};
+
+string makeBusyCalendar() {
+    uint32_t seed = 777u;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    static const char *const DAYS[] = {"MO", "TU", "WE", "TH", "FR"};
+    char line[160];
+    string ics = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\n";
+    auto event = [&](int day, int minute, int length, const char *rule) {
+        CivilDate d = civilFromDays(daysFromCivil(BENCH_TERM_START) + day);
+        snprintf(line, sizeof line, "BEGIN:VEVENT\r\nDTSTART:%04d%02d%02dT%02d%02d00\r\nDURATION:PT%dM\r\n%s%s",
+                 d.year, d.month, d.day, minute / 60, minute % 60, length, rule, *rule ? "\r\n" : "");
+        ics += line;
+        ics += "END:VEVENT\r\n";
+    };
+    for (int c = 0; c < 40; ++c) {
+        char rule[64];
+        snprintf(rule, sizeof rule, "RRULE:FREQ=WEEKLY;BYDAY=%s", DAYS[c % 5]);
+        event(c % 5, 8 * 60 + (int)(next() % 10) * 60, 45 + (int)(next() % 4) * 15, rule);
+    }
+    event(0, 7 * 60 + 30, 40, "RRULE:FREQ=DAILY");
+    event(0, 12 * 60 + 30, 45, "RRULE:FREQ=DAILY");
+    for (int a = 0; a < 500; ++a)
+        event((int)(next() % MAX_DAYS), 8 * 60 + (int)(next() % 56) * 15, 30 + (int)(next() % 6) * 15, "");
+    ics += "END:VCALENDAR\r\n";
+    return ics;
+}
+
+// Discards everything written to it, so export timings measure formatting only.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char *, streamsize n) override { return n; }
+};
+
+void printResult(const BenchResult &r) {
+    printf("%-44s %10.3f us/op %10.1f allocs/op %12.0f B/op %10zu KiB peak heap %8ld KiB rss\n",
+           r.name.c_str(), r.nsPerOp / 1000.0, r.allocsPerOp, r.bytesPerOp,
+           r.peakHeapBytes / 1024, r.maxRssKb);
+    fflush(stdout);
+}
+
+bool writeJson(const string &path, const vector<BenchResult> &results) {
+    ofstream out(path);
+    if (!out) return false;
+    // One result object per line, so runs can be diffed and re-read line by line.
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.nsPerOp << ", \"allocs_per_op\": " << r.allocsPerOp
+            << ", \"bytes_per_op\": " << r.bytesPerOp << ", \"peak_heap_bytes\": " << r.peakHeapBytes
+            << ", \"max_rss_kb\": " << r.maxRssKb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+// Reads name -> ns_per_op back from a file written by writeJson.
+map<string, double> readJsonTimes(const string &path) {
+    map<string, double> times;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        size_t n = line.find("\"name\": \"");
+        size_t t = line.find("\"ns_per_op\": ");
+        if (n == string::npos || t == string::npos) continue;
+        n += 9;
+        string name = line.substr(n, line.find('"', n) - n);
+        times[name] = atof(line.c_str() + t + 13);
+    }
+    return times;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [--filter substring] [--min-time seconds] [--json out.json] [--compare baseline.json]\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--filter") && hasValue) opts.filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") && hasValue) opts.minSeconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && hasValue) opts.jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && hasValue) opts.comparePath = argv[++i];
+        else { usage(argv[0]); return 2; }
+    }
+
+#ifdef ADEXA_BENCH_QT
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+#endif
+
+    const int dayCounts[] = {1, 30, 120, MAX_DAYS};
+    const int subjectCounts[] = {5, 50, 250, 1000};
+    const int topicsPerSubject = 200;
+
+    vector<BenchResult> results;
+    auto wanted = [&](const string &name) { return opts.filter.empty() || name.find(opts.filter) != string::npos; };
+    auto record = [&](BenchResult r) { printResult(r); results.push_back(move(r)); };
+    WorkStealingPool pool;
+
+    // Steady-state paths that must not touch the heap once warmed up.
+    vector<string> allocating;
+    auto recordNoAllocs = [&](BenchResult r) {
+        if (r.allocsPerOp > 0) allocating.push_back(r.name);
+        record(move(r));
+    };
+
+    for (int subjectCount : subjectCounts) {
+        vector<Subject> subjects = makeSubjects(subjectCount, topicsPerSubject);
+
+        for (int days : dayCounts) {
+            string suffix = "/days=" + to_string(days) + "/subjects=" + to_string(subjectCount);
+
+            ScheduleGenerator gen(days, DEFAULT_MINUTES_PER_DAY);
+            gen.setSubjects(subjects);
+            gen.generateSchedule();
+            const Schedule &schedule = gen.getSchedule();
+
+            if (wanted("generate" + suffix))
+                recordNoAllocs(runBench("generate" + suffix, opts, [&] { gen.generateSchedule(); }));
+
+            // The other weighting and rotation policies on the same plan, to
+            // set against generate, which runs product weighting and cyclic
+            // rotation.
+            for (WeightingPolicy w : {WeightingPolicy::Product, WeightingPolicy::LogDifficulty, WeightingPolicy::ImportanceSquared}) {
+                for (RotationPolicy r : {RotationPolicy::Cyclic, RotationPolicy::LeastRecent}) {
+                    if (w == WeightingPolicy::Product && r == RotationPolicy::Cyclic) continue;
+                    string name = string("policy=") + weightingName(w) + "+" + rotationName(r) + suffix;
+                    if (!wanted(name)) continue;
+                    ScheduleGenerator policyGen(days, DEFAULT_MINUTES_PER_DAY);
+                    policyGen.setPolicies(SchedulePolicies{w, r});
+                    policyGen.setSubjects(subjects);
+                    recordNoAllocs(runBench(name, opts, [&] { policyGen.generateSchedule(); }));
+                }
+            }
+
+            if (wanted("regenerate" + suffix)) {
+                // What a Generate click does to the generator: load the
+                // subjects again, then generate.
+                ScheduleGenerator regen(days, DEFAULT_MINUTES_PER_DAY);
+                recordNoAllocs(runBench("regenerate" + suffix, opts, [&] {
+                    regen.setSubjects(subjects);
+                    regen.generateSchedule();
+                }));
+            }
+
+            if (wanted("edit-regenerate" + suffix)) {
+                // A Generate click after nudging one subject's importance:
+                // only that subject's weight is refilled, then every day is
+                // placed again.
+                ScheduleGenerator regen(days, DEFAULT_MINUTES_PER_DAY);
+                vector<Subject> edited = subjects;
+                regen.setSubjects(edited);
+                size_t step = 0;
+                recordNoAllocs(runBench("edit-regenerate" + suffix, opts, [&] {
+                    Subject &s = edited[step++ % edited.size()];
+                    s.setImportance(s.getImportance() % 10 + 1);
+                    regen.setSubjects(edited);
+                    regen.generateSchedule();
+                }));
+            }
+
+            if (wanted("replan" + suffix)) {
+                // Replan from mid-plan after the day before was skipped: the
+                // kept days are copied, the skipped time becomes debt and the
+                // rest of the plan is placed again.
+                PlanInput plan;
+                plan.days = days;
+                plan.subjects = subjects;
+                ProgressJournal journal;
+                int today = days / 2;
+                string error;
+                if (today > 0) {
+                    uint32_t k = 0;
+                    for (const ScheduleSlot &t : schedule.day(today - 1))
+                        journal.append(ProgressRecord{(uint32_t)today - 1, k++, t.topic, 0, ProgressStatus::Skipped, 0}, error);
+                }
+                Replanner replanner;
+                Schedule replanned;
+                recordNoAllocs(runBench("replan" + suffix, opts, [&] {
+                    replanner.replan(plan, schedule, journal, today, replanned, error);
+                }));
+            }
+
+            if (wanted("deadline" + suffix)) {
+                // Same plan with exams spread over the period (every third
+                // subject has none) and one free day a week.
+                vector<Subject> withExams = subjects;
+                for (size_t i = 0; i < withExams.size(); ++i)
+                    if (i % 3 != 2) withExams[i].setExamDay(1 + (int)((i * 7919) % (size_t)days));
+                vector<DayAvailability> freeDays;
+                for (int d = 6; d < days; d += 7) freeDays.push_back(DayAvailability{d, 0});
+                ScheduleGenerator planner(days, DEFAULT_MINUTES_PER_DAY);
+                planner.setSubjects(withExams);
+                planner.setAvailability(freeDays);
+                recordNoAllocs(runBench("deadline" + suffix, opts, [&] { planner.generateSchedule(); }));
+            }
+
+            if (wanted("reviews" + suffix)) {
+                // Spaced repetition with 5-minute slots on 8-hour days, so a
+                // long plan cycles tens of thousands of reviews through the queue.
+                ScheduleGenerator reviewer(days, 8 * 60);
+                reviewer.setSubjects(subjects);
+                reviewer.setSlotLimits(60, 5);
+                reviewer.setReviews(5);
+                recordNoAllocs(runBench("reviews" + suffix, opts, [&] { reviewer.generateSchedule(); }));
+            }
+
+            if (wanted("analyze" + suffix)) {
+                HighlightAnalysis highlights;
+                recordNoAllocs(runBench("analyze" + suffix, opts, [&] { highlights.analyze(schedule, subjects.size()); }));
+            }
+
+            if (wanted("index" + suffix)) {
+                // The slot postings; the name index is built once for the
+                // shared name tables and kept.
+                ScheduleIndex index;
+                recordNoAllocs(runBench("index" + suffix, opts, [&] { index.build(schedule); }));
+            }
+
+            if (wanted("search" + suffix)) {
+                // A query typed into the search box: the topics of one subject
+                // whose chapter number starts with 1.
+                ScheduleIndex index;
+                index.build(schedule);
+                string query = "SUBJECT " + to_string(subjectCount / 2) + " chapter 1";
+                vector<uint32_t> hits;
+                record(runBench("search" + suffix, opts, [&] { index.search(query, hits, 1000); }));
+            }
+
+#ifdef ADEXA_BENCH_QT
+            if (wanted("render" + suffix)) {
+                // What populateScheduleTable costs: reset the model, then
+                // fetch every role for one screenful of rows.
+                HighlightAnalysis highlights;
+                highlights.analyze(schedule, subjects.size());
+                ScheduleTableModel model;
+                const int visibleRows = 40;
+                record(runBench("render" + suffix, opts, [&] {
+                    model.setSchedule(schedule, highlights.allDayMasks());
+                    int rows = min(visibleRows, model.rowCount());
+                    for (int r = 0; r < rows; ++r)
+                        for (int c = 0; c < model.columnCount(); ++c)
+                            for (int role : {Qt::DisplayRole, Qt::BackgroundRole, Qt::ForegroundRole, Qt::ToolTipRole})
+                                model.data(model.index(r, c), role);
+                }));
+            }
+#endif
+
+            if (wanted("export" + suffix)) {
+                NullBuffer sink;
+                ostream out(&sink);
+                recordNoAllocs(runBench("export" + suffix, opts, [&] { writeCsv(out, schedule); }));
+            }
+
+            if (wanted("place" + suffix)) {
+                // Clock times for every session around a term's worth of classes.
+                vector<TimeInterval> busy;
+                string error;
+                parseCalendar(makeBusyCalendar(), BENCH_TERM_START, days, busy, error);
+                ClockPlacer placer;
+                placer.setBusy(busy);
+                ClockSettings settings;
+                vector<uint16_t> starts;
+                recordNoAllocs(runBench("place" + suffix, opts, [&] { placer.place(schedule, settings, starts); }));
+            }
+
+            if (wanted("stream" + suffix)) {
+                // Lazy generate-and-write, as adexa-cli does: one day in memory at a time.
+                NullBuffer sink;
+                ostream out(&sink);
+                string buffer;
+                recordNoAllocs(runBench("stream" + suffix, opts, [&] {
+                    CsvWriter csv(buffer, &out);
+                    streamCsvRows(csv, gen);
+                }));
+            }
+
+            if (wanted("history" + suffix) || wanted("undo-redo" + suffix)) {
+                // One subject edit per step: a step copies the edited subject
+                // and the chunk tables and compares the schedule day by day,
+                // sharing every other subject and every day with the step before.
+                EditHistory history;
+                vector<Subject> edited = subjects;
+                history.record("start", edited, schedule, true, 0);
+                size_t step = 0;
+                auto edit = [&] {
+                    Subject &s = edited[step++ % edited.size()];
+                    s.setImportance(s.getImportance() % 10 + 1);
+                    history.record("edit", edited, schedule, false, 0);
+                };
+                if (wanted("history" + suffix)) record(runBench("history" + suffix, opts, edit));
+                if (wanted("undo-redo" + suffix)) {
+                    edit();
+                    recordNoAllocs(runBench("undo-redo" + suffix, opts, [&] {
+                        history.undo();
+                        history.redo();
+                    }));
+                }
+            }
+        }
+
+        string whatIfName = "whatif/subjects=" + to_string(subjectCount);
+        if (wanted(whatIfName)) {
+            // A slider's worth of variants: 8 plan lengths x 4 day lengths x
+            // the plan's weights and two overrides, on every core.
+            PlanInput plan;
+            plan.subjects = subjects;
+            WhatIfExplorer explorer(pool);
+            explorer.setPlan(plan);
+            WhatIfGrid grid;
+            for (int days = 14; days <= MAX_DAYS; days += 50) grid.days.push_back(days);
+            for (int hours = 2; hours <= 5; ++hours) grid.minutesPerDay.push_back(hours * 60);
+            grid.weightSets.push_back(scaleWeights(explorer.subjectTable(), {{0, 2.0}}));
+            grid.weightSets.push_back(scaleWeights(explorer.subjectTable(), {{1, 0.5}}));
+            record(runBench(whatIfName, opts, [&] { explorer.run(grid); }));
+        }
+
+        for (SyllabusFormat format : {SyllabusFormat::Csv, SyllabusFormat::Outline}) {
+            bool csvFormat = format == SyllabusFormat::Csv;
+            string importName = string(csvFormat ? "import-csv" : "import-outline") + "/subjects=" + to_string(subjectCount);
+            if (!wanted(importName)) continue;
+            // The same subjects as a syllabus file, parsed from memory into an empty list.
+            string text;
+            for (const Subject &s : subjects) {
+                if (!csvFormat) text += "subject " + s.getName() + "\n";
+                for (const string &t : s.getTopicsList()) text += csvFormat ? s.getName() + "," + t + "\n" : t + "\n";
+            }
+            record(runBench(importName, opts, [&] {
+                vector<Subject> imported;
+                string error;
+                importSyllabusText(text, format, imported, error);
+            }));
+        }
+    }
+
+    string calendarName = "calendar/days=" + to_string(MAX_DAYS);
+    if (wanted(calendarName)) {
+        // Reading and expanding the busy term of the place benchmarks.
+        string ics = makeBusyCalendar();
+        vector<TimeInterval> busy;
+        string error;
+        record(runBench(calendarName, opts, [&] { parseCalendar(ics, BENCH_TERM_START, MAX_DAYS, busy, error); }));
+    }
+
+    string cohortName = "cohort/schedules=10000/days=" + to_string(MAX_DAYS);
+    if (wanted(cohortName)) {
+        // The report over a year-long cohort: 64 distinct plans (study hours
+        // and weights varied) added over and over up to 10,000 schedules.
+        vector<Subject> subjects = makeSubjects(8, 20);
+        CohortAnalytics cohort;
+        vector<Schedule> variants;
+        for (int v = 0; v < 64; ++v) {
+            for (size_t i = 0; i < subjects.size(); ++i) subjects[i].setImportance(1 + (int)((v + i * 3) % 10));
+            ScheduleGenerator gen(MAX_DAYS, (2 + v % 5) * 60);
+            gen.setSubjects(subjects);
+            gen.setReviews(v % 2 ? DEFAULT_REVIEW_MINUTES : 0);
+            gen.generateSchedule();
+            variants.push_back(gen.getSchedule());
+        }
+        for (int s = 0; s < 10000; ++s) cohort.add(variants[s % variants.size()]);
+        CohortReport report;
+        recordNoAllocs(runBench(cohortName, opts, [&] { cohort.report(report); }));
+    }
+
+    if (!opts.jsonPath.empty() && !writeJson(opts.jsonPath, results)) {
+        cerr << "adexa-bench: cannot write " << opts.jsonPath << "\n";
+        return 1;
+    }
+
+    if (!opts.comparePath.empty()) {
+        map<string, double> baseline = readJsonTimes(opts.comparePath);
+        if (baseline.empty()) {
+            cerr << "adexa-bench: no results in " << opts.comparePath << "\n";
+            return 1;
+        }
+        printf("\n%-44s %12s %12s %8s\n", "benchmark", "baseline us", "current us", "speedup");
+        for (const BenchResult &r : results) {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end()) continue;
+            printf("%-44s %12.3f %12.3f %7.2fx\n", r.name.c_str(), it->second / 1000.0, r.nsPerOp / 1000.0,
+                   r.nsPerOp > 0 ? it->second / r.nsPerOp : 0.0);
+        }
+    }
+
+    for (const string &name : allocating)
+        cerr << "adexa-bench: " << name << " allocates in steady state; expected none\n";
+    return allocating.empty() ? 0 : 1;
+}
@@ -0,0 +1,836 @@
+// main.cpp
+//  adexa-cli: headless schedule generation (no Qt, no display needed)
+
+#include "BatchGenerator.h"
+#include "Calendar.h"
+#include "ClockPlacement.h"
+#include "CohortAnalytics.h"
+#include "CsvWriter.h"
+#include "PerfStats.h"
+#include "ProfileStore.h"
+#include "ProgressJournal.h"
+#include "Replan.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "ScheduleService.h"
+#include "SyllabusImport.h"
+#include "WhatIf.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <signal.h>
+#define ADEXA_HAVE_SIGWAIT 1
+#endif
+
+using namespace std;
+
+namespace {
+
+struct CliOptions {
+    string inputPath = "-";
+    string outputPath;
+    int daysOverride = 0;
+    double hoursOverride = 0.0;
+    double maxChunkOverride = 0.0;
+    double minSlotOverride = 0.0;
+    double reviewsOverride = -1.0; // hours per review, 0 turns reviews off
+    string weighting;              // policy names, empty to keep the plan's
+    string rotation;
+    vector<string> syllabusPaths;
+    bool batchMode = false;
+    bool cohortMode = false;
+    unsigned threads = 0;
+    bool inputIsProfile = false;
+    string saveProfilePath;
+    string journalPath;
+    vector<string> marks;
+    int replanFrom = 0; // 1-based, 0 when not replanning
+    string busyPath;
+    string startDate;
+    string dayStart;
+    string dayEnd;
+    int breakMinutes = -1;
+    string cacheDir;
+    bool whatIfMode = false;
+    string daysGrid;
+    string hoursGrid;
+    vector<string> weightSets;
+    string statsPath;
+    bool serveMode = false;
+    string serveHost = "127.0.0.1";
+    int servePort = DEFAULT_SERVICE_PORT;
+    size_t maxQueue = 0;
+};
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-d days] [-H hours-per-day] [--max-chunk hours] [--min-slot hours]\n"
+         << "       " << string(strlen(prog), ' ') << " [--reviews hours] [--syllabus file]... [-o output.csv]\n"
+         << "       " << string(strlen(prog), ' ') << " [--weighting policy] [--rotation policy]\n"
+         << "       " << string(strlen(prog), ' ') << " [--save-profile out.adxp] [clock options] [input|-]\n"
+         << "       " << prog << " --profile [-d days] [-H hours-per-day] [--max-chunk hours] [--min-slot hours]\n"
+         << "       " << string(strlen(prog), ' ') << " [--reviews hours] [clock options] [-o output.csv] profile.adxp\n"
+         << "       " << prog << " --profile --journal file [--mark day:slot:status]... [--replan-from day]\n"
+         << "       " << string(strlen(prog), ' ') << " [-H hours-per-day] [--save-profile out.adxp] [-o output.csv] profile.adxp\n"
+         << "       " << prog << " --batch [-j threads] [--cache-dir dir] [-o output.csv] [input|-]\n"
+         << "       " << prog << " --batch --cohort [-j threads] [-o report.json] [input|-]\n"
+         << "       " << prog << " --what-if [--days-grid grid] [--hours-grid grid] [--weights name=factor,...]\n"
+         << "       " << string(strlen(prog), ' ') << " [-j threads] [-o output.csv] [input|-]\n"
+         << "       " << prog << " --serve [--host address] [--port port] [-j threads] [--max-queue requests]\n"
+         << "clock options: [--busy calendar.ics --start YYYY-MM-DD] [--day-start HH:MM]\n"
+         << "               [--day-end HH:MM] [--break minutes]\n"
+         << "Reads a plan (see core/ScheduleIO.h) from the input file or stdin\n"
+         << "and writes the generated schedule as CSV to stdout or the output file.\n"
+         << "--profile reads a saved binary profile instead; a stored schedule is\n"
+         << "written as is unless -d/-H/--max-chunk/--min-slot/--reviews or a policy\n"
+         << "option changes the plan.\n"
+         << "--reviews adds spaced-repetition reviews of the given length for every\n"
+         << "topic studied (0 turns off reviews set in the plan).\n"
+         << "--weighting sets how subjects share the time: product (difficulty x\n"
+         << "importance x topics, the default), log-difficulty or importance-squared.\n"
+         << "--rotation sets the topic order: cyclic (list order, the default) or\n"
+         << "least-recent (the topic studied or reviewed longest ago first).\n"
+         << "--journal records progress on the profile's stored schedule: each --mark\n"
+         << "appends 'day:slot:done', 'day:slot:skipped' or 'day:slot:partial:minutes'\n"
+         << "(day and slot 1-based, as in the CSV). --replan-from keeps the days\n"
+         << "before the given day, carries the time they missed forward and plans\n"
+         << "the rest again; the result is written as CSV.\n"
+         << "Clock options give every session a start and end time (Start and End\n"
+         << "CSV columns) within the study hours (default 09:00-22:00), with a break\n"
+         << "after each (default 10 min), around the busy events of an iCalendar\n"
+         << "file; --start is the date of day 1. Sessions that do not fit keep\n"
+         << "empty times.\n"
+         << "--syllabus adds the subjects and topics of a syllabus file to the plan:\n"
+         << "'subject,topic[,difficulty,importance]' rows for a .csv name, otherwise\n"
+         << "'subject [difficulty importance] name' headers each followed by topics.\n"
+         << "With --batch the input holds one plan per 'student <id>' block; all\n"
+         << "plans are generated in parallel and written in input order. With\n"
+         << "--cache-dir each student's schedule is kept as a profile and reused\n"
+         << "by later runs with the same plan.\n"
+         << "--cohort reports on the batch instead of writing its schedules: daily\n"
+         << "load distribution and histogram, peak-day load and difficulty, load\n"
+         << "imbalance and per-subject topic coverage, as JSON.\n"
+         << "--what-if generates every combination of the grids ('from:to:step' or\n"
+         << "'a,b,c') and of the plan's weights plus each --weights set, and writes\n"
+         << "one CSV row of summary metrics per variant.\n"
+         << "--serve runs a local HTTP service until interrupted: POST a JSON plan\n"
+         << "(see readPlanJson() in core/ScheduleIO.h) to /schedule for a JSON\n"
+         << "schedule; GET /stats for counters, latency percentiles and throughput.\n"
+         << "Requests beyond --max-queue waiting ones are refused with 503.\n"
+         << "Every mode accepts --stats file.json (or '-' for stderr) to dump the\n"
+         << "timings, item counts and allocations of the instrumented hot paths.\n";
+}
+
+// Runs body with the output stream selected by -o (stdout by default).
+template <class Body>
+int withOutput(const CliOptions &opts, Body &&body) {
+    if (opts.outputPath.empty()) return body(cout);
+    ofstream out(opts.outputPath, ios::binary);
+    if (!out) {
+        cerr << "adexa-cli: cannot write " << opts.outputPath << "\n";
+        return 1;
+    }
+    return body(out);
+}
+
+bool applyOverrides(const CliOptions &opts, PlanInput &plan) {
+    if (opts.daysOverride != 0) {
+        if (opts.daysOverride < 1 || opts.daysOverride > MAX_DAYS) {
+            cerr << "adexa-cli: days must be between 1 and " << MAX_DAYS << "\n";
+            return false;
+        }
+        plan.days = opts.daysOverride;
+    }
+    if (opts.hoursOverride != 0.0) {
+        if (opts.hoursOverride < 0.5 || opts.hoursOverride > 24.0) {
+            cerr << "adexa-cli: hours must be between 0.5 and 24\n";
+            return false;
+        }
+        plan.minutesPerDay = hoursToMinutes(opts.hoursOverride);
+    }
+    for (double override : {opts.maxChunkOverride, opts.minSlotOverride}) {
+        if (override != 0.0 && (override < 0.05 || override > 24.0)) {
+            cerr << "adexa-cli: slot limits must be between 0.05 and 24 hours\n";
+            return false;
+        }
+    }
+    if (opts.maxChunkOverride != 0.0) plan.maxChunkMinutes = hoursToMinutes(opts.maxChunkOverride);
+    if (opts.minSlotOverride != 0.0) plan.minSlotMinutes = hoursToMinutes(opts.minSlotOverride);
+    if (opts.reviewsOverride >= 0.0) {
+        if (opts.reviewsOverride > 24.0) {
+            cerr << "adexa-cli: reviews must be between 0 and 24 hours\n";
+            return false;
+        }
+        plan.reviewMinutes = hoursToMinutes(opts.reviewsOverride);
+    }
+    if (!opts.weighting.empty() && !parseWeighting(opts.weighting, plan.policies.weighting)) {
+        cerr << "adexa-cli: weighting must be product, log-difficulty or importance-squared\n";
+        return false;
+    }
+    if (!opts.rotation.empty() && !parseRotation(opts.rotation, plan.policies.rotation)) {
+        cerr << "adexa-cli: rotation must be cyclic or least-recent\n";
+        return false;
+    }
+    for (const string &path : opts.syllabusPaths) {
+        string error;
+        if (!importSyllabus(path, plan.subjects, error)) {
+            cerr << "adexa-cli: " << error << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int finish(CsvWriter &csv, ostream &out) {
+    if (!csv.flush() || !out.flush()) {
+        cerr << "adexa-cli: write failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+// "H:MM" or "HH:MM", 00:00 to 24:00, as minutes after midnight.
+bool parseClockTime(const string &text, int &minute) {
+    int h = 0, m = 0;
+    char end = 0;
+    if (sscanf(text.c_str(), "%d:%2d%c", &h, &m, &end) != 2 || h < 0 || m < 0 || m > 59 || h * 60 + m > MINUTES_PER_DAY)
+        return false;
+    minute = h * 60 + m;
+    return true;
+}
+
+bool wantsClockTimes(const CliOptions &opts) {
+    return !opts.busyPath.empty() || !opts.dayStart.empty() || !opts.dayEnd.empty() || opts.breakMinutes >= 0;
+}
+
+// Places schedule's slots at clock times as the clock options ask; false
+// after reporting a bad option or calendar.
+bool placeClockTimes(const CliOptions &opts, const Schedule &schedule, vector<uint16_t> &starts) {
+    ClockSettings settings;
+    if ((!opts.dayStart.empty() && !parseClockTime(opts.dayStart, settings.dayStartMinute)) ||
+        (!opts.dayEnd.empty() && !parseClockTime(opts.dayEnd, settings.dayEndMinute)) ||
+        settings.dayEndMinute <= settings.dayStartMinute) {
+        cerr << "adexa-cli: study hours must be HH:MM with --day-start before --day-end\n";
+        return false;
+    }
+    if (opts.breakMinutes >= 0) settings.breakMinutes = opts.breakMinutes;
+
+    ClockPlacer placer;
+    if (!opts.busyPath.empty()) {
+        CivilDate start;
+        if (!parseCivilDate(opts.startDate, start)) {
+            cerr << "adexa-cli: --busy needs --start YYYY-MM-DD, the date of day 1\n";
+            return false;
+        }
+        vector<TimeInterval> busy;
+        CalendarImportStats stats;
+        string error;
+        if (!readCalendar(opts.busyPath, start, schedule.dayCount(), busy, error, &stats)) {
+            cerr << "adexa-cli: " << error << "\n";
+            return false;
+        }
+        if (stats.unsupported > 0)
+            cerr << "adexa-cli: warning: " << opts.busyPath << ": " << stats.unsupported
+                 << " events with unsupported recurrence rules ignored\n";
+        placer.setBusy(busy);
+    }
+    size_t placed = placer.place(schedule, settings, starts);
+    if (placed < schedule.slotCount())
+        cerr << "adexa-cli: warning: " << schedule.slotCount() - placed << " of " << schedule.slotCount()
+             << " sessions do not fit into the study hours\n";
+    return true;
+}
+
+// Writes schedule as CSV, with clock times when the options ask for them.
+int writeSchedule(const CliOptions &opts, const Schedule &schedule) {
+    vector<uint16_t> starts;
+    bool times = wantsClockTimes(opts);
+    if (times && !placeClockTimes(opts, schedule, starts)) return 2;
+    return withOutput(opts, [&](ostream &out) {
+        string buffer;
+        CsvWriter csv(buffer, &out);
+        writeCsvHeader(csv, false, times);
+        writeCsvRows(csv, schedule, string(), times ? &starts : nullptr);
+        return finish(csv, out);
+    });
+}
+
+// Subjects whose exam comes too early for their weighted share of the time.
+void reportShortfalls(const ScheduleGenerator &gen, const PlanInput &plan) {
+    for (const DeadlineShortfall &s : gen.shortfalls()) {
+        const Subject &subject = plan.subjects[s.subject];
+        cerr << "adexa-cli: warning: " << subject.getName() << ": exam on day " << subject.getExamDay()
+             << " leaves " << formatTime((int)s.plannedMinutes) << " of a " << formatTime((int)s.wantedMinutes) << " share\n";
+    }
+}
+
+string cachePath(const string &dir, const PlanInput &plan) {
+    char name[32];
+    snprintf(name, sizeof name, "%016" PRIx64 ".adxp", planFingerprint(plan));
+    return dir + "/" + name;
+}
+
+int runBatch(istream &in, const CliOptions &opts) {
+    vector<BatchJob> jobs;
+    string error;
+    if (!readBatch(in, jobs, error)) {
+        cerr << "adexa-cli: " << opts.inputPath << ": " << error << "\n";
+        return 1;
+    }
+
+    WorkStealingPool pool(opts.threads);
+    BatchGenerator batch(pool);
+    const string &cacheDir = opts.cacheDir;
+    BatchFormatter format = [&cacheDir](const BatchJob &job, ScheduleGenerator &gen, string &text) -> size_t {
+        CsvWriter csv(text);
+        if (cacheDir.empty())
+            return streamCsvRows(csv, gen, job.id);
+
+        string path = cachePath(cacheDir, job.plan);
+        string error;
+        MappedProfile cached;
+        if (cached.open(path, error) && cached.hasSchedule())
+            return writeCsvRows(csv, cached, job.id);
+
+        gen.generateSchedule();
+        if (!saveProfile(path, job.plan, &gen.getSchedule(), error))
+            cerr << "adexa-cli: cache: " << error << "\n";
+        return writeCsvRows(csv, gen.getSchedule(), job.id);
+    };
+
+    return withOutput(opts, [&](ostream &out) {
+        BatchStats stats;
+        {
+            string buffer;
+            CsvWriter header(buffer, &out);
+            writeCsvHeader(header, true);
+        }
+        stats = batch.run(jobs, format, out);
+        out.flush();
+
+        cerr << "adexa-cli: " << stats.schedules << " schedules (" << stats.tasks << " tasks) in "
+             << stats.seconds << " s on " << stats.threads << " threads: "
+             << stats.schedulesPerSecond() << " schedules/s\n";
+        return out ? 0 : 1;
+    });
+}
+
+int runCohort(istream &in, const CliOptions &opts) {
+    vector<BatchJob> jobs;
+    string error;
+    if (!readBatch(in, jobs, error)) {
+        cerr << "adexa-cli: " << opts.inputPath << ": " << error << "\n";
+        return 1;
+    }
+
+    auto started = chrono::steady_clock::now();
+    WorkStealingPool pool(opts.threads);
+    CohortAnalytics cohort;
+    generateCohort(pool, jobs, cohort);
+    CohortReport report;
+    cohort.report(report);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    string text;
+    appendCohortJson(text, report);
+    text += '\n';
+    cerr << "adexa-cli: cohort of " << report.schedules << " schedules (" << report.days << " days) in " << seconds
+         << " s on " << pool.size() << " threads\n";
+    return withOutput(opts, [&](ostream &out) {
+        out.write(text.data(), (streamsize)text.size());
+        out.flush();
+        return out ? 0 : 1;
+    });
+}
+
+// Parses "from:to:step" or "a,b,c".
+bool parseGrid(const string &spec, vector<double> &values) {
+    values.clear();
+    double from = 0.0, to = 0.0, step = 0.0;
+    char c1 = 0, c2 = 0;
+    istringstream range(spec);
+    if (range >> from >> c1 >> to >> c2 >> step && c1 == ':' && c2 == ':' && range.eof()) {
+        if (step <= 0.0 || to < from) return false;
+        for (double v = from; v <= to + step * 1e-6; v += step) values.push_back(v);
+        return true;
+    }
+    istringstream list(spec);
+    string item;
+    while (getline(list, item, ',')) {
+        char *end = nullptr;
+        double v = strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0') return false;
+        values.push_back(v);
+    }
+    return !values.empty();
+}
+
+// Parses "name=factor,..." against the plan's subject names.
+bool parseWeights(const string &spec, const PlanInput &plan, vector<pair<uint32_t, double>> &factors) {
+    istringstream list(spec);
+    string item;
+    while (getline(list, item, ',')) {
+        size_t eq = item.rfind('=');
+        if (eq == string::npos) return false;
+        string name = item.substr(0, eq);
+        char *end = nullptr;
+        double factor = strtod(item.c_str() + eq + 1, &end);
+        if (*end != '\0' || factor < 0.0) return false;
+        uint32_t i = 0;
+        while (i < plan.subjects.size() && plan.subjects[i].getName() != name) ++i;
+        if (i == plan.subjects.size()) {
+            cerr << "adexa-cli: --weights: no subject named " << name << "\n";
+            return false;
+        }
+        factors.emplace_back(i, factor);
+    }
+    return true;
+}
+
+int runWhatIf(const CliOptions &opts, const PlanInput &plan) {
+    if (plan.subjects.empty()) {
+        cerr << "adexa-cli: no subjects in input\n";
+        return 1;
+    }
+
+    WhatIfGrid grid;
+    vector<double> values;
+    if (opts.daysGrid.empty()) {
+        grid.days.push_back(plan.days);
+    } else {
+        if (!parseGrid(opts.daysGrid, values)) {
+            cerr << "adexa-cli: bad --days-grid " << opts.daysGrid << "\n";
+            return 2;
+        }
+        for (double v : values) {
+            if (v < 1 || v > MAX_DAYS || v != floor(v)) {
+                cerr << "adexa-cli: days must be whole numbers between 1 and " << MAX_DAYS << "\n";
+                return 2;
+            }
+            grid.days.push_back((int)v);
+        }
+    }
+    if (opts.hoursGrid.empty()) {
+        grid.minutesPerDay.push_back(plan.minutesPerDay);
+    } else {
+        if (!parseGrid(opts.hoursGrid, values)) {
+            cerr << "adexa-cli: bad --hours-grid " << opts.hoursGrid << "\n";
+            return 2;
+        }
+        for (double v : values) {
+            if (v < 0.5 || v > 24.0) {
+                cerr << "adexa-cli: hours must be between 0.5 and 24\n";
+                return 2;
+            }
+            grid.minutesPerDay.push_back(hoursToMinutes(v));
+        }
+    }
+
+    WorkStealingPool pool(opts.threads);
+    WhatIfExplorer explorer(pool);
+    explorer.setPlan(plan);
+    for (const string &spec : opts.weightSets) {
+        vector<pair<uint32_t, double>> factors;
+        if (!parseWeights(spec, plan, factors)) {
+            cerr << "adexa-cli: bad --weights " << spec << "\n";
+            return 2;
+        }
+        grid.weightSets.push_back(scaleWeights(explorer.subjectTable(), factors));
+    }
+
+    const vector<WhatIfResult> &results = explorer.run(grid);
+
+    return withOutput(opts, [&](ostream &out) {
+        string buffer;
+        CsvWriter csv(buffer, &out);
+        for (const char *column : {"Days", "Hours", "Weights", "Planned", "PeakDay", "PeakTime",
+                                   "PeakDifficulty", "MinCoverage", "Shortfalls"})
+            csv.field(column);
+        for (const Subject &s : plan.subjects) {
+            csv.field(s.getName());
+            csv.field(s.getName() + " coverage");
+        }
+        csv.endRow();
+
+        const vector<uint32_t> &topicBase = explorer.subjectTable().names->topicBase;
+        for (const WhatIfResult &r : results) {
+            csv.field(r.days);
+            csv.timeField(r.minutesPerDay);
+            csv.field(r.weightSet == 0 ? string("plan") : opts.weightSets[r.weightSet - 1]);
+            csv.timeField((int)r.totalMinutes);
+            csv.field(r.peakDay + 1);
+            csv.timeField(r.peakMinutes);
+            csv.field(r.peakDifficulty);
+            csv.field(llround(r.minCoverage * 100.0));
+            csv.field(r.shortfalls);
+            for (size_t i = 0; i < r.subjects.size(); ++i) {
+                uint32_t topics = topicBase[i + 1] - topicBase[i];
+                csv.timeField((int)r.subjects[i].minutes);
+                csv.field(topics ? llround(100.0 * r.subjects[i].topicsCovered / topics) : 100);
+            }
+            csv.endRow();
+        }
+        return finish(csv, out);
+    });
+}
+
+int runPlan(const CliOptions &opts, PlanInput &plan) {
+    if (plan.subjects.empty()) {
+        cerr << "adexa-cli: no subjects in input\n";
+        return 1;
+    }
+
+    ScheduleGenerator gen(plan.days, plan.minutesPerDay);
+    loadPlan(gen, plan);
+
+    if (wantsClockTimes(opts)) {
+        // Placement needs whole days, so the schedule is generated first.
+        gen.generateSchedule();
+        string error;
+        if (!opts.saveProfilePath.empty() && !saveProfile(opts.saveProfilePath, plan, &gen.getSchedule(), error)) {
+            cerr << "adexa-cli: " << error << "\n";
+            return 1;
+        }
+        reportShortfalls(gen, plan);
+        return writeSchedule(opts, gen.getSchedule());
+    }
+
+    return withOutput(opts, [&](ostream &out) {
+        string buffer;
+        CsvWriter csv(buffer, &out);
+        writeCsvHeader(csv, false);
+        if (opts.saveProfilePath.empty()) {
+            // Days are generated and written one at a time through one buffer.
+            streamCsvRows(csv, gen);
+        } else {
+            gen.generateSchedule();
+            string error;
+            if (!saveProfile(opts.saveProfilePath, plan, &gen.getSchedule(), error)) {
+                cerr << "adexa-cli: " << error << "\n";
+                return 1;
+            }
+            writeCsvRows(csv, gen.getSchedule());
+        }
+        reportShortfalls(gen, plan);
+        return finish(csv, out);
+    });
+}
+
+// Parses 'day:slot:done', 'day:slot:skipped' or 'day:slot:partial:minutes'
+// against schedule into a journal record.
+bool parseMark(const string &mark, const Schedule &schedule, ProgressRecord &r, string &error) {
+    int day = 0, slot = 0, minutes = 0;
+    char status[16] = "";
+    int fields = sscanf(mark.c_str(), "%d:%d:%15[a-z]:%d", &day, &slot, status, &minutes);
+    if (fields < 3) {
+        error = "bad --mark '" + mark + "'";
+        return false;
+    }
+    if (day < 1 || day > schedule.dayCount() || slot < 1 || (size_t)slot > schedule.day(day - 1).size()) {
+        error = "--mark " + mark + ": no such slot in the stored schedule";
+        return false;
+    }
+    const ScheduleSlot &t = schedule.day(day - 1).begin()[slot - 1];
+    r = ProgressRecord{(uint32_t)day - 1, (uint32_t)slot - 1, t.topic, t.minutes, ProgressStatus::Done, 0};
+    if (!strcmp(status, "skipped")) {
+        r.status = ProgressStatus::Skipped;
+        r.minutes = 0;
+    } else if (!strcmp(status, "partial") && fields == 4 && minutes >= 0) {
+        r.status = ProgressStatus::Partial;
+        r.minutes = (uint16_t)min(minutes, (int)t.minutes);
+    } else if (strcmp(status, "done") != 0) {
+        error = "bad --mark '" + mark + "'";
+        return false;
+    }
+    return true;
+}
+
+int runJournal(const CliOptions &opts, MappedProfile &profile) {
+    if (!profile.hasSchedule()) {
+        cerr << "adexa-cli: " << opts.inputPath << " has no stored schedule to track\n";
+        return 1;
+    }
+    PlanInput plan = profile.toPlan();
+    Schedule schedule = profile.toSchedule();
+    profile.close();
+
+    // Every mark and override is checked before the journal is touched, so
+    // a bad argument leaves it as it was.
+    string error;
+    vector<ProgressRecord> records;
+    records.reserve(opts.marks.size());
+    for (const string &mark : opts.marks) {
+        ProgressRecord r;
+        if (!parseMark(mark, schedule, r, error)) {
+            cerr << "adexa-cli: " << error << "\n";
+            return 1;
+        }
+        records.push_back(r);
+    }
+    // The days before replanFrom keep their stored parameters; the overrides
+    // apply to the days planned again.
+    if (opts.replanFrom != 0 && !applyOverrides(opts, plan)) return 2;
+
+    ProgressJournal journal;
+    if (!journal.open(opts.journalPath, error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return 1;
+    }
+    for (const ProgressRecord &r : records) {
+        if (!journal.append(r, error)) {
+            cerr << "adexa-cli: " << error << "\n";
+            return 1;
+        }
+    }
+    if (opts.replanFrom == 0) return 0;
+
+    Replanner replanner;
+    Schedule replanned;
+    if (!replanner.replan(plan, schedule, journal, opts.replanFrom - 1, replanned, error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return 1;
+    }
+    if (!opts.saveProfilePath.empty() && !saveProfile(opts.saveProfilePath, plan, &replanned, error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return 1;
+    }
+    uint32_t debt = replanner.totalDebtMinutes();
+    if (debt > 0)
+        cerr << "adexa-cli: " << formatTime((int)debt) << " of missed study carried forward\n";
+    return writeSchedule(opts, replanned);
+}
+
+int runProfile(const CliOptions &opts) {
+    MappedProfile profile;
+    string error;
+    if (!profile.open(opts.inputPath, error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return 1;
+    }
+    if (!opts.journalPath.empty()) return runJournal(opts, profile);
+
+    bool regenerate = !profile.hasSchedule() || opts.daysOverride != 0 || opts.hoursOverride != 0.0 ||
+                      opts.maxChunkOverride != 0.0 || opts.minSlotOverride != 0.0 || opts.reviewsOverride >= 0.0 ||
+                      !opts.weighting.empty() || !opts.rotation.empty() || !opts.syllabusPaths.empty() ||
+                      !opts.saveProfilePath.empty() || opts.whatIfMode;
+    if (!regenerate && wantsClockTimes(opts)) {
+        Schedule stored = profile.toSchedule();
+        profile.close();
+        return writeSchedule(opts, stored);
+    }
+    if (!regenerate) {
+        // The stored schedule is written straight from the mapping.
+        return withOutput(opts, [&](ostream &out) {
+            string buffer;
+            CsvWriter csv(buffer, &out);
+            writeCsvHeader(csv, false);
+            writeCsvRows(csv, profile);
+            return finish(csv, out);
+        });
+    }
+
+    PlanInput plan = profile.toPlan();
+    profile.close();
+    if (!applyOverrides(opts, plan)) return 2;
+    if (opts.whatIfMode) return runWhatIf(opts, plan);
+    return runPlan(opts, plan);
+}
+
+// Writes the hot-path stats requested with --stats ('-' for stderr).
+int dumpStats(const CliOptions &opts, int status) {
+    if (opts.statsPath.empty()) return status;
+    if (opts.statsPath == "-") {
+        writePerfJson(cerr, perfSnapshot());
+        return status;
+    }
+    string error;
+    if (!writePerfJson(opts.statsPath, error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return status ? status : 1;
+    }
+    return status;
+}
+
+int runServe(const CliOptions &opts) {
+#ifdef ADEXA_HAVE_SIGWAIT
+    // Blocked before any thread starts, so every thread inherits the mask
+    // and the signals only reach the sigwait() below.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    ServiceOptions options;
+    options.host = opts.serveHost;
+    options.port = opts.servePort;
+    options.threads = opts.threads;
+    if (opts.maxQueue > 0) options.maxQueue = opts.maxQueue;
+    ScheduleService service(options);
+    string error;
+    if (!service.start(error)) {
+        cerr << "adexa-cli: " << error << "\n";
+        return 1;
+    }
+    cerr << "adexa-cli: serving on http://" << options.host << ":" << service.port()
+         << " (POST /schedule, GET /stats, GET /health); interrupt to stop\n";
+
+    int signal = 0;
+    sigwait(&stopSignals, &signal);
+    cerr << "adexa-cli: stopping after the requests in flight\n";
+    service.stop();
+
+    ServiceStats stats = service.stats();
+    cerr << "adexa-cli: " << stats.completed << " schedules, " << stats.failed << " bad plans, "
+         << stats.rejected << " refused; p50 " << stats.p50Micros << " us, p99 " << stats.p99Micros << " us\n";
+    return 0;
+#else
+    (void)opts;
+    cerr << "adexa-cli: --serve is not supported on this platform\n";
+    return 1;
+#endif
+}
+
+int runInput(const CliOptions &opts, const char *prog) {
+    if ((!opts.journalPath.empty() && !opts.inputIsProfile) ||
+        (wantsClockTimes(opts) && (opts.batchMode || opts.whatIfMode)) || (opts.cohortMode && !opts.batchMode)) {
+        usage(prog);
+        return 2;
+    }
+    if (opts.inputIsProfile) {
+        if (opts.batchMode || opts.inputPath == "-") {
+            usage(prog);
+            return 2;
+        }
+        return runProfile(opts);
+    }
+
+    ifstream file;
+    if (opts.inputPath != "-") {
+        file.open(opts.inputPath);
+        if (!file) {
+            cerr << "adexa-cli: cannot open " << opts.inputPath << "\n";
+            return 1;
+        }
+    }
+    istream &in = (opts.inputPath == "-") ? cin : file;
+
+    if (opts.batchMode) {
+        if (opts.whatIfMode || (opts.cohortMode && !opts.cacheDir.empty())) {
+            usage(prog);
+            return 2;
+        }
+        return opts.cohortMode ? runCohort(in, opts) : runBatch(in, opts);
+    }
+
+    PlanInput plan;
+    string error;
+    if (!readPlan(in, plan, error)) {
+        cerr << "adexa-cli: " << opts.inputPath << ": " << error << "\n";
+        return 1;
+    }
+    if (!applyOverrides(opts, plan)) return 2;
+    if (opts.whatIfMode) return runWhatIf(opts, plan);
+    return runPlan(opts, plan);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    ios::sync_with_stdio(false);
+
+    CliOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((!strcmp(arg, "-d") || !strcmp(arg, "--days")) && hasValue) {
+            opts.daysOverride = atoi(argv[++i]);
+        } else if ((!strcmp(arg, "-H") || !strcmp(arg, "--hours")) && hasValue) {
+            opts.hoursOverride = atof(argv[++i]);
+        } else if (!strcmp(arg, "--max-chunk") && hasValue) {
+            opts.maxChunkOverride = atof(argv[++i]);
+        } else if (!strcmp(arg, "--min-slot") && hasValue) {
+            opts.minSlotOverride = atof(argv[++i]);
+        } else if (!strcmp(arg, "--reviews") && hasValue) {
+            opts.reviewsOverride = max(atof(argv[++i]), 0.0);
+        } else if (!strcmp(arg, "--weighting") && hasValue) {
+            opts.weighting = argv[++i];
+        } else if (!strcmp(arg, "--rotation") && hasValue) {
+            opts.rotation = argv[++i];
+        } else if (!strcmp(arg, "--syllabus") && hasValue) {
+            opts.syllabusPaths.push_back(argv[++i]);
+        } else if ((!strcmp(arg, "-o") || !strcmp(arg, "--output")) && hasValue) {
+            opts.outputPath = argv[++i];
+        } else if (!strcmp(arg, "--batch")) {
+            opts.batchMode = true;
+        } else if ((!strcmp(arg, "-j") || !strcmp(arg, "--threads")) && hasValue) {
+            opts.threads = (unsigned)atoi(argv[++i]);
+        } else if (!strcmp(arg, "--profile")) {
+            opts.inputIsProfile = true;
+        } else if (!strcmp(arg, "--save-profile") && hasValue) {
+            opts.saveProfilePath = argv[++i];
+        } else if (!strcmp(arg, "--journal") && hasValue) {
+            opts.journalPath = argv[++i];
+        } else if (!strcmp(arg, "--mark") && hasValue) {
+            opts.marks.push_back(argv[++i]);
+        } else if (!strcmp(arg, "--replan-from") && hasValue) {
+            opts.replanFrom = max(atoi(argv[++i]), 1);
+        } else if (!strcmp(arg, "--busy") && hasValue) {
+            opts.busyPath = argv[++i];
+        } else if (!strcmp(arg, "--start") && hasValue) {
+            opts.startDate = argv[++i];
+        } else if (!strcmp(arg, "--day-start") && hasValue) {
+            opts.dayStart = argv[++i];
+        } else if (!strcmp(arg, "--day-end") && hasValue) {
+            opts.dayEnd = argv[++i];
+        } else if (!strcmp(arg, "--break") && hasValue) {
+            opts.breakMinutes = max(atoi(argv[++i]), 0);
+        } else if (!strcmp(arg, "--cache-dir") && hasValue) {
+            opts.cacheDir = argv[++i];
+        } else if (!strcmp(arg, "--cohort")) {
+            opts.cohortMode = true;
+        } else if (!strcmp(arg, "--what-if")) {
+            opts.whatIfMode = true;
+        } else if (!strcmp(arg, "--days-grid") && hasValue) {
+            opts.daysGrid = argv[++i];
+        } else if (!strcmp(arg, "--hours-grid") && hasValue) {
+            opts.hoursGrid = argv[++i];
+        } else if (!strcmp(arg, "--weights") && hasValue) {
+            opts.weightSets.push_back(argv[++i]);
+        } else if (!strcmp(arg, "--serve")) {
+            opts.serveMode = true;
+        } else if (!strcmp(arg, "--host") && hasValue) {
+            opts.serveHost = argv[++i];
+        } else if (!strcmp(arg, "--port") && hasValue) {
+            opts.servePort = atoi(argv[++i]);
+        } else if (!strcmp(arg, "--max-queue") && hasValue) {
+            opts.maxQueue = (size_t)max(atoi(argv[++i]), 1);
+        } else if (!strcmp(arg, "--stats") && hasValue) {
+            opts.statsPath = argv[++i];
+        } else if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+            usage(argv[0]);
+            return 0;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            opts.inputPath = arg;
+        }
+    }
+
+    if (opts.serveMode) return dumpStats(opts, runServe(opts));
+    return dumpStats(opts, runInput(opts, argv[0]));
+}
@@ -0,0 +1,98 @@
+// AllocCounter.cpp
+
+#include "AllocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef ADEXA_HEAP_TOTALS
+#define ADEXA_HEAP_TOTALS 0
+#endif
+
+#if ADEXA_HEAP_TOTALS
+#include <atomic>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define ADEXA_ALLOC_SIZE(p) malloc_usable_size(p)
+#else
+#define ADEXA_ALLOC_SIZE(p) ((size_t)0)
+#endif
+#endif
+
+namespace {
+thread_local size_t threadCount = 0;
+thread_local size_t threadBytes = 0;
+
+#if ADEXA_HEAP_TOTALS
+std::atomic<size_t> allocCount{0};
+std::atomic<size_t> allocBytes{0};
+std::atomic<size_t> liveBytes{0};
+std::atomic<size_t> peakBytes{0};
+std::atomic<size_t> baseBytes{0};
+#endif
+
+void *countedAlloc(size_t size) {
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    ++threadCount;
+    threadBytes += size;
+#if ADEXA_HEAP_TOTALS
+    size_t real = ADEXA_ALLOC_SIZE(p);
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    size_t live = liveBytes.fetch_add(real, std::memory_order_relaxed) + real;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+#endif
+    return p;
+}
+
+void countedFree(void *p) {
+    if (!p) return;
+#if ADEXA_HEAP_TOTALS
+    liveBytes.fetch_sub(ADEXA_ALLOC_SIZE(p), std::memory_order_relaxed);
+#endif
+    std::free(p);
+}
+}
+
+AllocSnapshot threadAllocSnapshot() {
+    AllocSnapshot s;
+    s.allocations = threadCount;
+    s.bytes = threadBytes;
+    return s;
+}
+
+#if ADEXA_HEAP_TOTALS
+
+AllocSnapshot allocSnapshot() {
+    AllocSnapshot s;
+    s.allocations = allocCount.load(std::memory_order_relaxed);
+    s.bytes = allocBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void resetPeakHeap() {
+    size_t live = liveBytes.load(std::memory_order_relaxed);
+    baseBytes.store(live, std::memory_order_relaxed);
+    peakBytes.store(live, std::memory_order_relaxed);
+}
+
+size_t peakHeapSinceReset() {
+    return peakBytes.load(std::memory_order_relaxed) - baseBytes.load(std::memory_order_relaxed);
+}
+
+#endif
+
+void *operator new(size_t size) { return countedAlloc(size); }
+void *operator new[](size_t size) { return countedAlloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
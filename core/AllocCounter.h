@@ -0,0 +1,29 @@
+// AllocCounter.h
+//  Global operator new/delete hooks counting the heap allocations of each
+//  thread, which is all PerfScope reads. Compiled with ADEXA_HEAP_TOTALS=1
+//  (adexa-bench only) they also keep process-wide totals and live/peak heap
+//  bytes, at the cost of shared atomics on every allocation and free.
+
+#pragma once
+
+#include <cstddef>
+
+struct AllocSnapshot {
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+// Allocations made by the calling thread only.
+AllocSnapshot threadAllocSnapshot();
+
+#if ADEXA_HEAP_TOTALS
+
+// Allocations made by every thread.
+AllocSnapshot allocSnapshot();
+
+// Peak live heap bytes since the last resetPeakHeap(), relative to the
+// live bytes at that moment. 0 when the platform cannot size allocations.
+void resetPeakHeap();
+size_t peakHeapSinceReset();
+
+#endif
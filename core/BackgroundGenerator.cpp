@@ -0,0 +1,95 @@
+// BackgroundGenerator.cpp
+
+#include "BackgroundGenerator.h"
+#include "PerfStats.h"
+
+using namespace std;
+
+BackgroundGenerator::BackgroundGenerator(FinishedCallback onFinished) : finished(move(onFinished)) {
+    worker = thread(&BackgroundGenerator::workerLoop, this);
+}
+
+BackgroundGenerator::~BackgroundGenerator() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+        latest.fetch_add(1, memory_order_acq_rel);
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+uint64_t BackgroundGenerator::start(PlanInput plan) {
+    uint64_t ticket;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        ticket = latest.fetch_add(1, memory_order_acq_rel) + 1;
+        request.ticket = ticket;
+        progressTotal.store(plan.days, memory_order_relaxed);
+        request.plan = move(plan);
+        hasRequest = true;
+        working.store(true, memory_order_release);
+        progressDone.store(0, memory_order_relaxed);
+    }
+    wake.notify_one();
+    return ticket;
+}
+
+void BackgroundGenerator::cancel() {
+    lock_guard<mutex> lock(stateMutex);
+    latest.fetch_add(1, memory_order_acq_rel);
+    hasRequest = false;
+    request.plan.subjects.clear();
+    working.store(false, memory_order_release);
+}
+
+void BackgroundGenerator::workerLoop() {
+    unique_lock<mutex> lock(stateMutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || hasRequest; });
+        if (stopping) return;
+
+        Request req = move(request);
+        hasRequest = false;
+        lock.unlock();
+
+        shared_ptr<GenerationResult> result = run(req);
+
+        lock.lock();
+        if (!hasRequest && isCurrent(req.ticket)) working.store(false, memory_order_release);
+        if (result && isCurrent(req.ticket)) {
+            lock.unlock();
+            finished(move(result));
+            lock.lock();
+        }
+    }
+}
+
+shared_ptr<GenerationResult> BackgroundGenerator::run(const Request &req) {
+    auto result = make_shared<GenerationResult>();
+    {
+        PerfScope perf(PerfProbe::Generate);
+        loadPlan(generator, req.plan);
+        generator.prepare();
+
+        result->ticket = req.ticket;
+        result->subjectCount = req.plan.subjects.size();
+        result->schedule.start(generator.nameTables(), req.plan.days, generator.slotBound());
+        result->shortfalls = generator.shortfalls();
+
+        // Cancellation is checked once per day, so a superseded run stops
+        // within one day's worth of work.
+        while (generator.nextDay()) {
+            if (!isCurrent(req.ticket)) return nullptr;
+            result->schedule.appendDay(generator.currentDay(), generator.currentDayStats());
+            progressDone.store(generator.currentDayIndex() + 1, memory_order_relaxed);
+        }
+        perf.addItems(result->schedule.slotCount());
+    }
+
+    if (!isCurrent(req.ticket)) return nullptr;
+    result->highlights.analyze(result->schedule, result->subjectCount);
+    result->index.build(result->schedule, nameIndex);
+    nameIndex = result->index.nameIndex();
+    return result;
+}
@@ -0,0 +1,85 @@
+// BackgroundGenerator.h
+//  Runs generation, highlight analysis and indexing on a worker thread so
+//  the caller (the GUI thread) never blocks. A new request or cancel() supersedes the
+//  running one, which stops at the next day boundary.
+
+#pragma once
+
+#include "Highlights.h"
+#include "Schedule.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "ScheduleIndex.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct GenerationResult {
+    uint64_t ticket = 0;
+    Schedule schedule;
+    HighlightAnalysis highlights;
+    ScheduleIndex index;
+    std::vector<DeadlineShortfall> shortfalls;
+    size_t subjectCount = 0;
+};
+
+class BackgroundGenerator {
+public:
+    // Called on the worker thread with every run that was not superseded.
+    // It should only hand the result over, e.g. by posting it to the GUI
+    // thread; the receiver still checks isCurrent(), since a cancel can race
+    // with the delivery.
+    using FinishedCallback = std::function<void(std::shared_ptr<GenerationResult>)>;
+
+    explicit BackgroundGenerator(FinishedCallback onFinished);
+    ~BackgroundGenerator();
+
+    BackgroundGenerator(const BackgroundGenerator &) = delete;
+    BackgroundGenerator &operator=(const BackgroundGenerator &) = delete;
+
+    // Queues a run of plan, cancelling any earlier one. Returns the ticket
+    // its result will carry.
+    uint64_t start(PlanInput plan);
+
+    // Drops the running and queued request; no result is delivered for them.
+    void cancel();
+
+    bool isCurrent(uint64_t ticket) const { return ticket == latest.load(std::memory_order_acquire); }
+    bool busy() const { return working.load(std::memory_order_acquire); }
+
+    // Progress of the current run in days, safe to poll from any thread.
+    int daysDone() const { return progressDone.load(std::memory_order_relaxed); }
+    int daysTotal() const { return progressTotal.load(std::memory_order_relaxed); }
+
+private:
+    struct Request {
+        uint64_t ticket = 0;
+        PlanInput plan;
+    };
+
+    FinishedCallback finished;
+    ScheduleGenerator generator{0, 0}; // worker-only; its buffers are reused between runs
+    std::shared_ptr<const ScheduleNameIndex> nameIndex; // worker-only, the last run's, reused while the names are equal
+
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    Request request;
+    bool hasRequest = false;
+    bool stopping = false;
+
+    std::atomic<uint64_t> latest{0};
+    std::atomic<bool> working{false};
+    std::atomic<int> progressDone{0};
+    std::atomic<int> progressTotal{0};
+
+    std::thread worker;
+
+    void workerLoop();
+    std::shared_ptr<GenerationResult> run(const Request &req);
+};
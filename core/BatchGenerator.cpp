@@ -0,0 +1,70 @@
+// BatchGenerator.cpp
+
+#include "BatchGenerator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+
+using namespace std;
+
+BatchStats BatchGenerator::run(const vector<BatchJob> &jobs, const BatchFormatter &format, ostream &out) {
+    auto started = chrono::steady_clock::now();
+
+    while (generators.size() < pool.size())
+        generators.emplace_back(DEFAULT_DAYS, DEFAULT_MINUTES_PER_DAY);
+
+    // Ring of output slots: job i writes into slot i % window. A slot's
+    // string keeps its capacity, so steady state formatting does not allocate.
+    size_t window = max<size_t>(8, pool.size() * 4);
+    vector<string> slots(window);
+    vector<size_t> slotTasks(window, 0);
+    vector<char> ready(window, 0);
+    mutex readyMutex;
+    condition_variable readyChanged;
+
+    auto submitJob = [&](size_t index) {
+        pool.submit([&, index](unsigned worker) {
+            const BatchJob &job = jobs[index];
+            ScheduleGenerator &gen = generators[worker];
+            loadPlan(gen, job.plan);
+
+            size_t slot = index % window;
+            string &text = slots[slot];
+            text.clear();
+            slotTasks[slot] = format(job, gen, text);
+
+            {
+                lock_guard<mutex> lock(readyMutex);
+                ready[slot] = 1;
+            }
+            readyChanged.notify_all();
+        });
+    };
+
+    size_t submitted = 0;
+    for (; submitted < jobs.size() && submitted < window; ++submitted)
+        submitJob(submitted);
+
+    BatchStats stats;
+    stats.threads = pool.size();
+    for (size_t next = 0; next < jobs.size(); ++next) {
+        size_t slot = next % window;
+        {
+            unique_lock<mutex> lock(readyMutex);
+            readyChanged.wait(lock, [&] { return ready[slot] != 0; });
+            ready[slot] = 0;
+        }
+        out.write(slots[slot].data(), (streamsize)slots[slot].size());
+        stats.tasks += slotTasks[slot];
+        ++stats.schedules;
+
+        if (submitted < jobs.size())
+            submitJob(submitted++);
+    }
+    pool.wait();
+
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return stats;
+}
@@ -0,0 +1,45 @@
+// BatchGenerator.h
+//  Generates many independent student plans in parallel and streams the
+//  results in input order.
+
+#pragma once
+
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "WorkStealingPool.h"
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct BatchStats {
+    size_t schedules = 0;
+    size_t tasks = 0;
+    unsigned threads = 0;
+    double seconds = 0.0;
+
+    double schedulesPerSecond() const { return seconds > 0.0 ? schedules / seconds : 0.0; }
+};
+
+// Produces the output text for one job into out (cleared beforehand) from
+// a generator already loaded with the job's plan, e.g. by streaming its
+// days with streamCsvRows(). Returns the number of tasks produced. Runs on
+// a worker thread, so it must only touch its arguments.
+using BatchFormatter = std::function<size_t(const BatchJob &job, ScheduleGenerator &gen, std::string &out)>;
+
+class BatchGenerator {
+public:
+    explicit BatchGenerator(WorkStealingPool &p) : pool(p) {}
+
+    // Generates every job on the pool and writes each formatted result to
+    // out as soon as all earlier jobs have been written. At most a few jobs
+    // per worker are in flight, so memory stays bounded for any batch size.
+    BatchStats run(const std::vector<BatchJob> &jobs, const BatchFormatter &format, std::ostream &out);
+
+private:
+    WorkStealingPool &pool;
+
+    // One generator per worker, reused across jobs so its buffers are too.
+    std::vector<ScheduleGenerator> generators;
+};
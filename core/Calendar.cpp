@@ -0,0 +1,467 @@
+// Calendar.cpp
+
+#include "Calendar.h"
+#include "MappedFile.h"
+#include "ScheduleConfig.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+bool isLeapYear(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+int daysInMonth(int y, int m) {
+    static const int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeapYear(y) ? 29 : DAYS[m - 1];
+}
+
+// 0 = Monday; 1970-01-01 was a Thursday.
+int weekday(int64_t days) { return (int)(((days + 3) % 7 + 7) % 7); }
+
+bool equalsIgnoreCase(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (toupper((unsigned char)a[i]) != toupper((unsigned char)b[i])) return false;
+    return true;
+}
+
+string_view trim(string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t')) ++b;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t')) --e;
+    return s.substr(b, e - b);
+}
+
+// All of s as a non-negative decimal number.
+bool parseDigits(string_view s, int &v) {
+    if (s.empty() || s[0] < '0' || s[0] > '9') return false;
+    auto r = from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == errc() && r.ptr == s.data() + s.size();
+}
+
+// A DATE ("20261016") or DATE-TIME ("20261016T090000", optionally with 'Z').
+struct DateTime {
+    CivilDate date;
+    int64_t day = 0;       // daysFromCivil(date)
+    int minuteOfDay = 0;
+    bool dateOnly = false;
+
+    int64_t minute() const { return day * MINUTES_PER_DAY + minuteOfDay; }
+};
+
+bool parseDateTime(string_view v, DateTime &out) {
+    v = trim(v);
+    if (v.size() != 8 && (v.size() < 15 || v[8] != 'T')) return false;
+    CivilDate d;
+    if (!parseDigits(v.substr(0, 4), d.year) || !parseDigits(v.substr(4, 2), d.month) ||
+        !parseDigits(v.substr(6, 2), d.day) || d.month < 1 || d.month > 12 || d.day < 1 ||
+        d.day > daysInMonth(d.year, d.month))
+        return false;
+    out.date = d;
+    out.day = daysFromCivil(d);
+    out.dateOnly = v.size() == 8;
+    out.minuteOfDay = 0;
+    if (out.dateOnly) return true;
+    int h, m, s;
+    if (!parseDigits(v.substr(9, 2), h) || !parseDigits(v.substr(11, 2), m) || !parseDigits(v.substr(13, 2), s) ||
+        h > 23 || m > 59 || s > 60 || (v.size() > 15 && v.substr(15) != "Z"))
+        return false;
+    out.minuteOfDay = h * 60 + m;
+    return true;
+}
+
+// "P1W", "P1DT2H", "PT1H30M", ... in minutes, seconds rounded up.
+bool parseDuration(string_view v, int64_t &minutes) {
+    v = trim(v);
+    if (!v.empty() && v[0] == '+') v.remove_prefix(1);
+    if (v.empty() || v[0] != 'P') return false; // negative durations block nothing
+    v.remove_prefix(1);
+    int64_t total = 0, seconds = 0;
+    bool time = false, any = false;
+    while (!v.empty()) {
+        if (v[0] == 'T') {
+            time = true;
+            v.remove_prefix(1);
+            continue;
+        }
+        size_t n = 0;
+        while (n < v.size() && v[n] >= '0' && v[n] <= '9') ++n;
+        int value;
+        if (n == 0 || n == v.size() || !parseDigits(v.substr(0, n), value)) return false;
+        char unit = v[n];
+        v.remove_prefix(n + 1);
+        if (!time && unit == 'W') total += (int64_t)value * 7 * MINUTES_PER_DAY;
+        else if (!time && unit == 'D') total += (int64_t)value * MINUTES_PER_DAY;
+        else if (time && unit == 'H') total += (int64_t)value * 60;
+        else if (time && unit == 'M') total += value;
+        else if (time && unit == 'S') seconds += value;
+        else return false;
+        any = true;
+    }
+    minutes = total + (seconds + 59) / 60;
+    return any;
+}
+
+enum class Frequency { None, Daily, Weekly, Monthly, Yearly };
+
+struct Recurrence {
+    Frequency frequency = Frequency::None;
+    int interval = 1;
+    int64_t count = -1;        // occurrences in all, -1 without a limit
+    int64_t until = INT64_MAX; // last possible start, inclusive
+    uint8_t weekdays = 0;      // BYDAY, bit 0 = Monday
+};
+
+// Parses an RRULE value; false when it uses a part not supported here.
+bool parseRule(string_view v, Recurrence &rule) {
+    static const char *const DAYS[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+    while (!v.empty()) {
+        size_t semi = v.find(';');
+        string_view part = v.substr(0, semi);
+        v = semi == string_view::npos ? string_view() : v.substr(semi + 1);
+        size_t eq = part.find('=');
+        if (eq == string_view::npos) continue;
+        string_view key = trim(part.substr(0, eq)), value = trim(part.substr(eq + 1));
+        if (equalsIgnoreCase(key, "FREQ")) {
+            if (equalsIgnoreCase(value, "DAILY")) rule.frequency = Frequency::Daily;
+            else if (equalsIgnoreCase(value, "WEEKLY")) rule.frequency = Frequency::Weekly;
+            else if (equalsIgnoreCase(value, "MONTHLY")) rule.frequency = Frequency::Monthly;
+            else if (equalsIgnoreCase(value, "YEARLY")) rule.frequency = Frequency::Yearly;
+            else return false;
+        } else if (equalsIgnoreCase(key, "INTERVAL")) {
+            if (!parseDigits(value, rule.interval) || rule.interval < 1) return false;
+        } else if (equalsIgnoreCase(key, "COUNT")) {
+            int count;
+            if (!parseDigits(value, count)) return false;
+            rule.count = count;
+        } else if (equalsIgnoreCase(key, "UNTIL")) {
+            DateTime until;
+            if (!parseDateTime(value, until)) return false;
+            // A date alone keeps every occurrence on that day.
+            rule.until = until.dateOnly ? until.minute() + MINUTES_PER_DAY - 1 : until.minute();
+        } else if (equalsIgnoreCase(key, "BYDAY")) {
+            while (!value.empty()) {
+                size_t comma = value.find(',');
+                string_view code = trim(value.substr(0, comma));
+                value = comma == string_view::npos ? string_view() : value.substr(comma + 1);
+                int found = -1;
+                for (int d = 0; d < 7; ++d)
+                    if (equalsIgnoreCase(code, DAYS[d])) found = d;
+                if (found < 0) return false; // "2TU", "-1FR": ordinals are not supported
+                rule.weekdays |= (uint8_t)(1 << found);
+            }
+        } else if (equalsIgnoreCase(key, "WKST")) {
+            // Only matters for weekly rules with an interval and BYDAY; Monday is assumed.
+        } else {
+            return false; // BYMONTHDAY, BYSETPOS, BYHOUR, ...
+        }
+    }
+    return rule.frequency != Frequency::None &&
+           (rule.weekdays == 0 || rule.frequency == Frequency::Daily || rule.frequency == Frequency::Weekly);
+}
+
+struct Event {
+    DateTime start;
+    DateTime end;
+    bool hasStart = false;
+    bool hasEnd = false;
+    int64_t length = -1;         // minutes, from DTEND or DURATION
+    Recurrence rule;
+    bool unsupported = false;    // RRULE not understood
+    vector<DateTime> exceptions; // EXDATEs and instances moved elsewhere
+    string uid;
+    DateTime recurrenceId;
+    bool hasRecurrenceId = false;
+};
+
+// One property line: NAME;PARAM=...;PARAM=...:VALUE
+struct Property {
+    string_view name;
+    string_view params;
+    string_view value;
+};
+
+bool splitProperty(string_view line, Property &p) {
+    size_t i = 0;
+    while (i < line.size() && line[i] != ';' && line[i] != ':') ++i;
+    if (i == line.size()) return false;
+    p.name = line.substr(0, i);
+    size_t paramsBegin = i;
+    bool quoted = false;
+    for (; i < line.size(); ++i) {
+        if (line[i] == '"') quoted = !quoted;
+        else if (line[i] == ':' && !quoted) break;
+    }
+    if (i == line.size()) return false;
+    p.params = line.substr(paramsBegin, i - paramsBegin);
+    p.value = line.substr(i + 1);
+    return true;
+}
+
+// Logical lines of a text with folded lines joined again.
+class LineReader {
+public:
+    explicit LineReader(string_view t) : text(t) {}
+
+    bool next(string_view &line) {
+        if (pos >= text.size()) return false;
+        string_view first = physical();
+        if (pos >= text.size() || (text[pos] != ' ' && text[pos] != '\t')) {
+            line = first;
+            return true;
+        }
+        joined.assign(first.data(), first.size());
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) {
+            string_view more = physical();
+            joined.append(more.data() + 1, more.size() - 1);
+        }
+        line = joined;
+        return true;
+    }
+
+private:
+    string_view text;
+    size_t pos = 0;
+    string joined;
+
+    string_view physical() {
+        size_t end = text.find('\n', pos);
+        if (end == string_view::npos) end = text.size();
+        string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        return line;
+    }
+};
+
+bool excluded(const Event &e, int64_t start) {
+    for (const DateTime &x : e.exceptions)
+        if (x.dateOnly ? start / MINUTES_PER_DAY == x.day : start == x.minute()) return true;
+    return false;
+}
+
+// Adds e's occurrences overlapping [windowStart, windowEnd) to busy, relative to windowStart.
+void expand(const Event &e, int64_t windowStart, int64_t windowEnd, vector<TimeInterval> &busy) {
+    int64_t remaining = e.rule.count;
+    // Returns false once no later occurrence can matter.
+    auto occurrence = [&](int64_t start) {
+        if (start >= windowEnd || start > e.rule.until || remaining == 0) return false;
+        if (remaining > 0) --remaining;
+        int64_t end = start + e.length;
+        if (end > windowStart && !excluded(e, start))
+            busy.push_back({(uint32_t)(max(start, windowStart) - windowStart), (uint32_t)(min(end, windowEnd) - windowStart)});
+        return true;
+    };
+
+    const DateTime &s = e.start;
+    int64_t interval = e.rule.interval;
+    switch (e.rule.frequency) {
+    case Frequency::None:
+        occurrence(s.minute());
+        break;
+    case Frequency::Daily: {
+        int64_t first = 0;
+        // Without a count the occurrences before the window need not be walked.
+        if (remaining < 0 && e.rule.weekdays == 0) {
+            int64_t behind = windowStart - e.length - s.minute();
+            if (behind > 0) first = behind / (interval * MINUTES_PER_DAY);
+        }
+        for (int64_t k = first;; ++k) {
+            int64_t day = s.day + k * interval;
+            if (e.rule.weekdays && !(e.rule.weekdays & (1 << weekday(day)))) {
+                if (day * MINUTES_PER_DAY >= windowEnd) break;
+                continue;
+            }
+            if (!occurrence(day * MINUTES_PER_DAY + s.minuteOfDay)) break;
+        }
+        break;
+    }
+    case Frequency::Weekly: {
+        uint8_t days = e.rule.weekdays ? e.rule.weekdays : (uint8_t)(1 << weekday(s.day));
+        int64_t monday = s.day - weekday(s.day);
+        int64_t first = 0;
+        if (remaining < 0) {
+            int64_t behind = windowStart - e.length - (monday * MINUTES_PER_DAY + s.minuteOfDay);
+            if (behind > 0) first = behind / (interval * 7 * MINUTES_PER_DAY);
+        }
+        for (int64_t k = first;; ++k) {
+            int64_t week = monday + k * interval * 7;
+            bool more = true;
+            for (int d = 0; d < 7 && more; ++d)
+                if ((days & (1 << d)) && week + d >= s.day) more = occurrence((week + d) * MINUTES_PER_DAY + s.minuteOfDay);
+            if (!more || week * MINUTES_PER_DAY >= windowEnd) break;
+        }
+        break;
+    }
+    case Frequency::Monthly:
+    case Frequency::Yearly: {
+        int64_t step = e.rule.frequency == Frequency::Monthly ? interval : interval * 12;
+        for (int64_t k = 0;; ++k) {
+            int64_t months = (int64_t)s.date.month - 1 + k * step;
+            CivilDate d{s.date.year + (int)(months / 12), (int)(months % 12) + 1, 1};
+            if (daysFromCivil(d) * MINUTES_PER_DAY >= windowEnd) break;
+            // Dates that do not exist in a month (the 31st, 29 February) are skipped, not counted.
+            if (s.date.day > daysInMonth(d.year, d.month)) continue;
+            d.day = s.date.day;
+            if (!occurrence(daysFromCivil(d) * MINUTES_PER_DAY + s.minuteOfDay)) break;
+        }
+        break;
+    }
+    }
+}
+}
+
+int64_t daysFromCivil(const CivilDate &date) {
+    // Howard Hinnant's days_from_civil.
+    int64_t y = date.year - (date.month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (date.month + (date.month > 2 ? -3 : 9)) + 2) / 5 + date.day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+CivilDate civilFromDays(int64_t days) {
+    // Howard Hinnant's civil_from_days.
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    CivilDate date;
+    date.day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    date.month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    date.year = (int)(yoe + era * 400 + (date.month <= 2));
+    return date;
+}
+
+bool parseCivilDate(string_view text, CivilDate &date) {
+    text = trim(text);
+    string digits;
+    if (text.size() == 10 && text[4] == '-' && text[7] == '-') {
+        digits.append(text.substr(0, 4)).append(text.substr(5, 2)).append(text.substr(8, 2));
+        text = digits;
+    }
+    DateTime dt;
+    if (text.size() != 8 || !parseDateTime(text, dt)) return false;
+    date = dt.date;
+    return true;
+}
+
+bool parseCalendar(string_view text, const CivilDate &planStart, int days, vector<TimeInterval> &busy,
+                   string &error, CalendarImportStats *stats) {
+    busy.clear();
+    CalendarImportStats counts;
+    vector<Event> events;
+    Event event;
+    bool inCalendar = false, inEvent = false, blocks = true;
+    int nested = 0; // components inside the event, e.g. VALARM
+    LineReader reader(text);
+    string_view line;
+    Property p;
+    while (reader.next(line)) {
+        if (!splitProperty(line, p)) continue;
+        if (equalsIgnoreCase(p.name, "BEGIN")) {
+            if (equalsIgnoreCase(trim(p.value), "VCALENDAR")) inCalendar = true;
+            else if (inEvent) ++nested;
+            else if (equalsIgnoreCase(trim(p.value), "VEVENT")) {
+                inEvent = true;
+                blocks = true;
+                event = Event();
+            }
+            continue;
+        }
+        if (!inEvent) continue;
+        if (equalsIgnoreCase(p.name, "END")) {
+            if (nested > 0) {
+                --nested;
+                continue;
+            }
+            inEvent = false;
+            if (!blocks || !event.hasStart) continue;
+            if (event.hasEnd) event.length = event.end.minute() - event.start.minute();
+            else if (event.length < 0) event.length = event.start.dateOnly ? MINUTES_PER_DAY : 0;
+            if (event.length <= 0) continue;
+            if (event.unsupported) {
+                counts.unsupported++;
+                continue;
+            }
+            counts.events++;
+            events.push_back(move(event));
+            continue;
+        }
+        if (nested > 0) continue;
+
+        bool dateValue = p.params.find("VALUE=DATE") != string_view::npos &&
+                         p.params.find("VALUE=DATE-TIME") == string_view::npos;
+        if (equalsIgnoreCase(p.name, "DTSTART")) {
+            event.hasStart = parseDateTime(p.value, event.start);
+            if (dateValue) event.start.minuteOfDay = 0, event.start.dateOnly = true;
+        } else if (equalsIgnoreCase(p.name, "DTEND")) {
+            event.hasEnd = parseDateTime(p.value, event.end);
+            if (dateValue) event.end.minuteOfDay = 0;
+        } else if (equalsIgnoreCase(p.name, "DURATION")) {
+            if (!parseDuration(p.value, event.length)) blocks = false;
+        } else if (equalsIgnoreCase(p.name, "RRULE")) {
+            event.unsupported = !parseRule(p.value, event.rule);
+        } else if (equalsIgnoreCase(p.name, "EXDATE")) {
+            string_view list = p.value;
+            while (!list.empty()) {
+                size_t comma = list.find(',');
+                DateTime x;
+                if (parseDateTime(list.substr(0, comma), x)) {
+                    if (dateValue) x.dateOnly = true;
+                    event.exceptions.push_back(x);
+                }
+                list = comma == string_view::npos ? string_view() : list.substr(comma + 1);
+            }
+        } else if (equalsIgnoreCase(p.name, "RECURRENCE-ID")) {
+            event.hasRecurrenceId = parseDateTime(p.value, event.recurrenceId);
+        } else if (equalsIgnoreCase(p.name, "UID")) {
+            event.uid.assign(trim(p.value));
+        } else if (equalsIgnoreCase(p.name, "TRANSP")) {
+            if (equalsIgnoreCase(trim(p.value), "TRANSPARENT")) blocks = false;
+        } else if (equalsIgnoreCase(p.name, "STATUS")) {
+            if (equalsIgnoreCase(trim(p.value), "CANCELLED")) blocks = false;
+        }
+    }
+    if (!inCalendar) {
+        error = "not an iCalendar file (no BEGIN:VCALENDAR)";
+        return false;
+    }
+
+    // An event with a RECURRENCE-ID replaces one instance of its series.
+    unordered_map<string_view, size_t> series;
+    for (size_t i = 0; i < events.size(); ++i)
+        if (!events[i].hasRecurrenceId && events[i].rule.frequency != Frequency::None && !events[i].uid.empty())
+            series.emplace(events[i].uid, i);
+    for (const Event &e : events) {
+        if (!e.hasRecurrenceId) continue;
+        auto it = series.find(e.uid);
+        if (it != series.end()) events[it->second].exceptions.push_back(e.recurrenceId);
+    }
+
+    int64_t windowStart = daysFromCivil(planStart) * MINUTES_PER_DAY;
+    int64_t windowEnd = windowStart + (int64_t)max(days, 0) * MINUTES_PER_DAY;
+    for (const Event &e : events) expand(e, windowStart, windowEnd, busy);
+    counts.intervals = busy.size();
+    if (stats) *stats = counts;
+    return true;
+}
+
+bool readCalendar(const string &path, const CivilDate &planStart, int days, vector<TimeInterval> &busy,
+                  string &error, CalendarImportStats *stats) {
+    MappedFile in;
+    if (!in.open(path, error, true)) return false;
+    if (!parseCalendar(in.view(), planStart, days, busy, error, stats)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+// Calendar.h
+//  Busy periods from a local iCalendar (.ics) file: classes, shifts and
+//  other commitments that study sessions must not overlap. Recurring events
+//  are expanded over the plan, so the result is a flat list of minute
+//  intervals counted from midnight of the plan's first day.
+
+#pragma once
+
+#include "IntervalTree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CivilDate {
+    int year = 1970;
+    int month = 1; // 1-12
+    int day = 1;   // 1-31
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date.
+int64_t daysFromCivil(const CivilDate &date);
+// The inverse of daysFromCivil().
+CivilDate civilFromDays(int64_t days);
+
+// "YYYY-MM-DD" (or "YYYYMMDD"); false when it is not a valid date.
+bool parseCivilDate(std::string_view text, CivilDate &date);
+
+struct CalendarImportStats {
+    size_t events = 0;      // VEVENTs that block time
+    size_t intervals = 0;   // busy intervals inside the plan, after expansion
+    size_t unsupported = 0; // events skipped for a recurrence rule not understood
+};
+
+// Reads the VEVENTs of an iCalendar text into busy, replacing its contents,
+// clipped to the days [0, days) from planStart. Times are taken as the
+// wall-clock time written in the file: TZID parameters and the UTC 'Z'
+// suffix are not converted. Events marked TRANSP:TRANSPARENT or
+// STATUS:CANCELLED are ignored. Recurrence follows RRULE with FREQ
+// DAILY/WEEKLY/MONTHLY/YEARLY, INTERVAL, COUNT, UNTIL and BYDAY (plain
+// weekdays, for daily and weekly rules), less EXDATEs and the instances
+// moved by a RECURRENCE-ID event. Returns false only when text is not an
+// iCalendar at all.
+bool parseCalendar(std::string_view text, const CivilDate &planStart, int days, std::vector<TimeInterval> &busy,
+                   std::string &error, CalendarImportStats *stats = nullptr);
+
+// parseCalendar() on the memory-mapped file at path.
+bool readCalendar(const std::string &path, const CivilDate &planStart, int days, std::vector<TimeInterval> &busy,
+                  std::string &error, CalendarImportStats *stats = nullptr);
@@ -0,0 +1,44 @@
+// ClockPlacement.cpp
+
+#include "ClockPlacement.h"
+#include "PerfStats.h"
+
+#include <algorithm>
+
+using namespace std;
+
+size_t ClockPlacer::place(const Schedule &schedule, const ClockSettings &settings, vector<uint16_t> &starts) const {
+    PerfScope perf(PerfProbe::Place);
+    const vector<ScheduleSlot> &slots = schedule.allSlots();
+    starts.assign(slots.size(), NO_CLOCK_TIME);
+    int dayStart = min(max(settings.dayStartMinute, 0), MINUTES_PER_DAY);
+    int dayEnd = min(max(settings.dayEndMinute, dayStart), MINUTES_PER_DAY);
+    uint32_t pause = (uint32_t)max(settings.breakMinutes, 0);
+    size_t placed = 0;
+    for (int d = 0; d < schedule.dayCount(); ++d) {
+        uint32_t midnight = (uint32_t)d * MINUTES_PER_DAY;
+        uint32_t cursor = midnight + (uint32_t)dayStart;
+        uint32_t limit = midnight + (uint32_t)dayEnd;
+        for (uint32_t i = schedule.dayOffset(d); i < schedule.dayOffset(d + 1); ++i) {
+            uint32_t length = slots[i].minutes;
+            if (cursor + length > limit) continue;
+            uint32_t at = tree.empty() ? cursor : tree.firstFree(cursor, length);
+            if (at + length > limit) continue;
+            starts[i] = (uint16_t)(at - midnight);
+            cursor = at + length + pause;
+            ++placed;
+        }
+    }
+    perf.addItems(placed);
+    return placed;
+}
+
+size_t formatClockTo(char *buf, int minuteOfDay) {
+    int h = minuteOfDay / 60, m = minuteOfDay % 60;
+    buf[0] = (char)('0' + h / 10);
+    buf[1] = (char)('0' + h % 10);
+    buf[2] = ':';
+    buf[3] = (char)('0' + m / 10);
+    buf[4] = (char)('0' + m % 10);
+    return 5;
+}
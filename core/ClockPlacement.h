@@ -0,0 +1,45 @@
+// ClockPlacement.h
+//  Turns each day's slots into clock times: sessions follow one another in
+//  plan order from the start of the study hours, with a break after each,
+//  and are moved past busy periods (classes, shifts) instead of overlapping
+//  them. Busy periods live in an interval tree, so a placement costs
+//  O(log n) per session and per busy stretch it has to skip.
+
+#pragma once
+
+#include "IntervalTree.h"
+#include "Schedule.h"
+#include "ScheduleConfig.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Start of a slot that did not fit into its day's study hours.
+static constexpr uint16_t NO_CLOCK_TIME = UINT16_MAX;
+
+struct ClockSettings {
+    int dayStartMinute = DEFAULT_DAY_START_MINUTE; // minutes after midnight
+    int dayEndMinute = DEFAULT_DAY_END_MINUTE;     // no session ends later
+    int breakMinutes = DEFAULT_BREAK_MINUTES;      // after every session
+};
+
+class ClockPlacer {
+public:
+    // Busy periods as minutes from midnight of day 0, e.g. from readCalendar().
+    void setBusy(const std::vector<TimeInterval> &busy) { tree.assign(busy); }
+    const IntervalTree &busy() const { return tree; }
+
+    // Fills starts with the start of every slot of schedule (same order as
+    // allSlots()) in minutes after midnight of its day, or NO_CLOCK_TIME
+    // when it did not fit; a slot that does not fit leaves the time for the
+    // next one. Returns the number of slots placed. Does not allocate once
+    // starts has room for the schedule.
+    size_t place(const Schedule &schedule, const ClockSettings &settings, std::vector<uint16_t> &starts) const;
+
+private:
+    IntervalTree tree;
+};
+
+// "HH:MM" into buf (at least 5 bytes, not NUL-terminated); returns the length.
+size_t formatClockTo(char *buf, int minuteOfDay);
@@ -0,0 +1,298 @@
+// CohortAnalytics.cpp
+
+#include "CohortAnalytics.h"
+#include "ColumnKernels.h"
+#include "Json.h"
+#include "PerfStats.h"
+#include "ScheduleGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+// Largest value summarized with a counting histogram (4 MiB of counters);
+// anything larger is selected from a sorted copy.
+constexpr uint32_t COUNTING_LIMIT = 1u << 20;
+
+// 0-based position of the nearest-rank percentile p of n values.
+uint64_t percentileRank(uint64_t n, unsigned p) { return n == 0 ? 0 : (n * p + 99) / 100 - 1; }
+}
+
+void CohortAnalytics::clear() {
+    cols.dayMinutes.clear();
+    cols.dayDifficulty.clear();
+    cols.dayTopics.clear();
+    cols.dayStart.clear();
+    cols.subjectId.clear();
+    cols.subjectMinutes.clear();
+    cols.subjectCovered.clear();
+    cols.subjectTopics.clear();
+    cols.subjectNames.clear();
+    nameIds.clear();
+    names = nullptr;
+}
+
+uint32_t CohortAnalytics::internName(const string &name) {
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+    uint32_t id = (uint32_t)cols.subjectNames.size();
+    cols.subjectNames.push_back(name);
+    nameIds.emplace(name, id);
+    return id;
+}
+
+void CohortAnalytics::beginSchedule(const ScheduleNames &n) {
+    names = &n;
+    if (cols.dayStart.empty()) cols.dayStart.push_back(0);
+    openMinutes.assign(n.subjects.size(), 0);
+    openCovered.assign(n.subjects.size(), 0);
+    topicSeen.assign(n.topics.size(), 0);
+}
+
+void CohortAnalytics::addDay(Schedule::DayView slots, const DayStats &stats) {
+    cols.dayMinutes.push_back((uint32_t)max(stats.minutes, 0));
+    cols.dayDifficulty.push_back((uint32_t)max(stats.difficultySum, 0));
+    cols.dayTopics.push_back((uint32_t)max(stats.topicCount, 0));
+    for (const ScheduleSlot &t : slots) {
+        if (t.subject >= openMinutes.size() || t.topic >= topicSeen.size()) continue;
+        openMinutes[t.subject] += t.minutes;
+        if (t.kind == SlotKind::Study && !topicSeen[t.topic]) {
+            topicSeen[t.topic] = 1;
+            openCovered[t.subject]++;
+        }
+    }
+}
+
+void CohortAnalytics::endSchedule() {
+    if (!names) return;
+    for (size_t i = 0; i < openMinutes.size(); ++i) {
+        cols.subjectId.push_back(internName(names->subjects[i]));
+        cols.subjectMinutes.push_back(openMinutes[i]);
+        cols.subjectCovered.push_back(openCovered[i]);
+        cols.subjectTopics.push_back(names->topicBase[i + 1] - names->topicBase[i]);
+    }
+    cols.dayStart.push_back((uint32_t)cols.dayMinutes.size());
+    names = nullptr;
+}
+
+void CohortAnalytics::add(const Schedule &schedule) {
+    if (!schedule.nameTables()) return;
+    beginSchedule(*schedule.nameTables());
+    for (int d = 0; d < schedule.dayCount(); ++d) addDay(schedule.day(d), schedule.dayStats(d));
+    endSchedule();
+}
+
+void CohortAnalytics::merge(const CohortAnalytics &other) {
+    const CohortColumns &o = other.cols;
+    if (o.scheduleCount() == 0) return;
+    if (cols.dayStart.empty()) cols.dayStart.push_back(0);
+    uint32_t rowBase = (uint32_t)cols.dayMinutes.size();
+    cols.dayMinutes.insert(cols.dayMinutes.end(), o.dayMinutes.begin(), o.dayMinutes.end());
+    cols.dayDifficulty.insert(cols.dayDifficulty.end(), o.dayDifficulty.begin(), o.dayDifficulty.end());
+    cols.dayTopics.insert(cols.dayTopics.end(), o.dayTopics.begin(), o.dayTopics.end());
+    for (size_t s = 1; s < o.dayStart.size(); ++s) cols.dayStart.push_back(rowBase + o.dayStart[s]);
+
+    // Subject ids are local to each cohort, so other's are mapped onto ours.
+    vector<uint32_t> ids(o.subjectNames.size());
+    for (size_t k = 0; k < ids.size(); ++k) ids[k] = internName(o.subjectNames[k]);
+    for (uint32_t id : o.subjectId) cols.subjectId.push_back(ids[id]);
+    cols.subjectMinutes.insert(cols.subjectMinutes.end(), o.subjectMinutes.begin(), o.subjectMinutes.end());
+    cols.subjectCovered.insert(cols.subjectCovered.end(), o.subjectCovered.begin(), o.subjectCovered.end());
+    cols.subjectTopics.insert(cols.subjectTopics.end(), o.subjectTopics.begin(), o.subjectTopics.end());
+}
+
+bool CohortAnalytics::summarize(const vector<uint32_t> &column, CohortDistribution &out) {
+    out = CohortDistribution();
+    size_t n = column.size();
+    if (n == 0) return false;
+    out.count = n;
+    out.mean = (double)columnSum(column.data(), n) / (double)n;
+    out.max = columnMax(column.data(), n);
+    uint32_t *ranked[3] = {&out.p50, &out.p90, &out.p99};
+    const unsigned percents[3] = {50, 90, 99};
+    if (out.max < COUNTING_LIMIT) {
+        // Metrics are small integers (minutes in a day, permille), so one
+        // counting pass gives every percentile exactly.
+        counts.assign((size_t)out.max + 1, 0);
+        columnHistogram(column.data(), n, 1, counts.data(), counts.size());
+        for (int k = 0; k < 3; ++k) *ranked[k] = histogramValueAt(counts.data(), counts.size(), percentileRank(n, percents[k]));
+        return true;
+    }
+    sorted.assign(column.begin(), column.end());
+    for (int k = 0; k < 3; ++k) {
+        auto at = sorted.begin() + (ptrdiff_t)percentileRank(n, percents[k]);
+        nth_element(sorted.begin(), at, sorted.end());
+        *ranked[k] = *at;
+    }
+    return false;
+}
+
+void CohortAnalytics::report(CohortReport &out) {
+    PerfScope perf(PerfProbe::Cohort);
+    size_t schedules = cols.scheduleCount();
+    size_t days = cols.dayMinutes.size();
+    perf.addItems(days);
+    out.schedules = schedules;
+    out.days = days;
+    out.totalMinutes = columnSum(cols.dayMinutes.data(), days);
+
+    out.loadHistogram.assign(COHORT_LOAD_BUCKETS, 0);
+    if (summarize(cols.dayMinutes, out.dayMinutes)) {
+        // The per-minute counts fold into the load buckets without another
+        // pass over the days.
+        size_t last = out.loadHistogram.size() - 1;
+        for (size_t v = 0; v < counts.size(); ++v)
+            out.loadHistogram[min(v / COHORT_LOAD_BUCKET_MINUTES, last)] += counts[v];
+    } else {
+        columnHistogram(cols.dayMinutes.data(), days, COHORT_LOAD_BUCKET_MINUTES, out.loadHistogram.data(),
+                        out.loadHistogram.size());
+    }
+    summarize(cols.dayDifficulty, out.dayDifficulty);
+
+    // Per-schedule metrics: each schedule's days are one contiguous slice
+    // of the day columns.
+    derived.resize(schedules);
+    for (size_t s = 0; s < schedules; ++s) {
+        uint32_t b = cols.dayStart[s];
+        derived[s] = columnMax(cols.dayMinutes.data() + b, cols.dayStart[s + 1] - b);
+    }
+    summarize(derived, out.peakMinutes);
+    for (size_t s = 0; s < schedules; ++s) {
+        uint32_t b = cols.dayStart[s];
+        derived[s] = columnMax(cols.dayDifficulty.data() + b, cols.dayStart[s + 1] - b);
+    }
+    summarize(derived, out.peakDifficulty);
+    for (size_t s = 0; s < schedules; ++s) {
+        // Coefficient of variation of the daily load: sqrt(n·Σx² − (Σx)²) / Σx.
+        uint32_t b = cols.dayStart[s];
+        uint64_t n = cols.dayStart[s + 1] - b;
+        uint64_t sum = columnSum(cols.dayMinutes.data() + b, n);
+        uint64_t squares = columnSumSquares(cols.dayMinutes.data() + b, n);
+        double spread = sum > 0 ? sqrt((double)(n * squares - sum * sum)) / (double)sum : 0.0;
+        derived[s] = (uint32_t)llround(spread * 1000.0);
+    }
+    summarize(derived, out.imbalance);
+
+    // Coverage of every subject row, then grouped by subject name.
+    size_t rows = cols.subjectId.size();
+    derived.resize(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        uint32_t topics = cols.subjectTopics[r];
+        derived[r] = topics ? (uint32_t)((uint64_t)cols.subjectCovered[r] * 1000 / topics) : 0;
+    }
+    summarize(derived, out.coverage);
+
+    size_t subjects = cols.subjectNames.size();
+    vector<uint64_t> &minutes = subjectSums, &coverage = coverageSums;
+    minutes.assign(subjects, 0);
+    coverage.assign(subjects, 0);
+    out.subjects.resize(subjects);
+    for (size_t k = 0; k < subjects; ++k) {
+        out.subjects[k] = CohortSubjectSummary();
+        out.subjects[k].name = cols.subjectNames[k];
+        out.subjects[k].minCoverage = UINT32_MAX;
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        uint32_t id = cols.subjectId[r];
+        CohortSubjectSummary &sub = out.subjects[id];
+        sub.schedules++;
+        minutes[id] += cols.subjectMinutes[r];
+        coverage[id] += derived[r];
+        sub.minCoverage = min(sub.minCoverage, derived[r]);
+    }
+    for (size_t k = 0; k < subjects; ++k) {
+        CohortSubjectSummary &sub = out.subjects[k];
+        if (sub.schedules == 0) {
+            sub.minCoverage = 0;
+            continue;
+        }
+        sub.meanMinutes = (double)minutes[k] / sub.schedules;
+        sub.meanCoverage = (double)coverage[k] / sub.schedules;
+    }
+    sort(out.subjects.begin(), out.subjects.end(),
+         [](const CohortSubjectSummary &a, const CohortSubjectSummary &b) { return a.name < b.name; });
+}
+
+void generateCohort(WorkStealingPool &pool, const vector<BatchJob> &jobs, CohortAnalytics &cohort) {
+    // One generator and one partial cohort per worker, merged in worker
+    // order at the end; the report does not depend on that order.
+    vector<ScheduleGenerator> generators;
+    generators.reserve(pool.size());
+    while (generators.size() < pool.size()) generators.emplace_back(DEFAULT_DAYS, DEFAULT_MINUTES_PER_DAY);
+    vector<CohortAnalytics> parts(pool.size());
+    for (const BatchJob &job : jobs) {
+        pool.submit([&generators, &parts, &job](unsigned worker) {
+            ScheduleGenerator &gen = generators[worker];
+            CohortAnalytics &part = parts[worker];
+            loadPlan(gen, job.plan);
+            gen.prepare();
+            part.beginSchedule(*gen.nameTables());
+            while (gen.nextDay()) part.addDay(gen.currentDay(), gen.currentDayStats());
+            part.endSchedule();
+        });
+    }
+    pool.wait();
+    for (const CohortAnalytics &part : parts) cohort.merge(part);
+}
+
+namespace {
+void appendDistribution(string &out, const char *key, const CohortDistribution &d) {
+    out += ",\"";
+    out += key;
+    out += "\":{\"count\":";
+    appendJsonNumber(out, d.count);
+    out += ",\"mean\":";
+    appendJsonDecimal(out, d.mean);
+    out += ",\"p50\":";
+    appendJsonNumber(out, d.p50);
+    out += ",\"p90\":";
+    appendJsonNumber(out, d.p90);
+    out += ",\"p99\":";
+    appendJsonNumber(out, d.p99);
+    out += ",\"max\":";
+    appendJsonNumber(out, d.max);
+    out += '}';
+}
+}
+
+void appendCohortJson(string &out, const CohortReport &report) {
+    out += "{\"schedules\":";
+    appendJsonNumber(out, report.schedules);
+    out += ",\"days\":";
+    appendJsonNumber(out, report.days);
+    out += ",\"total_minutes\":";
+    appendJsonNumber(out, report.totalMinutes);
+    appendDistribution(out, "day_minutes", report.dayMinutes);
+    appendDistribution(out, "day_difficulty", report.dayDifficulty);
+    out += ",\"load_histogram\":{\"bucket_minutes\":";
+    appendJsonNumber(out, COHORT_LOAD_BUCKET_MINUTES);
+    out += ",\"days\":[";
+    for (size_t k = 0; k < report.loadHistogram.size(); ++k) {
+        if (k > 0) out += ',';
+        appendJsonNumber(out, report.loadHistogram[k]);
+    }
+    out += "]}";
+    appendDistribution(out, "peak_day_minutes", report.peakMinutes);
+    appendDistribution(out, "peak_day_difficulty", report.peakDifficulty);
+    appendDistribution(out, "imbalance_permille", report.imbalance);
+    appendDistribution(out, "coverage_permille", report.coverage);
+    out += ",\"subjects\":[";
+    for (size_t k = 0; k < report.subjects.size(); ++k) {
+        const CohortSubjectSummary &s = report.subjects[k];
+        if (k > 0) out += ',';
+        out += "{\"name\":";
+        appendJsonString(out, s.name);
+        out += ",\"schedules\":";
+        appendJsonNumber(out, s.schedules);
+        out += ",\"mean_minutes\":";
+        appendJsonDecimal(out, s.meanMinutes);
+        out += ",\"mean_coverage_permille\":";
+        appendJsonDecimal(out, s.meanCoverage);
+        out += ",\"min_coverage_permille\":";
+        appendJsonNumber(out, s.minCoverage);
+        out += '}';
+    }
+    out += "]}";
+}
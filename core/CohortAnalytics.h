@@ -0,0 +1,122 @@
+// CohortAnalytics.h
+//  Cohort reports over many generated schedules: daily load distribution,
+//  peak-day difficulty, imbalance and per-subject coverage. Every schedule
+//  appends its per-day and per-subject metrics to columns (one array per
+//  metric, not one record per day), so the report is a handful of passes
+//  of the ColumnKernels reductions over contiguous memory.
+
+#pragma once
+
+#include "Schedule.h"
+#include "ScheduleIO.h"
+#include "WorkStealingPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Width of the daily load histogram buckets; the last bucket takes
+// everything from the full day on.
+static constexpr uint32_t COHORT_LOAD_BUCKET_MINUTES = 30;
+static constexpr size_t COHORT_LOAD_BUCKETS = MINUTES_PER_DAY / COHORT_LOAD_BUCKET_MINUTES + 1;
+
+struct CohortColumns {
+    // One row per day of every schedule, schedules one after another.
+    std::vector<uint32_t> dayMinutes;
+    std::vector<uint32_t> dayDifficulty; // difficulty sum of the day's slots
+    std::vector<uint32_t> dayTopics;     // slots on the day
+    std::vector<uint32_t> dayStart;      // per schedule, then the total: first row of its days
+
+    // One row per subject of every schedule.
+    std::vector<uint32_t> subjectId;      // into subjectNames
+    std::vector<uint32_t> subjectMinutes; // study and review minutes
+    std::vector<uint32_t> subjectCovered; // distinct topics studied
+    std::vector<uint32_t> subjectTopics;  // topics of the subject
+    std::vector<std::string> subjectNames; // cohort-wide, by first appearance
+
+    size_t scheduleCount() const { return dayStart.empty() ? 0 : dayStart.size() - 1; }
+};
+
+// Nearest-rank summary of one metric.
+struct CohortDistribution {
+    uint64_t count = 0;
+    double mean = 0.0;
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+};
+
+struct CohortSubjectSummary {
+    std::string name;
+    uint32_t schedules = 0;      // schedules with this subject
+    double meanMinutes = 0.0;
+    uint32_t minCoverage = 0;    // permille of its topics studied
+    double meanCoverage = 0.0;   // permille
+};
+
+struct CohortReport {
+    size_t schedules = 0;
+    size_t days = 0;                 // over all schedules
+    uint64_t totalMinutes = 0;
+    CohortDistribution dayMinutes;    // daily load, over every day
+    CohortDistribution dayDifficulty; // daily difficulty sum, over every day
+    std::vector<uint32_t> loadHistogram; // days per COHORT_LOAD_BUCKET_MINUTES of daily load
+    CohortDistribution peakMinutes;    // per schedule: its busiest day
+    CohortDistribution peakDifficulty; // per schedule: its hardest day
+    CohortDistribution imbalance;  // per schedule: std dev / mean of daily load, permille
+    CohortDistribution coverage;   // per subject of every schedule: topics studied, permille
+    std::vector<CohortSubjectSummary> subjects; // by name
+};
+
+class CohortAnalytics {
+public:
+    void clear();
+
+    // Appends one schedule, fed a day at a time as a lazy generator
+    // produces them: beginSchedule(), addDay() for every day, endSchedule().
+    void beginSchedule(const ScheduleNames &names);
+    void addDay(Schedule::DayView slots, const DayStats &stats);
+    void endSchedule();
+
+    void add(const Schedule &schedule);
+
+    // Appends the rows of other, e.g. one worker's share of a cohort.
+    void merge(const CohortAnalytics &other);
+
+    const CohortColumns &columns() const { return cols; }
+    size_t scheduleCount() const { return cols.scheduleCount(); }
+
+    // Fills report from the columns. Scratch buffers are kept, so
+    // reporting again on a cohort of similar size does not allocate.
+    void report(CohortReport &out);
+
+private:
+    CohortColumns cols;
+    std::unordered_map<std::string, uint32_t> nameIds;
+
+    // The schedule being added.
+    const ScheduleNames *names = nullptr;
+    std::vector<uint32_t> openMinutes; // per subject
+    std::vector<uint32_t> openCovered; // per subject
+    std::vector<uint8_t> topicSeen;    // per flat topic id
+
+    // Report scratch.
+    std::vector<uint32_t> derived; // a derived column: per schedule or per subject row
+    std::vector<uint32_t> counts;      // counting histogram
+    std::vector<uint32_t> sorted;      // for metrics too large to count
+    std::vector<uint64_t> subjectSums, coverageSums; // per subject name
+
+    uint32_t internName(const std::string &name);
+    // True when the percentiles came from a counting histogram, left in counts.
+    bool summarize(const std::vector<uint32_t> &column, CohortDistribution &out);
+};
+
+// Generates every job's plan on the pool and adds it to cohort, one lazy
+// generator and one partial cohort per worker; no schedule is kept.
+void generateCohort(WorkStealingPool &pool, const std::vector<BatchJob> &jobs, CohortAnalytics &cohort);
+
+// The report as one JSON object.
+void appendCohortJson(std::string &out, const CohortReport &report);
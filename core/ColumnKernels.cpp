@@ -0,0 +1,125 @@
+// ColumnKernels.cpp
+
+#include "ColumnKernels.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ADEXA_COLUMN_SSE2 1
+#include <emmintrin.h>
+#else
+#define ADEXA_COLUMN_SSE2 0
+#endif
+
+using namespace std;
+
+#if ADEXA_COLUMN_SSE2
+namespace {
+inline uint64_t horizontalSum(__m128i v) {
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v);
+    return lanes[0] + lanes[1];
+}
+}
+#endif
+
+uint64_t columnSum(const uint32_t *values, size_t n) {
+    size_t i = 0;
+    uint64_t sum = 0;
+#if ADEXA_COLUMN_SSE2
+    // Each group of four is widened to two pairs of 64-bit lanes.
+    const __m128i zero = _mm_setzero_si128();
+    __m128i low = zero, high = zero;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        low = _mm_add_epi64(low, _mm_unpacklo_epi32(v, zero));
+        high = _mm_add_epi64(high, _mm_unpackhi_epi32(v, zero));
+    }
+    sum = horizontalSum(_mm_add_epi64(low, high));
+#endif
+    for (; i < n; ++i) sum += values[i];
+    return sum;
+}
+
+uint64_t columnSumSquares(const uint32_t *values, size_t n) {
+    size_t i = 0;
+    uint64_t sum = 0;
+#if ADEXA_COLUMN_SSE2
+    // _mm_mul_epu32 squares lanes 0 and 2 into 64 bits; shifting by 32
+    // brings lanes 1 and 3 into their place.
+    __m128i even = _mm_setzero_si128(), odd = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i shifted = _mm_srli_epi64(v, 32);
+        even = _mm_add_epi64(even, _mm_mul_epu32(v, v));
+        odd = _mm_add_epi64(odd, _mm_mul_epu32(shifted, shifted));
+    }
+    sum = horizontalSum(_mm_add_epi64(even, odd));
+#endif
+    for (; i < n; ++i) sum += (uint64_t)values[i] * values[i];
+    return sum;
+}
+
+uint32_t columnMax(const uint32_t *values, size_t n) {
+    size_t i = 0;
+    uint32_t best = 0;
+#if ADEXA_COLUMN_SSE2
+    if (n >= 4) {
+        // SSE2 only compares signed lanes, so values are biased by 2^31.
+        const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+        __m128i top = _mm_set1_epi32((int)0x80000000u);
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)), bias);
+            __m128i greater = _mm_cmpgt_epi32(v, top);
+            top = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, top));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), _mm_xor_si128(top, bias));
+        best = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < n; ++i) best = max(best, values[i]);
+    return best;
+}
+
+void columnHistogram(const uint32_t *values, size_t n, uint32_t width, uint32_t *counts, size_t buckets) {
+    if (buckets == 0) return;
+    uint32_t last = (uint32_t)(buckets - 1);
+    width = max<uint32_t>(width, 1);
+    // A scatter does not vectorize without scatter instructions. Values are
+    // taken in pairs instead, and an equal pair (a cohort's many identical
+    // full days) is one increment of its counter rather than two dependent
+    // ones.
+    size_t i = 0;
+    if (width == 1) {
+        for (; i + 2 <= n; i += 2) {
+            uint32_t a = min(values[i], last), b = min(values[i + 1], last);
+            if (a == b) {
+                counts[a] += 2;
+            } else {
+                counts[a]++;
+                counts[b]++;
+            }
+        }
+    } else {
+        for (; i + 2 <= n; i += 2) {
+            uint32_t a = min(values[i] / width, last), b = min(values[i + 1] / width, last);
+            if (a == b) {
+                counts[a] += 2;
+            } else {
+                counts[a]++;
+                counts[b]++;
+            }
+        }
+    }
+    for (; i < n; ++i) counts[min(values[i] / width, last)]++;
+}
+
+uint32_t histogramValueAt(const uint32_t *counts, size_t buckets, uint64_t rank) {
+    uint64_t seen = 0;
+    for (size_t v = 0; v < buckets; ++v) {
+        seen += counts[v];
+        if (seen > rank) return (uint32_t)v;
+    }
+    return buckets ? (uint32_t)(buckets - 1) : 0;
+}
@@ -0,0 +1,30 @@
+// ColumnKernels.h
+//  Reductions over one column of unsigned 32-bit metrics (minutes,
+//  difficulty sums, counts), as laid out by CohortAnalytics. The sums and
+//  maxima run four lanes at a time with SSE2 where the target has it and
+//  fall back to plain loops elsewhere; both give identical results.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Sum of values[0, n), in 64 bits.
+uint64_t columnSum(const uint32_t *values, size_t n);
+
+// Sum of the squares of values[0, n), in 64 bits (wraps past 2^64, which
+// takes billions of full-day values).
+uint64_t columnSumSquares(const uint32_t *values, size_t n);
+
+// Largest of values[0, n), 0 when n is 0.
+uint32_t columnMax(const uint32_t *values, size_t n);
+
+// Adds every value to counts[min(value / width, buckets - 1)]: buckets of
+// width values each, the last one open-ended. width 1 is a counting
+// histogram. counts must hold buckets entries and is not cleared.
+void columnHistogram(const uint32_t *values, size_t n, uint32_t width, uint32_t *counts, size_t buckets);
+
+// Smallest v such that more than rank values of a counting histogram
+// (counts[v] values equal to v) are at most v, i.e. the value at 0-based
+// position rank in sorted order; buckets - 1 when rank is past the end.
+uint32_t histogramValueAt(const uint32_t *counts, size_t buckets, uint64_t rank);
@@ -0,0 +1,87 @@
+// CsvWriter.cpp
+
+#include "CsvWriter.h"
+#include "ClockPlacement.h"
+#include "ScheduleIO.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ostream>
+
+using namespace std;
+
+CsvWriter::CsvWriter(string &buffer, ostream *o, size_t flushBytes)
+    : buf(buffer), out(o), flushAt(flushBytes), pos(o ? 0 : buffer.size()) {}
+
+void CsvWriter::grow(size_t n) {
+    buf.resize(max({pos + n, buf.size() * 2, (size_t)4096}));
+}
+
+static bool needsQuotes(string_view text) {
+    for (char c : text)
+        if (c == ',' || c == '"' || c == '\n' || c == '\r') return true;
+    return false;
+}
+
+void CsvWriter::field(string_view text) {
+    field("", text);
+}
+
+void CsvWriter::field(string_view prefix, string_view text) {
+    separator();
+    if (!needsQuotes(prefix) && !needsQuotes(text)) {
+        char *p = reserve(prefix.size() + text.size());
+        memcpy(p, prefix.data(), prefix.size());
+        memcpy(p + prefix.size(), text.data(), text.size());
+        pos += prefix.size() + text.size();
+        return;
+    }
+    // Worst case every character is a quote that has to be doubled.
+    char *p = reserve((prefix.size() + text.size()) * 2 + 2);
+    char *start = p;
+    *p++ = '"';
+    for (string_view part : {prefix, text}) {
+        for (char c : part) {
+            if (c == '"') *p++ = '"';
+            *p++ = c;
+        }
+    }
+    *p++ = '"';
+    pos += (size_t)(p - start);
+}
+
+void CsvWriter::field(long long value) {
+    separator();
+    char *p = reserve(24);
+    pos += (size_t)(to_chars(p, p + 24, value).ptr - p);
+}
+
+void CsvWriter::timeField(int minutes) {
+    separator();
+    pos += formatTimeTo(reserve(32), minutes);
+}
+
+void CsvWriter::clockField(int minuteOfDay) {
+    separator();
+    pos += formatClockTo(reserve(5), minuteOfDay);
+}
+
+void CsvWriter::endRow() {
+    *reserve(1) = '\n';
+    ++pos;
+    rowStart = true;
+    if (out && pos >= flushAt) flush();
+}
+
+bool CsvWriter::flush() {
+    if (!out) {
+        buf.resize(pos);
+        return true;
+    }
+    if (pos > 0) {
+        out->write(buf.data(), (streamsize)pos);
+        pos = 0;
+    }
+    return bool(*out);
+}
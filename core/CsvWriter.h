@@ -0,0 +1,61 @@
+// CsvWriter.h
+//  RFC 4180 CSV output through one large reusable buffer
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class CsvWriter {
+public:
+    static constexpr size_t DEFAULT_FLUSH_BYTES = 1 << 20;
+
+    // With a stream, buffer is only scratch space: its old contents are
+    // discarded, rows are written out whenever it passes flushAt bytes (and
+    // on flush()), and its size is kept for the next writer. Without one,
+    // rows are appended to buffer, which holds exactly the text after
+    // flush() or destruction.
+    explicit CsvWriter(std::string &buffer, std::ostream *out = nullptr, size_t flushAt = DEFAULT_FLUSH_BYTES);
+    ~CsvWriter() { flush(); }
+
+    CsvWriter(const CsvWriter &) = delete;
+    CsvWriter &operator=(const CsvWriter &) = delete;
+
+    // Fields containing a comma, quote, CR or LF are quoted and inner quotes doubled.
+    void field(std::string_view text);
+    // prefix and text as one field, e.g. a review marker and a topic name.
+    void field(std::string_view prefix, std::string_view text);
+    void field(long long value);
+    // Same text as formatTime(), written without a temporary string.
+    void timeField(int minutes);
+    // "HH:MM", as formatClockTo().
+    void clockField(int minuteOfDay);
+    void endRow();
+
+    // Returns false once the stream has failed.
+    bool flush();
+
+private:
+    std::string &buf;
+    std::ostream *out;
+    size_t flushAt;
+    size_t pos;            // bytes written; buf.size() beyond pos is scratch
+    bool rowStart = true;
+
+    // Makes room for n more bytes and returns where they go.
+    char *reserve(size_t n) {
+        if (pos + n > buf.size()) grow(n);
+        return &buf[pos];
+    }
+    void grow(size_t n);
+
+    void separator() {
+        if (!rowStart) {
+            *reserve(1) = ',';
+            ++pos;
+        }
+        rowStart = false;
+    }
+};
@@ -0,0 +1,207 @@
+// EditHistory.cpp
+
+#include "EditHistory.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+bool sameDay(const ScheduleDaySnapshot &snap, Schedule::DayView day, const DayStats &stats) {
+    if (snap.items.size() != day.size() || snap.stats.difficultySum != stats.difficultySum ||
+        snap.stats.topicCount != stats.topicCount || snap.stats.minutes != stats.minutes)
+        return false;
+    const ScheduleSlot *t = day.begin();
+    for (const ScheduleSlot &s : snap.items) {
+        if (s.subject != t->subject || s.topic != t->topic || s.minutes != t->minutes || s.kind != t->kind) return false;
+        ++t;
+    }
+    return true;
+}
+
+const shared_ptr<const ScheduleSnapshot> &emptySchedule() {
+    static const shared_ptr<const ScheduleSnapshot> empty = make_shared<ScheduleSnapshot>();
+    return empty;
+}
+
+// Subjects not edited since base keep base's copy. Subjects usually stay
+// at their index, so base is searched by revision only when the subject
+// there is a different one, e.g. after a removal.
+PersistentArray<shared_ptr<const Subject>> snapshotSubjects(const vector<Subject> &subjects,
+                                                            const PersistentArray<shared_ptr<const Subject>> &base) {
+    vector<shared_ptr<const Subject>> items;
+    items.reserve(subjects.size());
+    unordered_map<uint64_t, const shared_ptr<const Subject> *> byRevision;
+    for (size_t i = 0; i < subjects.size(); ++i) {
+        const Subject &s = subjects[i];
+        if (i < base.size() && base[i]->getRevision() == s.getRevision()) {
+            items.push_back(base[i]);
+            continue;
+        }
+        if (i >= base.size() || base[i]->getName() != s.getName()) {
+            if (byRevision.empty())
+                for (size_t j = 0; j < base.size(); ++j) byRevision.emplace(base[j]->getRevision(), &base[j]);
+            auto it = byRevision.find(s.getRevision());
+            if (it != byRevision.end()) {
+                items.push_back(*it->second);
+                continue;
+            }
+        }
+        items.push_back(make_shared<const Subject>(s));
+    }
+    return PersistentArray<shared_ptr<const Subject>>::build(items, base);
+}
+
+// Days equal to the same day in base keep base's copy; the whole snapshot
+// is base itself when nothing changed.
+shared_ptr<const ScheduleSnapshot> snapshotSchedule(const Schedule &schedule, const shared_ptr<const ScheduleSnapshot> &base) {
+    if (schedule.empty()) return emptySchedule();
+
+    shared_ptr<const ScheduleNames> names = schedule.nameTables();
+    if (base->names && base->names != names && sameNames(*base->names, *names)) names = base->names;
+
+    vector<shared_ptr<const ScheduleDaySnapshot>> days;
+    days.reserve((size_t)schedule.dayCount());
+    for (int d = 0; d < schedule.dayCount(); ++d) {
+        Schedule::DayView day = schedule.day(d);
+        const DayStats &stats = schedule.dayStats(d);
+        if ((size_t)d < base->days.size() && sameDay(*base->days[(size_t)d], day, stats)) {
+            days.push_back(base->days[(size_t)d]);
+            continue;
+        }
+        auto snap = make_shared<ScheduleDaySnapshot>();
+        snap->items.assign(day.begin(), day.end());
+        snap->stats = stats;
+        days.push_back(move(snap));
+    }
+
+    auto out = make_shared<ScheduleSnapshot>();
+    out->days = PersistentArray<shared_ptr<const ScheduleDaySnapshot>>::build(days, base->days);
+    if (names == base->names && out->days.sameAs(base->days)) return base;
+    out->names = move(names);
+    out->slotCount = schedule.slotCount();
+    return out;
+}
+}
+
+void EditHistory::record(string label, const vector<Subject> &subjects, const Schedule &schedule,
+                         bool scheduleMatchesSubjects, int64_t calendarStart) {
+    EditState state;
+    state.label = move(label);
+    if (steps.empty()) {
+        state.subjects = snapshotSubjects(subjects, {});
+        state.schedule = snapshotSchedule(schedule, emptySchedule());
+    } else {
+        state.subjects = snapshotSubjects(subjects, current().subjects);
+        state.schedule = snapshotSchedule(schedule, current().schedule);
+        steps.erase(steps.begin() + (ptrdiff_t)cursor + 1, steps.end());
+    }
+    state.scheduleMatchesSubjects = scheduleMatchesSubjects;
+    state.calendarStart = calendarStart;
+    steps.push_back(move(state));
+    if (steps.size() > limit) steps.pop_front();
+    cursor = steps.size() - 1;
+}
+
+HistoryFootprint EditHistory::footprint() const {
+    HistoryFootprint f;
+    f.steps = steps.size();
+    unordered_set<const void *> subjectsSeen, daysSeen;
+    for (const EditState &state : steps) {
+        for (size_t i = 0; i < state.subjects.size(); ++i)
+            if (subjectsSeen.insert(state.subjects[i].get()).second) ++f.subjects;
+        for (size_t d = 0; d < state.schedule->days.size(); ++d) {
+            const ScheduleDaySnapshot *day = state.schedule->days[d].get();
+            if (daysSeen.insert(day).second) {
+                ++f.days;
+                f.slotCount += day->items.size();
+            }
+        }
+    }
+    return f;
+}
+
+void restoreSubjects(const EditState &to, const EditState &from, vector<Subject> &subjects) {
+    using Subjects = PersistentArray<shared_ptr<const Subject>>;
+    const Subjects &a = to.subjects, &b = from.subjects;
+    if (a.sameAs(b) && subjects.size() == a.size()) return;
+
+    if (subjects.size() != b.size()) {
+        subjects.clear();
+        subjects.reserve(a.size());
+        for (size_t i = 0; i < a.size(); ++i) subjects.push_back(*a[i]);
+        return;
+    }
+
+    if (a.size() == b.size()) {
+        for (size_t c = 0; c < a.chunkCount(); ++c) {
+            if (a.chunkId(c) == b.chunkId(c)) continue;
+            size_t last = min(a.size(), (c + 1) * Subjects::CHUNK_SIZE);
+            for (size_t i = c * Subjects::CHUNK_SIZE; i < last; ++i)
+                if (a[i] != b[i]) subjects[i] = *a[i];
+        }
+        return;
+    }
+
+    // A subject was added or removed, so the others moved: keep the working
+    // copy of every subject from still has, wherever it is now.
+    unordered_map<const Subject *, size_t> where;
+    where.reserve(b.size());
+    for (size_t j = 0; j < b.size(); ++j) where.emplace(b[j].get(), j);
+    vector<Subject> out;
+    out.reserve(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        auto it = where.find(a[i].get());
+        if (it == where.end()) {
+            out.push_back(*a[i]);
+            continue;
+        }
+        out.push_back(move(subjects[it->second]));
+        where.erase(it);
+    }
+    subjects.swap(out);
+}
+
+void restoreSchedule(const ScheduleSnapshot &to, const ScheduleSnapshot &from, Schedule &schedule) {
+    using Days = PersistentArray<shared_ptr<const ScheduleDaySnapshot>>;
+    if (!to.names) {
+        schedule.clear();
+        return;
+    }
+    size_t days = to.days.size();
+    bool matches = from.names && (size_t)schedule.dayCount() == from.days.size() && schedule.slotCount() == from.slotCount;
+    if (matches && to.days.sameAs(from.days)) {
+        schedule.setNames(to.names);
+        return;
+    }
+
+    // Days the two share stay; changed days of the same length are written
+    // over, and from the first one whose length differs the rest is appended.
+    size_t keep = 0;
+    if (matches) {
+        size_t common = min(days, from.days.size());
+        keep = common;
+        for (size_t c = 0; c < to.days.chunkCount() && c * Days::CHUNK_SIZE < keep; ++c) {
+            if (c < from.days.chunkCount() && to.days.chunkId(c) == from.days.chunkId(c)) continue;
+            size_t last = min(keep, (c + 1) * Days::CHUNK_SIZE);
+            for (size_t d = c * Days::CHUNK_SIZE; d < last; ++d) {
+                const ScheduleDaySnapshot &day = *to.days[d];
+                if (to.days[d] == from.days[d]) continue;
+                if (day.items.size() != from.days[d]->items.size()) {
+                    keep = d;
+                    break;
+                }
+                schedule.replaceDay((int)d, day.items, day.stats);
+            }
+        }
+        schedule.truncate((int)keep);
+        schedule.setNames(to.names);
+    } else {
+        schedule.start(to.names, (int)days, to.slotCount);
+    }
+    for (size_t d = keep; d < days; ++d) {
+        const ScheduleDaySnapshot &day = *to.days[d];
+        schedule.appendDay(day.items, day.stats);
+    }
+}
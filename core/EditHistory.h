@@ -0,0 +1,93 @@
+// EditHistory.h
+//  Undo/redo history of the subject list and the generated schedule. Each
+//  step is a persistent snapshot that shares every unchanged subject and
+//  every unchanged day with the step before it, so a step only stores what
+//  its edit changed, and moving through the history is O(1).
+
+#pragma once
+
+#include "PersistentArray.h"
+#include "Schedule.h"
+#include "Subject.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr size_t DEFAULT_HISTORY_LIMIT = 500; // steps kept; older ones are dropped
+
+struct ScheduleDaySnapshot {
+    std::vector<ScheduleSlot> items;
+    DayStats stats;
+};
+
+struct ScheduleSnapshot {
+    std::shared_ptr<const ScheduleNames> names; // null for no schedule
+    PersistentArray<std::shared_ptr<const ScheduleDaySnapshot>> days;
+    size_t slotCount = 0;
+};
+
+struct EditState {
+    std::string label; // the edit that led to this state
+    PersistentArray<std::shared_ptr<const Subject>> subjects;
+    std::shared_ptr<const ScheduleSnapshot> schedule; // never null
+    bool scheduleMatchesSubjects = false; // the schedule's subject indices refer to subjects
+    int64_t calendarStart = 0; // the front end's anchor for exam days, e.g. the start date
+};
+
+// What a history holds once shared parts are counted once.
+struct HistoryFootprint {
+    size_t steps = 0;
+    size_t subjects = 0; // distinct subject snapshots
+    size_t days = 0;     // distinct day snapshots
+    size_t slotCount = 0; // slots in those days
+};
+
+class EditHistory {
+public:
+    explicit EditHistory(size_t maxSteps = DEFAULT_HISTORY_LIMIT) : limit(std::max<size_t>(maxSteps, 1)) {}
+
+    // Adds the state after an edit as the newest step and drops the steps
+    // that could have been redone. The first call records the initial state.
+    void record(std::string label, const std::vector<Subject> &subjects, const Schedule &schedule,
+                bool scheduleMatchesSubjects, int64_t calendarStart);
+
+    // Drops every step.
+    void clear() {
+        steps.clear();
+        cursor = 0;
+    }
+
+    bool canUndo() const { return cursor > 0; }
+    bool canRedo() const { return cursor + 1 < steps.size(); }
+
+    // Labels of the edit undo() would revert and redo() would apply again.
+    const std::string &undoLabel() const { return steps[cursor].label; }
+    const std::string &redoLabel() const { return steps[cursor + 1].label; }
+
+    // The state after the latest edit not undone. Requires a recorded step;
+    // references stay valid until the step is dropped.
+    const EditState &current() const { return steps[cursor]; }
+    const EditState &undo() { return steps[--cursor]; }
+    const EditState &redo() { return steps[++cursor]; }
+
+    size_t size() const { return steps.size(); }
+    HistoryFootprint footprint() const;
+
+private:
+    size_t limit;
+    std::deque<EditState> steps;
+    size_t cursor = 0;
+};
+
+// Brings working forms that show from to the recorded state to, e.g. after
+// undo() with from the state current() returned before it. Only chunks whose
+// storage differs between the two are compared, and only the subjects and
+// days whose snapshots differ are copied; forms that do not match from are
+// rebuilt whole.
+void restoreSubjects(const EditState &to, const EditState &from, std::vector<Subject> &subjects);
+void restoreSchedule(const ScheduleSnapshot &to, const ScheduleSnapshot &from, Schedule &schedule);
@@ -0,0 +1,42 @@
+// Highlights.cpp
+
+#include "Highlights.h"
+#include "PerfStats.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void HighlightAnalysis::analyze(const Schedule &schedule, size_t subjectCount) {
+    PerfScope perf(PerfProbe::Analyze);
+    int days = schedule.dayCount();
+    perf.addItems((uint64_t)days);
+    dayMasks.assign(days, 0);
+    subjectMasks.assign(subjectCount, 0);
+    if (days == 0) return;
+
+    // Find max values
+    int maxDifficulty = 0;
+    int maxTopics = 0;
+    int maxMinutes = 0;
+    for (int d = 0; d < days; ++d) {
+        const DayStats &st = schedule.dayStats(d);
+        maxDifficulty = max(maxDifficulty, st.difficultySum);
+        maxTopics = max(maxTopics, st.topicCount);
+        maxMinutes = max(maxMinutes, st.minutes);
+    }
+
+    // Mark highlight reasons per day, then OR each day's reasons into the subjects studied that day
+    for (int d = 0; d < days; ++d) {
+        const DayStats &st = schedule.dayStats(d);
+        HighlightMask m = 0;
+        if (st.difficultySum == maxDifficulty) m |= Difficulty;
+        if (st.topicCount == maxTopics) m |= Topics;
+        if (st.minutes == maxMinutes) m |= Hours;
+        dayMasks[d] = m;
+
+        if (m == 0) continue;
+        for (const ScheduleSlot &t : schedule.day(d))
+            if (t.subject < subjectCount) subjectMasks[t.subject] |= m;
+    }
+}
@@ -0,0 +1,59 @@
+// Highlights.h
+//  Busiest-day analysis: which days carry the highest difficulty sum, the
+//  most topics or the most hours, and which subjects appear on those days.
+//  Reasons are bit flags so a day or subject needs one byte.
+
+#pragma once
+
+#include "Schedule.h"
+
+#include <cstdint>
+#include <vector>
+
+enum HighlightReason : uint8_t {
+    Difficulty = 1 << 0,
+    Topics = 1 << 1,
+    Hours = 1 << 2
+};
+using HighlightMask = uint8_t;
+
+static constexpr HighlightMask ALL_HIGHLIGHTS = Difficulty | Topics | Hours;
+
+enum class HighlightFilter {
+    All,
+    DifficultyOnly,
+    TopicsOnly,
+    HoursOnly
+};
+
+inline HighlightMask filterMask(HighlightFilter filter) {
+    switch (filter) {
+        case HighlightFilter::All: return ALL_HIGHLIGHTS;
+        case HighlightFilter::DifficultyOnly: return Difficulty;
+        case HighlightFilter::TopicsOnly: return Topics;
+        case HighlightFilter::HoursOnly: return Hours;
+    }
+    return ALL_HIGHLIGHTS;
+}
+
+class HighlightAnalysis {
+public:
+    // One pass over the per-day totals the generator recorded, then one
+    // pass over the slots. Buffers are reused, so repeated calls on
+    // schedules of similar size do not allocate.
+    void analyze(const Schedule &schedule, size_t subjectCount);
+
+    void clear() {
+        dayMasks.clear();
+        subjectMasks.clear();
+    }
+
+    HighlightMask dayMask(int d) const { return d < (int)dayMasks.size() ? dayMasks[d] : 0; }
+    HighlightMask subjectMask(size_t s) const { return s < subjectMasks.size() ? subjectMasks[s] : 0; }
+
+    const std::vector<HighlightMask> &allDayMasks() const { return dayMasks; }
+
+private:
+    std::vector<HighlightMask> dayMasks;     // per day
+    std::vector<HighlightMask> subjectMasks; // per subject index
+};
@@ -0,0 +1,102 @@
+// IntervalTree.h
+//  Static interval tree over half-open [start, end) minute intervals. The
+//  intervals sorted by start form an implicit balanced tree (the middle
+//  element of each range is its root), and every node also keeps the
+//  latest end in its subtree, so an overlap query skips whole subtrees that
+//  end too early. Built once in O(n log n); finding the next free gap costs
+//  O(log n) per busy stretch it has to jump over.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TimeInterval {
+    uint32_t start;
+    uint32_t end; // exclusive
+};
+
+class IntervalTree {
+public:
+    // Replaces the intervals; empty ones are dropped. Reuses the buffers.
+    void assign(const std::vector<TimeInterval> &intervals) {
+        items.clear();
+        for (const TimeInterval &i : intervals)
+            if (i.end > i.start) items.push_back(i);
+        std::sort(items.begin(), items.end(), [](const TimeInterval &a, const TimeInterval &b) {
+            return a.start != b.start ? a.start < b.start : a.end < b.end;
+        });
+        maxEnd.resize(items.size());
+        if (!items.empty()) build(0, items.size());
+    }
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    const std::vector<TimeInterval> &intervals() const { return items; }
+
+    // Latest end of the intervals overlapping [start, end), or start when
+    // none does. Every interval that starts before end and is still open at
+    // start overlaps, so this is the latest end among those starting before
+    // end, found along one root-to-leaf path.
+    uint32_t coverEnd(uint32_t start, uint32_t end) const {
+        uint32_t latest = start;
+        size_t lo = 0, hi = items.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (items[mid].start < end) {
+                latest = std::max(latest, items[mid].end);
+                if (lo < mid) latest = std::max(latest, maxEnd[lo + (mid - lo) / 2]);
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return latest;
+    }
+
+    bool overlaps(uint32_t start, uint32_t end) const { return end > start && coverEnd(start, end) > start; }
+
+    // Earliest t >= from such that [t, t + length) overlaps no interval.
+    // Jumping to the latest end of whatever overlaps never skips a gap:
+    // any earlier start would still run into that interval.
+    uint32_t firstFree(uint32_t from, uint32_t length) const {
+        uint32_t t = from;
+        for (;;) {
+            uint32_t next = coverEnd(t, t + std::max<uint32_t>(length, 1));
+            if (next <= t) return t;
+            t = next;
+        }
+    }
+
+    // Calls f(interval) for every interval overlapping [start, end), in start order.
+    template <class F>
+    void forEachOverlap(uint32_t start, uint32_t end, F &&f) const {
+        if (end > start && !items.empty()) visit(0, items.size(), start, end, f);
+    }
+
+private:
+    std::vector<TimeInterval> items; // by start
+    std::vector<uint32_t> maxEnd;    // per node: latest end in its subtree
+
+    uint32_t build(size_t lo, size_t hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t latest = items[mid].end;
+        if (lo < mid) latest = std::max(latest, build(lo, mid));
+        if (mid + 1 < hi) latest = std::max(latest, build(mid + 1, hi));
+        return maxEnd[mid] = latest;
+    }
+
+    template <class F>
+    void visit(size_t lo, size_t hi, uint32_t start, uint32_t end, F &f) const {
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (maxEnd[mid] <= start) return;
+            visit(lo, mid, start, end, f);
+            if (items[mid].start >= end) return;
+            if (items[mid].end > start) f(items[mid]);
+            lo = mid + 1;
+        }
+    }
+};
@@ -0,0 +1,282 @@
+// Json.cpp
+
+#include "Json.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+// Nesting beyond this is rejected instead of recursing without bound.
+constexpr int MAX_DEPTH = 64;
+
+class JsonParser {
+public:
+    JsonParser(string_view t, string &e) : text(t), error(e) {}
+
+    bool document(JsonValue &out) {
+        if (!value(out, 0)) return false;
+        skipSpace();
+        if (pos != text.size()) return fail("unexpected text after the document");
+        return true;
+    }
+
+private:
+    string_view text;
+    string &error;
+    size_t pos = 0;
+
+    bool fail(const char *msg) {
+        error = "offset " + to_string(pos) + ": " + msg;
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+            ++pos;
+    }
+
+    bool literal(string_view word) {
+        if (text.substr(pos, word.size()) != word) return fail("invalid literal");
+        pos += word.size();
+        return true;
+    }
+
+    bool value(JsonValue &out, int depth) {
+        if (depth > MAX_DEPTH) return fail("nesting too deep");
+        skipSpace();
+        if (pos >= text.size()) return fail("unexpected end of input");
+        char c = text[pos];
+        switch (c) {
+            case '{': return object(out, depth);
+            case '[': return array(out, depth);
+            case '"': out.type = JsonValue::Type::String; return str(out.text);
+            case 't': out.type = JsonValue::Type::Bool; out.boolean = true; return literal("true");
+            case 'f': out.type = JsonValue::Type::Bool; out.boolean = false; return literal("false");
+            case 'n': out.type = JsonValue::Type::Null; return literal("null");
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) return number(out);
+        return fail("unexpected character");
+    }
+
+    bool object(JsonValue &out, int depth) {
+        out.type = JsonValue::Type::Object;
+        ++pos;
+        skipSpace();
+        if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            return true;
+        }
+        for (;;) {
+            skipSpace();
+            if (pos >= text.size() || text[pos] != '"') return fail("expected a member name");
+            out.members.emplace_back();
+            if (!str(out.members.back().first)) return false;
+            skipSpace();
+            if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+            ++pos;
+            if (!value(out.members.back().second, depth + 1)) return false;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == '}') {
+                ++pos;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool array(JsonValue &out, int depth) {
+        out.type = JsonValue::Type::Array;
+        ++pos;
+        skipSpace();
+        if (pos < text.size() && text[pos] == ']') {
+            ++pos;
+            return true;
+        }
+        for (;;) {
+            out.items.emplace_back();
+            if (!value(out.items.back(), depth + 1)) return false;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == ']') {
+                ++pos;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool number(JsonValue &out) {
+        size_t start = pos;
+        auto digits = [&] {
+            size_t from = pos;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') ++pos;
+            return pos > from;
+        };
+        if (text[pos] == '-') ++pos;
+        // The integer part has no leading zeros: "0" or a nonzero digit first.
+        if (pos < text.size() && text[pos] == '0') ++pos;
+        else if (!digits()) return fail("invalid number");
+        if (pos < text.size() && text[pos] == '.') {
+            ++pos;
+            if (!digits()) return fail("invalid number");
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) ++pos;
+            if (!digits()) return fail("invalid number");
+        }
+        // strtod needs a terminated copy; numbers are short.
+        string copy(text.substr(start, pos - start));
+        out.type = JsonValue::Type::Number;
+        out.number = strtod(copy.c_str(), nullptr);
+        return true;
+    }
+
+    bool hex4(unsigned &code) {
+        if (pos + 4 > text.size()) return fail("invalid \\u escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = text[pos++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= (unsigned)(h - '0');
+            else if (h >= 'a' && h <= 'f') code |= (unsigned)(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') code |= (unsigned)(h - 'A' + 10);
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(string &out, unsigned cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool str(string &out) {
+        ++pos; // opening quote
+        for (;;) {
+            // Copy the run up to the next quote or escape in one go.
+            size_t run = pos;
+            while (run < text.size() && text[run] != '"' && text[run] != '\\') {
+                if ((unsigned char)text[run] < 0x20) {
+                    pos = run;
+                    return fail("control character in string");
+                }
+                ++run;
+            }
+            out.append(text.data() + pos, run - pos);
+            pos = run;
+            if (pos >= text.size()) return fail("unterminated string");
+            if (text[pos++] == '"') return true;
+
+            if (pos >= text.size()) return fail("unterminated string");
+            char e = text[pos++];
+            switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned cp = 0;
+                    if (!hex4(cp)) return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        unsigned low = 0;
+                        if (text.substr(pos, 2) != "\\u") return fail("unpaired surrogate");
+                        pos += 2;
+                        if (!hex4(low)) return false;
+                        if (low < 0xDC00 || low > 0xDFFF) return fail("unpaired surrogate");
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        return fail("unpaired surrogate");
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+    }
+};
+}
+
+const JsonValue *JsonValue::find(string_view key) const {
+    for (const auto &m : members)
+        if (m.first == key) return &m.second;
+    return nullptr;
+}
+
+bool parseJson(string_view text, JsonValue &out, string &error) {
+    out = JsonValue();
+    return JsonParser(text, error).document(out);
+}
+
+void appendJsonString(string &out, string_view s) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += HEX[c >> 4];
+                out += HEX[c & 15];
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+void appendJsonNumber(string &out, uint64_t v) {
+    char buf[24];
+    out.append(buf, (size_t)(to_chars(buf, buf + sizeof buf, v).ptr - buf));
+}
+
+void appendJsonDecimal(string &out, double v) {
+    if (!isfinite(v)) v = 0.0;
+    long long hundredths = llround(v * 100.0);
+    if (hundredths < 0) {
+        out += '-';
+        hundredths = -hundredths;
+    }
+    appendJsonNumber(out, (uint64_t)hundredths / 100);
+    out += '.';
+    out += (char)('0' + hundredths / 10 % 10);
+    out += (char)('0' + hundredths % 10);
+}
@@ -0,0 +1,45 @@
+// Json.h
+//  Small JSON reader for service requests: parses a whole document into a
+//  tree of JsonValue. Output is written by hand, with appendJsonString()
+//  for escaping and appendJsonNumber()/appendJsonDecimal() for numbers.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;                                       // String
+    std::vector<JsonValue> items;                           // Array
+    std::vector<std::pair<std::string, JsonValue>> members; // Object, in document order
+
+    bool isNull() const { return type == Type::Null; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isString() const { return type == Type::String; }
+    bool isArray() const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+
+    // Member named key of an object, nullptr when absent (or not an object).
+    const JsonValue *find(std::string_view key) const;
+};
+
+// Parses text as one JSON document (RFC 8259; \u escapes become UTF-8).
+// Returns false with the byte offset in error on malformed input.
+bool parseJson(std::string_view text, JsonValue &out, std::string &error);
+
+// Appends s to out as a quoted JSON string.
+void appendJsonString(std::string &out, std::string_view s);
+
+// Appends v in decimal.
+void appendJsonNumber(std::string &out, uint64_t v);
+// Appends v rounded to two decimals, e.g. 12.50, independent of the C
+// locale. JSON has no NaN or infinity; they are written as 0.00.
+void appendJsonDecimal(std::string &out, double v);
@@ -0,0 +1,79 @@
+// LatencyHistogram.h
+//  Lock-free latency histogram with log-linear buckets: exact below 16,
+//  then eight buckets per power of two, so any percentile is within 12.5%
+//  of the true value while recording stays one relaxed atomic increment.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+class LatencyHistogram {
+public:
+    // Safe to call from any thread.
+    void record(uint64_t value) {
+        buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t seen = largest.load(std::memory_order_relaxed);
+        while (value > seen && !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return largest.load(std::memory_order_relaxed); }
+    double mean() const {
+        uint64_t n = count();
+        return n ? (double)sum.load(std::memory_order_relaxed) / (double)n : 0.0;
+    }
+
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100),
+    // capped at the largest value recorded; 0 when empty.
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)n + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t bound = upperBound(i);
+                return bound < max() ? bound : max();
+            }
+        }
+        return max();
+    }
+
+private:
+    static constexpr int LINEAR = 16;   // values below are counted exactly
+    static constexpr int SUB_BITS = 3;  // 2^3 buckets per power of two above
+    static constexpr int BUCKETS = LINEAR + (64 - 4) * (1 << SUB_BITS);
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> largest{0};
+
+    static int highestBit(uint64_t v) {
+        int bit = 0;
+        while (v >>= 1) ++bit;
+        return bit;
+    }
+
+    static int bucketOf(uint64_t v) {
+        if (v < LINEAR) return (int)v;
+        int msb = highestBit(v); // >= 4
+        int sub = (int)((v >> (msb - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+        return LINEAR + (msb - 4) * (1 << SUB_BITS) + sub;
+    }
+
+    static uint64_t upperBound(int bucket) {
+        if (bucket < LINEAR) return (uint64_t)bucket;
+        int msb = 4 + (bucket - LINEAR) / (1 << SUB_BITS);
+        uint64_t sub = (uint64_t)((bucket - LINEAR) % (1 << SUB_BITS));
+        uint64_t width = 1ull << (msb - SUB_BITS);
+        return ((1ull << SUB_BITS) + sub) * width + (width - 1);
+    }
+};
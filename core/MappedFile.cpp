@@ -0,0 +1,156 @@
+// MappedFile.cpp
+
+#include "MappedFile.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ADEXA_HAVE_MMAP 1
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+
+using namespace std;
+
+bool MappedFile::open(const string &path, string &error, bool sequential) {
+    close();
+#ifdef ADEXA_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        error = "cannot read " + path;
+        return false;
+    }
+    if (st.st_size == 0) {
+        // mmap rejects empty ranges; an empty file is simply no bytes.
+        ::close(fd);
+        bytes = "";
+        return true;
+    }
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    if (sequential) madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    bytes = static_cast<const char *>(p);
+    length = (size_t)st.st_size;
+    mapped = true;
+#else
+    (void)sequential;
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    length = (size_t)in.tellg();
+    if (length == 0) {
+        bytes = "";
+        return true;
+    }
+    char *buf = static_cast<char *>(::operator new(length));
+    in.seekg(0);
+    in.read(buf, (streamsize)length);
+    bytes = buf;
+    mapped = false;
+    if (!in) {
+        close();
+        error = "cannot read " + path;
+        return false;
+    }
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes && length > 0) {
+#ifdef ADEXA_HAVE_MMAP
+        if (mapped) munmap(const_cast<char *>(bytes), length);
+#endif
+        if (!mapped) ::operator delete(const_cast<char *>(bytes));
+    }
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+namespace {
+atomic<unsigned> tempCounter{0};
+
+unsigned long processId() {
+#ifdef ADEXA_HAVE_MMAP
+    return (unsigned long)getpid();
+#elif defined(_WIN32)
+    return (unsigned long)_getpid();
+#else
+    return 0;
+#endif
+}
+
+string tempName(const string &path) {
+    return path + ".tmp" + to_string(processId()) + "." + to_string(tempCounter.fetch_add(1, memory_order_relaxed));
+}
+}
+
+bool replaceFile(const string &path, const char *data, size_t size, string &error) {
+    string tmpPath;
+#ifdef ADEXA_HAVE_MMAP
+    // O_EXCL: a name left behind by a crashed process with the same id is
+    // skipped, never reused.
+    int fd = -1;
+    for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+        tmpPath = tempName(path);
+        fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0 && errno != EEXIST) break;
+    }
+    if (fd < 0) {
+        error = "cannot write " + path;
+        return false;
+    }
+    bool ok = true;
+    for (size_t done = 0; ok && done < size;) {
+        ssize_t n = ::write(fd, data + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) done += (size_t)n;
+    }
+    ok &= ::close(fd) == 0;
+#else
+    tmpPath = tempName(path);
+    bool ok;
+    {
+        ofstream out(tmpPath, ios::binary | ios::trunc);
+        if (!out) {
+            error = "cannot write " + path;
+            return false;
+        }
+        out.write(data, (streamsize)size);
+        out.close();
+        ok = (bool)out;
+    }
+#endif
+    if (!ok) {
+        remove(tmpPath.c_str());
+        error = "write failed: " + path;
+        return false;
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        error = "cannot replace " + path;
+        return false;
+    }
+    return true;
+}
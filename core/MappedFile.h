@@ -0,0 +1,39 @@
+// MappedFile.h
+//  Read-only view of a whole file: memory-mapped where the platform has
+//  mmap, read into one buffer otherwise. Either way the bytes are 8-byte
+//  aligned and stay put until close(). replaceFile() is the matching
+//  writer for files that are mapped while other processes rewrite them.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // sequential hints the kernel that the file is read front to back once.
+    bool open(const std::string &path, std::string &error, bool sequential = false);
+    void close();
+
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes, length); }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+};
+
+// Writes size bytes of data to a new file next to path and renames it over
+// path, so a reader sees either the old file or the whole new one. The
+// temporary name is unique across threads and processes (process id plus
+// a counter, created exclusively), so writers sharing a directory never
+// write into each other's file.
+bool replaceFile(const std::string &path, const char *data, size_t size, std::string &error);
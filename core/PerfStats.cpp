@@ -0,0 +1,125 @@
+// PerfStats.cpp
+
+#include "PerfStats.h"
+
+#include <atomic>
+#include <fstream>
+#include <ostream>
+
+#if ADEXA_INSTRUMENT
+#include "AllocCounter.h"
+#endif
+
+using namespace std;
+
+namespace {
+const char *const PROBE_NAMES[PERF_PROBE_COUNT] = {"generateSchedule", "analyzeHighlights", "populateScheduleTable",
+                                                   "refreshSubjectTable", "saveCsv", "importSyllabus",
+                                                   "buildScheduleIndex", "searchSchedule", "replanSchedule",
+                                                   "placeClockTimes", "cohortReport"};
+const char *const ITEM_NAMES[PERF_PROBE_COUNT] = {"tasks", "days", "rows", "rows", "rows", "topics",
+                                                  "slots", "slots", "slots", "slots", "days"};
+
+#if ADEXA_INSTRUMENT
+// Relaxed counters: a snapshot taken during a call may mix that call's
+// fields, which is fine for a stats display.
+struct ProbeCounters {
+    atomic<uint64_t> calls{0};
+    atomic<uint64_t> totalNs{0};
+    atomic<uint64_t> lastNs{0};
+    atomic<uint64_t> maxNs{0};
+    atomic<uint64_t> items{0};
+    atomic<uint64_t> lastItems{0};
+    atomic<uint64_t> allocations{0};
+    atomic<uint64_t> lastAllocations{0};
+    atomic<uint64_t> allocBytes{0};
+};
+
+ProbeCounters counters[PERF_PROBE_COUNT];
+#endif
+}
+
+#if ADEXA_INSTRUMENT
+
+PerfScope::PerfScope(PerfProbe p) : probe(p) {
+    AllocSnapshot a = threadAllocSnapshot();
+    startAllocations = a.allocations;
+    startBytes = a.bytes;
+    started = chrono::steady_clock::now();
+}
+
+PerfScope::~PerfScope() {
+    uint64_t ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+    AllocSnapshot a = threadAllocSnapshot();
+    uint64_t allocations = a.allocations - startAllocations;
+
+    ProbeCounters &c = counters[(int)probe];
+    c.calls.fetch_add(1, memory_order_relaxed);
+    c.totalNs.fetch_add(ns, memory_order_relaxed);
+    c.lastNs.store(ns, memory_order_relaxed);
+    uint64_t peak = c.maxNs.load(memory_order_relaxed);
+    while (ns > peak && !c.maxNs.compare_exchange_weak(peak, ns, memory_order_relaxed)) {}
+    c.items.fetch_add(items, memory_order_relaxed);
+    c.lastItems.store(items, memory_order_relaxed);
+    c.allocations.fetch_add(allocations, memory_order_relaxed);
+    c.lastAllocations.store(allocations, memory_order_relaxed);
+    c.allocBytes.fetch_add(a.bytes - startBytes, memory_order_relaxed);
+}
+
+#endif
+
+PerfSnapshot perfSnapshot() {
+    PerfSnapshot s;
+    s.enabled = ADEXA_INSTRUMENT != 0;
+    for (int i = 0; i < PERF_PROBE_COUNT; ++i) {
+        PerfProbeStats &p = s.probes[i];
+        p.name = PROBE_NAMES[i];
+        p.itemName = ITEM_NAMES[i];
+#if ADEXA_INSTRUMENT
+        const ProbeCounters &c = counters[i];
+        p.calls = c.calls.load(memory_order_relaxed);
+        p.totalNs = c.totalNs.load(memory_order_relaxed);
+        p.lastNs = c.lastNs.load(memory_order_relaxed);
+        p.maxNs = c.maxNs.load(memory_order_relaxed);
+        p.items = c.items.load(memory_order_relaxed);
+        p.lastItems = c.lastItems.load(memory_order_relaxed);
+        p.allocations = c.allocations.load(memory_order_relaxed);
+        p.lastAllocations = c.lastAllocations.load(memory_order_relaxed);
+        p.allocBytes = c.allocBytes.load(memory_order_relaxed);
+#endif
+    }
+    return s;
+}
+
+void resetPerfStats() {
+#if ADEXA_INSTRUMENT
+    for (ProbeCounters &c : counters) {
+        for (atomic<uint64_t> *field : {&c.calls, &c.totalNs, &c.lastNs, &c.maxNs, &c.items, &c.lastItems,
+                                        &c.allocations, &c.lastAllocations, &c.allocBytes})
+            field->store(0, memory_order_relaxed);
+    }
+#endif
+}
+
+void writePerfJson(ostream &out, const PerfSnapshot &snapshot) {
+    out << "{\n  \"enabled\": " << (snapshot.enabled ? "true" : "false") << ",\n  \"probes\": [";
+    for (int i = 0; i < PERF_PROBE_COUNT; ++i) {
+        const PerfProbeStats &p = snapshot.probes[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << p.name << "\", \"calls\": " << p.calls
+            << ", \"total_ns\": " << p.totalNs << ", \"last_ns\": " << p.lastNs << ", \"max_ns\": " << p.maxNs
+            << ", \"item\": \"" << p.itemName << "\", \"items\": " << p.items << ", \"last_items\": " << p.lastItems
+            << ", \"allocations\": " << p.allocations << ", \"last_allocations\": " << p.lastAllocations
+            << ", \"alloc_bytes\": " << p.allocBytes << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool writePerfJson(const string &path, string &error) {
+    ofstream out(path, ios::binary);
+    if (out) writePerfJson(out, perfSnapshot());
+    if (!out.flush()) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
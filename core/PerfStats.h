@@ -0,0 +1,94 @@
+// PerfStats.h
+//  Scoped timers and counters for the hot paths: wall time, items produced
+//  (tasks, rows, days) and heap allocations per probe, readable as a
+//  snapshot or as JSON. Built with ADEXA_INSTRUMENT=0, PerfScope is an empty
+//  inline class and every probe compiles away.
+
+#pragma once
+
+#ifndef ADEXA_INSTRUMENT
+#define ADEXA_INSTRUMENT 1
+#endif
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#if ADEXA_INSTRUMENT
+#include <chrono>
+#endif
+
+enum class PerfProbe {
+    Generate,        // items: tasks produced
+    Analyze,         // items: days analyzed
+    Populate,        // items: schedule rows handed to the view
+    RefreshSubjects, // items: subject rows rendered
+    SaveCsv,         // items: CSV rows written
+    Import,          // items: syllabus topics imported
+    Index,           // items: slots indexed
+    Search,          // items: matching slots
+    Replan,          // items: slots replanned
+    Place,           // items: slots given a clock time
+    Cohort,          // items: schedule days reported on
+    Count
+};
+
+static constexpr int PERF_PROBE_COUNT = (int)PerfProbe::Count;
+
+struct PerfProbeStats {
+    const char *name = "";
+    const char *itemName = "";
+    uint64_t calls = 0;
+    uint64_t totalNs = 0;
+    uint64_t lastNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t items = 0;       // summed over all calls
+    uint64_t lastItems = 0;
+    uint64_t allocations = 0; // summed over all calls, calling thread only
+    uint64_t lastAllocations = 0;
+    uint64_t allocBytes = 0;
+};
+
+struct PerfSnapshot {
+    bool enabled = false;
+    PerfProbeStats probes[PERF_PROBE_COUNT];
+};
+
+// Safe to call from any thread while probes are running.
+PerfSnapshot perfSnapshot();
+void resetPerfStats();
+
+// {"enabled":...,"probes":[{"name":...,"calls":...},...]}
+void writePerfJson(std::ostream &out, const PerfSnapshot &snapshot);
+bool writePerfJson(const std::string &path, std::string &error);
+
+#if ADEXA_INSTRUMENT
+
+// Records one call of probe from construction to destruction.
+class PerfScope {
+public:
+    explicit PerfScope(PerfProbe p);
+    ~PerfScope();
+
+    PerfScope(const PerfScope &) = delete;
+    PerfScope &operator=(const PerfScope &) = delete;
+
+    void addItems(uint64_t n) { items += n; }
+
+private:
+    PerfProbe probe;
+    uint64_t items = 0;
+    size_t startAllocations;
+    size_t startBytes;
+    std::chrono::steady_clock::time_point started;
+};
+
+#else
+
+class PerfScope {
+public:
+    explicit PerfScope(PerfProbe) {}
+    void addItems(uint64_t) {}
+};
+
+#endif
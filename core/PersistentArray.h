@@ -0,0 +1,68 @@
+// PersistentArray.h
+//  Immutable array stored as fixed-size chunks that versions share. A new
+//  version built from an old one reuses every chunk whose elements are
+//  unchanged, so keeping many versions costs only the chunks that differ.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+template <class T, size_t CHUNK = 32>
+class PersistentArray {
+public:
+    static constexpr size_t CHUNK_SIZE = CHUNK; // elements per chunk; chunk c holds c * CHUNK_SIZE onwards
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const T &operator[](size_t i) const { return (*spine)[i / CHUNK]->items[i % CHUNK]; }
+
+    // True when both versions use the same storage, and so hold the same elements.
+    bool sameAs(const PersistentArray &other) const { return spine == other.spine; }
+
+    size_t chunkCount() const { return spine ? spine->size() : 0; }
+    // Identity of chunk c, for counting the chunks several versions share.
+    const void *chunkId(size_t c) const { return (*spine)[c].get(); }
+
+    // A version holding items that shares base's chunks wherever their
+    // elements compare equal. Returns base itself when nothing changed.
+    static PersistentArray build(const std::vector<T> &items, const PersistentArray &base) {
+        PersistentArray out;
+        out.count = items.size();
+        if (items.empty()) return out;
+
+        auto chunks = std::make_shared<std::vector<std::shared_ptr<const Chunk>>>();
+        size_t n = (items.size() + CHUNK - 1) / CHUNK;
+        chunks->reserve(n);
+        bool allShared = n == base.chunkCount() && items.size() == base.count;
+        for (size_t c = 0; c < n; ++c) {
+            auto first = items.begin() + (std::ptrdiff_t)(c * CHUNK);
+            auto last = items.begin() + (std::ptrdiff_t)std::min(items.size(), (c + 1) * CHUNK);
+            if (c < base.chunkCount()) {
+                const std::shared_ptr<const Chunk> &old = (*base.spine)[c];
+                if (old->items.size() == (size_t)(last - first) && std::equal(first, last, old->items.begin())) {
+                    chunks->push_back(old);
+                    continue;
+                }
+            }
+            allShared = false;
+            auto chunk = std::make_shared<Chunk>();
+            chunk->items.assign(first, last);
+            chunks->push_back(std::move(chunk));
+        }
+        if (allShared) return base;
+        out.spine = std::move(chunks);
+        return out;
+    }
+
+private:
+    struct Chunk {
+        std::vector<T> items; // CHUNK elements, fewer in the last chunk
+    };
+
+    std::shared_ptr<const std::vector<std::shared_ptr<const Chunk>>> spine;
+    size_t count = 0;
+};
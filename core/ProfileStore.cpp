@@ -0,0 +1,367 @@
+// ProfileStore.cpp
+
+#include "ProfileStore.h"
+#include "PerfStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+using namespace std;
+
+static_assert(sizeof(ProfileHeader) == 136, "ProfileHeader layout changed: bump PROFILE_VERSION");
+static_assert(sizeof(SubjectRecord) == 32, "SubjectRecord layout changed: bump PROFILE_VERSION");
+static_assert(sizeof(AvailabilityRecord) == 8, "AvailabilityRecord layout changed: bump PROFILE_VERSION");
+static_assert(sizeof(ScheduleSlot) == 12, "ScheduleSlot layout changed: bump PROFILE_VERSION");
+static_assert(sizeof(DayStats) == 12, "DayStats layout changed: bump PROFILE_VERSION");
+static_assert(is_trivially_copyable<ScheduleSlot>::value && is_trivially_copyable<DayStats>::value,
+              "schedule records are stored as raw bytes");
+
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+namespace {
+size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// Appends raw arrays at 8-byte aligned offsets.
+class ProfileBuilder {
+public:
+    string bytes;
+
+    uint64_t append(const void *p, size_t n) {
+        bytes.resize(align8(bytes.size()));
+        uint64_t at = bytes.size();
+        bytes.append(static_cast<const char *>(p), n);
+        return at;
+    }
+};
+}
+
+bool saveProfile(const string &path, const PlanInput &plan, const Schedule *schedule, string &error) {
+    vector<SubjectRecord> subjectRecords;
+    vector<StringRef> topicRefs;
+    string strings;
+    subjectRecords.reserve(plan.subjects.size());
+
+    auto addString = [&strings](const string &s) {
+        StringRef r{(uint32_t)strings.size(), (uint32_t)s.size()};
+        strings += s;
+        return r;
+    };
+
+    for (const Subject &s : plan.subjects) {
+        SubjectRecord rec;
+        memset(&rec, 0, sizeof rec);
+        rec.name = addString(s.getName());
+        rec.difficulty = s.getDifficulty();
+        rec.importance = s.getImportance();
+        rec.examDay = s.getExamDay();
+        rec.firstTopic = (uint32_t)topicRefs.size();
+        // Same flat topic ids as ScheduleNames: a subject without topics gets one placeholder.
+        if (s.hasTopics()) {
+            for (const string &t : s.getTopicsList()) topicRefs.push_back(addString(t));
+        } else {
+            topicRefs.push_back(addString(s.getTopicAtIndex(0)));
+        }
+        rec.topicCount = (uint32_t)topicRefs.size() - rec.firstTopic;
+        subjectRecords.push_back(rec);
+    }
+    vector<AvailabilityRecord> availability;
+    for (const DayAvailability &a : plan.availability) {
+        if (a.day < 0) continue;
+        availability.push_back(AvailabilityRecord{(uint32_t)a.day, (uint32_t)max(a.minutes, 0)});
+    }
+    if (strings.size() > UINT32_MAX) {
+        error = "profile text exceeds 4 GiB";
+        return false;
+    }
+
+    if (schedule && !schedule->empty()) {
+        for (const ScheduleSlot &t : schedule->allSlots()) {
+            if (t.subject >= subjectRecords.size() || t.topic >= topicRefs.size()) {
+                error = "schedule does not match the subject list";
+                return false;
+            }
+        }
+    }
+
+    ProfileHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, "ADXP", 4);
+    h.version = PROFILE_VERSION;
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.days = (uint32_t)plan.days;
+    h.minutesPerDay = (uint32_t)max(plan.minutesPerDay, 0);
+    h.maxChunkMinutes = (uint32_t)max(plan.maxChunkMinutes, 0);
+    h.minSlotMinutes = (uint32_t)max(plan.minSlotMinutes, 0);
+    h.reviewMinutes = (uint32_t)max(plan.reviewMinutes, 0);
+    h.reviewSharePercent = (uint32_t)max(plan.reviewSharePercent, 0);
+    h.weighting = (uint32_t)plan.policies.weighting;
+    h.rotation = (uint32_t)plan.policies.rotation;
+    h.subjectCount = (uint32_t)subjectRecords.size();
+    h.topicCount = (uint32_t)topicRefs.size();
+    h.availabilityCount = (uint32_t)availability.size();
+
+    ProfileBuilder b;
+    b.append(&h, sizeof h);
+    h.subjectsOffset = b.append(subjectRecords.data(), subjectRecords.size() * sizeof(SubjectRecord));
+    h.topicsOffset = b.append(topicRefs.data(), topicRefs.size() * sizeof(StringRef));
+    h.availabilityOffset = b.append(availability.data(), availability.size() * sizeof(AvailabilityRecord));
+    if (schedule && !schedule->empty()) {
+        int days = schedule->dayCount();
+        vector<uint32_t> offsets(days + 1);
+        vector<DayStats> stats(days);
+        for (int d = 0; d <= days; ++d) offsets[d] = schedule->dayOffset(d);
+        for (int d = 0; d < days; ++d) stats[d] = schedule->dayStats(d);
+        h.dayCount = (uint32_t)days;
+        h.slotCount = (uint32_t)schedule->slotCount();
+        h.dayOffsetsOffset = b.append(offsets.data(), offsets.size() * sizeof(uint32_t));
+        h.slotsOffset = b.append(schedule->allSlots().data(), schedule->slotCount() * sizeof(ScheduleSlot));
+        h.dayStatsOffset = b.append(stats.data(), stats.size() * sizeof(DayStats));
+    }
+    h.stringsOffset = b.append(strings.data(), strings.size());
+    h.stringsSize = strings.size();
+    b.bytes.resize(align8(b.bytes.size()));
+    h.fileSize = b.bytes.size();
+    memcpy(&b.bytes[0], &h, sizeof h);
+
+    // Renamed over the target, so a reader (or another process caching the
+    // same plan) never maps a half-written profile.
+    return replaceFile(path, b.bytes.data(), b.bytes.size(), error);
+}
+
+uint64_t planFingerprint(const PlanInput &plan) {
+    // FNV-1a over everything that affects the generated schedule.
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *p, size_t n) {
+        const unsigned char *b = static_cast<const unsigned char *>(p);
+        for (size_t i = 0; i < n; ++i) {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+    };
+    auto mixString = [&](const string &s) {
+        uint64_t n = s.size();
+        mix(&n, sizeof n);
+        mix(s.data(), s.size());
+    };
+    uint32_t version = PROFILE_VERSION;
+    mix(&version, sizeof version);
+    mix(&plan.days, sizeof plan.days);
+    int limits[5] = {plan.minutesPerDay, plan.maxChunkMinutes, plan.minSlotMinutes, plan.reviewMinutes, plan.reviewSharePercent};
+    mix(limits, sizeof limits);
+    uint8_t policies[2] = {(uint8_t)plan.policies.weighting, (uint8_t)plan.policies.rotation};
+    mix(policies, sizeof policies);
+    for (const DayAvailability &a : plan.availability) {
+        mix(&a.day, sizeof a.day);
+        mix(&a.minutes, sizeof a.minutes);
+    }
+    for (const Subject &s : plan.subjects) {
+        mixString(s.getName());
+        int fields[4] = {s.getDifficulty(), s.getImportance(), s.getTopicsCount(), s.getExamDay()};
+        mix(fields, sizeof fields);
+        for (const string &t : s.getTopicsList()) mixString(t);
+    }
+    return h;
+}
+
+size_t writeCsvRows(CsvWriter &csv, const MappedProfile &profile, const string &student) {
+    PerfScope perf(PerfProbe::SaveCsv);
+    size_t rows = 0;
+    for (int d = 0; d < profile.dayCount(); ++d) {
+        for (const ScheduleSlot &t : profile.day(d)) {
+            if (!student.empty()) csv.field(student);
+            csv.field(d + 1);
+            csv.field(profile.subjectName(t.subject));
+            csv.field(t.kind == SlotKind::Review ? REVIEW_PREFIX : "", profile.topicName(t.topic));
+            csv.timeField((int)t.minutes);
+            csv.endRow();
+            ++rows;
+        }
+    }
+    perf.addItems(rows);
+    return rows;
+}
+
+bool MappedProfile::open(const string &path, string &error) {
+    close();
+    if (!file.open(path, error)) return false;
+    data = file.data();
+    size = file.size();
+    if (!validate(error)) {
+        error = path + ": " + error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedProfile::close() {
+    file.close();
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+bool MappedProfile::validate(string &error) {
+    if (size < sizeof(ProfileHeader) || memcmp(data, "ADXP", 4) != 0) {
+        error = "not an Adexa profile";
+        return false;
+    }
+    const ProfileHeader *h = reinterpret_cast<const ProfileHeader *>(data);
+    if (h->version != PROFILE_VERSION) {
+        error = "unsupported profile version " + to_string(h->version);
+        return false;
+    }
+    if (h->byteOrder != BYTE_ORDER_MARK) {
+        error = "profile was written on a machine with a different byte order";
+        return false;
+    }
+    if (h->fileSize != size) {
+        error = "truncated profile";
+        return false;
+    }
+    if (h->weighting > (uint32_t)WeightingPolicy::ImportanceSquared || h->rotation > (uint32_t)RotationPolicy::LeastRecent) {
+        error = "unknown weighting or rotation policy";
+        return false;
+    }
+    // The same bounds readPlan() enforces, so a damaged header never
+    // reaches the generator; shares up to 100% predate the 99% limit.
+    if (h->days < 1 || h->days > (uint32_t)MAX_DAYS || h->minutesPerDay > (uint32_t)MINUTES_PER_DAY ||
+        h->maxChunkMinutes > (uint32_t)MINUTES_PER_DAY || h->minSlotMinutes > (uint32_t)MINUTES_PER_DAY ||
+        h->reviewMinutes > (uint32_t)MINUTES_PER_DAY || h->reviewSharePercent > 100 ||
+        h->dayCount > (uint32_t)MAX_DAYS) {
+        error = "plan settings out of range";
+        return false;
+    }
+
+    auto section = [&](uint64_t offset, uint64_t count, size_t elem) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / (elem ? elem : 1);
+    };
+    bool hasSchedule = h->dayCount > 0;
+    if (!section(h->subjectsOffset, h->subjectCount, sizeof(SubjectRecord)) ||
+        !section(h->topicsOffset, h->topicCount, sizeof(StringRef)) ||
+        !section(h->availabilityOffset, h->availabilityCount, sizeof(AvailabilityRecord)) ||
+        !section(h->stringsOffset, h->stringsSize, 1) ||
+        (hasSchedule && (!section(h->dayOffsetsOffset, (uint64_t)h->dayCount + 1, sizeof(uint32_t)) ||
+                         !section(h->slotsOffset, h->slotCount, sizeof(ScheduleSlot)) ||
+                         !section(h->dayStatsOffset, h->dayCount, sizeof(DayStats))))) {
+        error = "corrupt section table";
+        return false;
+    }
+
+    header = h;
+    subjects = reinterpret_cast<const SubjectRecord *>(data + h->subjectsOffset);
+    topics = reinterpret_cast<const StringRef *>(data + h->topicsOffset);
+    availability = reinterpret_cast<const AvailabilityRecord *>(data + h->availabilityOffset);
+    strings = data + h->stringsOffset;
+
+    // Topics must be stored subject by subject, as ScheduleNames numbers them.
+    auto validRef = [&](const StringRef &r) { return r.offset <= h->stringsSize && r.length <= h->stringsSize - r.offset; };
+    uint32_t nextTopic = 0;
+    for (uint32_t i = 0; i < h->subjectCount; ++i) {
+        const SubjectRecord &s = subjects[i];
+        if (!validRef(s.name) || s.topicCount == 0 || s.firstTopic != nextTopic ||
+            s.topicCount > h->topicCount - s.firstTopic || s.difficulty < 1 || s.difficulty > 10 ||
+            s.importance < 1 || s.importance > 10 || s.examDay < 0 || s.examDay > MAX_DAYS) {
+            error = "corrupt subject record";
+            return false;
+        }
+        nextTopic += s.topicCount;
+    }
+    if (nextTopic != h->topicCount) {
+        error = "corrupt subject record";
+        return false;
+    }
+    for (uint32_t k = 0; k < h->availabilityCount; ++k) {
+        if (availability[k].day >= (uint32_t)MAX_DAYS || availability[k].minutes > (uint32_t)MINUTES_PER_DAY) {
+            error = "corrupt availability record";
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->topicCount; ++i) {
+        if (!validRef(topics[i])) {
+            error = "corrupt topic record";
+            return false;
+        }
+    }
+
+    if (hasSchedule) {
+        dayOffsets = reinterpret_cast<const uint32_t *>(data + h->dayOffsetsOffset);
+        records = reinterpret_cast<const ScheduleSlot *>(data + h->slotsOffset);
+        stats = reinterpret_cast<const DayStats *>(data + h->dayStatsOffset);
+        if (dayOffsets[0] != 0 || dayOffsets[h->dayCount] != h->slotCount) {
+            error = "corrupt schedule day table";
+            return false;
+        }
+        for (uint32_t d = 0; d < h->dayCount; ++d) {
+            if (dayOffsets[d] > dayOffsets[d + 1]) {
+                error = "corrupt schedule day table";
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < h->slotCount; ++i) {
+            if (records[i].subject >= h->subjectCount || records[i].topic >= h->topicCount ||
+                records[i].kind > SlotKind::Review) {
+                error = "corrupt schedule slot";
+                return false;
+            }
+        }
+    } else {
+        dayOffsets = nullptr;
+        records = nullptr;
+        stats = nullptr;
+    }
+    return true;
+}
+
+PlanInput MappedProfile::toPlan() const {
+    PlanInput plan;
+    plan.days = days();
+    plan.minutesPerDay = minutesPerDay();
+    plan.maxChunkMinutes = maxChunkMinutes();
+    plan.minSlotMinutes = minSlotMinutes();
+    plan.reviewMinutes = reviewMinutes();
+    plan.reviewSharePercent = reviewSharePercent();
+    plan.policies = policies();
+    for (uint32_t k = 0; k < header->availabilityCount; ++k)
+        plan.availability.push_back(DayAvailability{(int)availability[k].day, (int)availability[k].minutes});
+    plan.subjects.reserve(subjectCount());
+    for (size_t i = 0; i < subjectCount(); ++i) {
+        const SubjectRecord &rec = subjects[i];
+        vector<string> topicList;
+        topicList.reserve(rec.topicCount);
+        for (uint32_t t = 0; t < rec.topicCount; ++t)
+            topicList.emplace_back(topicName(rec.firstTopic + t));
+
+        Subject s;
+        s.setName(string(subjectName(i)));
+        s.setDifficulty(rec.difficulty);
+        s.setImportance(rec.importance);
+        s.setExamDay(rec.examDay);
+        s.setTopicsList(topicList);
+        plan.subjects.push_back(s);
+    }
+    return plan;
+}
+
+Schedule MappedProfile::toSchedule() const {
+    Schedule schedule;
+    if (!hasSchedule()) return schedule;
+
+    auto names = make_shared<ScheduleNames>();
+    names->subjects.reserve(subjectCount());
+    names->topicBase.reserve(subjectCount() + 1);
+    names->topics.reserve(header->topicCount);
+    for (size_t i = 0; i < subjectCount(); ++i) {
+        names->subjects.emplace_back(subjectName(i));
+        names->topicBase.push_back(subjects[i].firstTopic);
+    }
+    names->topicBase.push_back(header->topicCount);
+    for (uint32_t t = 0; t < header->topicCount; ++t)
+        names->topics.emplace_back(topicName(t));
+
+    schedule.assign(move(names), records, slotCount(), dayOffsets, dayCount(), stats);
+    return schedule;
+}
@@ -0,0 +1,141 @@
+// ProfileStore.h
+//  Versioned binary profile files (.adxp): subject list, plan parameters
+//  and optionally the generated schedule. The file is laid out so that a
+//  reader can mmap it and use the arrays in place; opening only checks
+//  the header and index bounds.
+//
+//  Layout (native byte order, every section 8-byte aligned):
+//    ProfileHeader
+//    SubjectRecord[subjectCount]
+//    StringRef[topicCount]              flat topic ids, see ScheduleNames
+//    AvailabilityRecord[availabilityCount]  per-day minutes overrides
+//    uint32_t[dayCount + 1]             schedule day offsets   (if any)
+//    ScheduleSlot[slotCount]            schedule slots         (if any)
+//    DayStats[dayCount]                 per-day totals         (if any)
+//    char[stringsSize]                  subject and topic text
+
+#pragma once
+
+#include "MappedFile.h"
+#include "Schedule.h"
+#include "ScheduleIO.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+static constexpr uint32_t PROFILE_VERSION = 6;
+
+struct ProfileHeader {
+    char magic[4];           // "ADXP"
+    uint32_t version;        // PROFILE_VERSION
+    uint32_t byteOrder;      // 0x01020304 as written by the saving machine
+    uint32_t days;
+    uint32_t minutesPerDay;
+    uint32_t maxChunkMinutes;
+    uint32_t minSlotMinutes;
+    uint32_t reviewMinutes;      // 0 when reviews are off
+    uint32_t reviewSharePercent;
+    uint32_t weighting;      // WeightingPolicy
+    uint32_t rotation;       // RotationPolicy
+    uint32_t subjectCount;
+    uint32_t topicCount;
+    uint32_t dayCount;       // schedule days, 0 when no schedule is stored
+    uint32_t slotCount;
+    uint32_t availabilityCount;
+    uint64_t subjectsOffset;
+    uint64_t topicsOffset;
+    uint64_t availabilityOffset;
+    uint64_t dayOffsetsOffset;
+    uint64_t slotsOffset;
+    uint64_t dayStatsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t fileSize;
+};
+
+struct StringRef {
+    uint32_t offset;         // into the string section
+    uint32_t length;
+};
+
+struct SubjectRecord {
+    StringRef name;
+    int32_t difficulty;
+    int32_t importance;
+    uint32_t firstTopic;     // flat topic id of the subject's first topic
+    uint32_t topicCount;
+    int32_t examDay;         // 1-based, 0 when none
+    uint32_t reserved;
+};
+
+struct AvailabilityRecord {
+    uint32_t day;            // 0-based
+    uint32_t minutes;
+};
+
+// Writes plan (and schedule, when given and generated from plan.subjects)
+// to path. The file is replaced atomically.
+bool saveProfile(const std::string &path, const PlanInput &plan, const Schedule *schedule, std::string &error);
+
+// Stable 64-bit hash of everything that determines a plan's schedule, for
+// naming cached profiles.
+uint64_t planFingerprint(const PlanInput &plan);
+
+// Read-only view of a profile file mapped into memory.
+class MappedProfile {
+public:
+    MappedProfile() = default;
+    ~MappedProfile() { close(); }
+    MappedProfile(const MappedProfile &) = delete;
+    MappedProfile &operator=(const MappedProfile &) = delete;
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    int days() const { return (int)header->days; }
+    int minutesPerDay() const { return (int)header->minutesPerDay; }
+    int maxChunkMinutes() const { return (int)header->maxChunkMinutes; }
+    int minSlotMinutes() const { return (int)header->minSlotMinutes; }
+    int reviewMinutes() const { return (int)header->reviewMinutes; }
+    int reviewSharePercent() const { return (int)header->reviewSharePercent; }
+    SchedulePolicies policies() const {
+        return SchedulePolicies{(WeightingPolicy)header->weighting, (RotationPolicy)header->rotation};
+    }
+
+    size_t subjectCount() const { return header->subjectCount; }
+    const SubjectRecord &subject(size_t i) const { return subjects[i]; }
+    std::string_view subjectName(size_t i) const { return text(subjects[i].name); }
+    std::string_view topicName(uint32_t flatId) const { return text(topics[flatId]); }
+
+    bool hasSchedule() const { return header->dayCount > 0; }
+    int dayCount() const { return (int)header->dayCount; }
+    size_t slotCount() const { return header->slotCount; }
+    Schedule::DayView day(int d) const { return Schedule::DayView(records + dayOffsets[d], records + dayOffsets[d + 1]); }
+    const DayStats &dayStats(int d) const { return stats[d]; }
+
+    // Copies into the types the generator and the GUI edit.
+    PlanInput toPlan() const;
+    Schedule toSchedule() const;
+
+private:
+    MappedFile file;
+    const char *data = nullptr;
+    size_t size = 0;
+
+    const ProfileHeader *header = nullptr;
+    const SubjectRecord *subjects = nullptr;
+    const StringRef *topics = nullptr;
+    const AvailabilityRecord *availability = nullptr;
+    const uint32_t *dayOffsets = nullptr;
+    const ScheduleSlot *records = nullptr;
+    const DayStats *stats = nullptr;
+    const char *strings = nullptr;
+
+    std::string_view text(const StringRef &r) const { return std::string_view(strings + r.offset, r.length); }
+    bool validate(std::string &error);
+};
+
+// Writes a stored schedule as CSV rows straight from the mapping.
+size_t writeCsvRows(CsvWriter &csv, const MappedProfile &profile, const std::string &student = std::string());
@@ -0,0 +1,123 @@
+// ProgressJournal.cpp
+
+#include "ProgressJournal.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <type_traits>
+
+using namespace std;
+
+static_assert(sizeof(JournalHeader) == 16, "JournalHeader layout changed: bump JOURNAL_VERSION");
+static_assert(sizeof(ProgressRecord) == 16, "ProgressRecord layout changed: bump JOURNAL_VERSION");
+static_assert(is_trivially_copyable<ProgressRecord>::value, "progress records are stored as raw bytes");
+
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+namespace {
+bool validStatus(ProgressStatus s) {
+    return s == ProgressStatus::Done || s == ProgressStatus::Partial || s == ProgressStatus::Skipped;
+}
+}
+
+bool ProgressJournal::open(const string &path, string &error) {
+    close();
+    bool exists = false;
+    if (FILE *probe = fopen(path.c_str(), "rb")) {
+        exists = true;
+        fclose(probe);
+    }
+
+    bool fresh = true;
+    if (exists) {
+        MappedFile in;
+        if (!in.open(path, error, true)) return false;
+        const char *data = in.data();
+        size_t size = in.size();
+        if (size > 0) {
+            if (size < sizeof(JournalHeader) || memcmp(data, "ADXJ", 4) != 0) {
+                error = path + ": not an Adexa progress journal";
+                return false;
+            }
+            JournalHeader h;
+            memcpy(&h, data, sizeof h);
+            if (h.version != JOURNAL_VERSION) {
+                error = path + ": unsupported journal version " + to_string(h.version);
+                return false;
+            }
+            if (h.byteOrder != BYTE_ORDER_MARK) {
+                error = path + ": journal was written on a machine with a different byte order";
+                return false;
+            }
+            size_t count = (size - sizeof h) / sizeof(ProgressRecord);
+            entries.reserve(count);
+            for (size_t k = 0; k < count; ++k) {
+                ProgressRecord r;
+                memcpy(&r, data + sizeof h + k * sizeof r, sizeof r);
+                if (validStatus(r.status)) add(r);
+            }
+            // A record cut short by a crash would misalign every later append.
+            size_t whole = sizeof h + count * sizeof(ProgressRecord);
+            if (whole < size && !replaceFile(path, data, whole, error)) {
+                close();
+                return false;
+            }
+            fresh = false;
+        }
+    }
+
+    file = fopen(path.c_str(), "ab");
+    if (!file) {
+        close();
+        error = "cannot write " + path;
+        return false;
+    }
+    filePath = path;
+    if (fresh) {
+        JournalHeader h;
+        memset(&h, 0, sizeof h);
+        memcpy(h.magic, "ADXJ", 4);
+        h.version = JOURNAL_VERSION;
+        h.byteOrder = BYTE_ORDER_MARK;
+        if (fwrite(&h, sizeof h, 1, file) != 1 || fflush(file) != 0) {
+            close();
+            error = "write failed: " + path;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProgressJournal::close() {
+    if (file) fclose(file);
+    file = nullptr;
+    filePath.clear();
+    entries.clear();
+    latest.clear();
+}
+
+bool ProgressJournal::append(const ProgressRecord &r, string &error) {
+    if (!validStatus(r.status)) {
+        error = "invalid progress status";
+        return false;
+    }
+    if (file && (fwrite(&r, sizeof r, 1, file) != 1 || fflush(file) != 0)) {
+        error = "write failed: " + filePath;
+        return false;
+    }
+    add(r);
+    return true;
+}
+
+const ProgressRecord *ProgressJournal::find(int day, uint32_t slot, uint32_t topic) const {
+    if (day < 0 || latest.empty()) return nullptr;
+    auto it = latest.find(key((uint32_t)day, slot));
+    if (it == latest.end()) return nullptr;
+    const ProgressRecord &r = entries[it->second];
+    return r.topic == topic ? &r : nullptr;
+}
+
+void ProgressJournal::add(const ProgressRecord &r) {
+    latest[key(r.day, r.slot)] = (uint32_t)entries.size();
+    entries.push_back(r);
+}
@@ -0,0 +1,78 @@
+// ProgressJournal.h
+//  Append-only log of what was actually studied: one fixed-size record per
+//  report on a planned slot (done, partly done or skipped). Each record is
+//  written through as it is made, so the file is never rewritten and a
+//  crash loses at most the record being written. The latest record for a
+//  slot wins.
+//
+//  Layout (native byte order):
+//    JournalHeader
+//    ProgressRecord[...]      until the end of the file
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static constexpr uint32_t JOURNAL_VERSION = 1;
+
+struct JournalHeader {
+    char magic[4];           // "ADXJ"
+    uint32_t version;        // JOURNAL_VERSION
+    uint32_t byteOrder;      // 0x01020304 as written by the saving machine
+    uint32_t reserved;
+};
+
+enum class ProgressStatus : uint8_t {
+    Done = 1,
+    Partial = 2,
+    Skipped = 3,
+};
+
+struct ProgressRecord {
+    uint32_t day;            // 0-based plan day
+    uint32_t slot;           // position within the day
+    uint32_t topic;          // flat topic id of the slot, so records a replan made stale are ignored
+    uint16_t minutes;        // minutes actually studied
+    ProgressStatus status;
+    uint8_t reserved;
+};
+
+class ProgressJournal {
+public:
+    ProgressJournal() = default;
+    ~ProgressJournal() { close(); }
+    ProgressJournal(const ProgressJournal &) = delete;
+    ProgressJournal &operator=(const ProgressJournal &) = delete;
+
+    // Loads the journal at path, creating it when missing, and keeps it
+    // open for appending. A torn record at the end is cut off.
+    bool open(const std::string &path, std::string &error);
+    // Closes the file and forgets every record.
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    const std::string &path() const { return filePath; }
+
+    // Adds r, writing it to the file first when one is open.
+    bool append(const ProgressRecord &r, std::string &error);
+
+    // Latest record for slot of day, or nullptr when there is none or it was
+    // made for another topic than the one the slot holds now.
+    const ProgressRecord *find(int day, uint32_t slot, uint32_t topic) const;
+
+    const std::vector<ProgressRecord> &records() const { return entries; }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+private:
+    FILE *file = nullptr;
+    std::string filePath;
+    std::vector<ProgressRecord> entries;
+    std::unordered_map<uint64_t, uint32_t> latest; // day << 32 | slot -> index into entries
+
+    static uint64_t key(uint32_t day, uint32_t slot) { return (uint64_t)day << 32 | slot; }
+    void add(const ProgressRecord &r);
+};
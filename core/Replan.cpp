@@ -0,0 +1,136 @@
+// Replan.cpp
+
+#include "Replan.h"
+#include "PerfStats.h"
+#include "ScheduleConfig.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+// topicState bits
+constexpr uint8_t TOPIC_STARTED = 1; // studied on a kept day; its review chain is running
+constexpr uint8_t TOPIC_REDO = 2;    // last kept slot of the topic was skipped or partly done
+constexpr uint8_t TOPIC_LISTED = 4;  // already in resume.redoTopics
+
+bool matchesSubjects(const ScheduleNames &names, const vector<Subject> &subjects) {
+    size_t n = subjects.size();
+    if (names.subjects.size() != n || names.topicBase.size() != n + 1) return false;
+    for (size_t i = 0; i < n; ++i) {
+        size_t topics = subjects[i].hasTopics() ? subjects[i].getTopicsList().size() : 1;
+        if (names.topicBase[i + 1] - names.topicBase[i] != topics) return false;
+    }
+    return true;
+}
+}
+
+bool Replanner::replan(const PlanInput &plan, const Schedule &current, const ProgressJournal &journal, int firstDay,
+                       Schedule &out, string &error) {
+    PerfScope perf(PerfProbe::Replan);
+    const shared_ptr<const ScheduleNames> &names = current.nameTables();
+    if (!names || !matchesSubjects(*names, plan.subjects)) {
+        error = "the schedule was not generated from these subjects";
+        return false;
+    }
+    uint32_t n = (uint32_t)plan.subjects.size();
+    size_t topics = names->topics.size();
+    int days = max(plan.days, 0);
+    firstDay = min({max(firstDay, 0), days, current.dayCount()});
+    bool reviews = plan.reviewMinutes > 0;
+
+    // One pass over the plan: every study slot counts towards its subject's
+    // planned time; those on kept days are checked against the journal.
+    subjects.assign(n, SubjectProgress());
+    resume.clear();
+    resume.firstDay = firstDay;
+    resume.nextTopic.assign(n, 0);
+    topicState.assign(topics, 0);
+    missed.clear();
+    const vector<ScheduleSlot> &slots = current.allSlots();
+    for (int d = 0; d < current.dayCount(); ++d) {
+        uint32_t begin = current.dayOffset(d);
+        for (uint32_t i = begin; i < current.dayOffset(d + 1); ++i) {
+            const ScheduleSlot &t = slots[i];
+            if (t.kind != SlotKind::Study || t.subject >= n || t.topic >= topics) continue;
+            SubjectProgress &p = subjects[t.subject];
+            p.plannedMinutes += t.minutes;
+            if (d >= firstDay) continue;
+
+            const ProgressRecord *r = journal.find(d, i - begin, t.topic);
+            ProgressStatus status = r ? r->status : ProgressStatus::Done;
+            uint32_t done = t.minutes;
+            if (status == ProgressStatus::Partial) done = min<uint32_t>(r->minutes, t.minutes);
+            else if (status == ProgressStatus::Skipped) done = 0;
+            p.keptMinutes += t.minutes;
+            p.doneMinutes += done;
+            resume.nextTopic[t.subject] = t.topic - names->topicBase[t.subject] + 1;
+
+            uint8_t &state = topicState[t.topic];
+            if (status == ProgressStatus::Done) {
+                state &= (uint8_t)~TOPIC_REDO;
+            } else if (!(state & TOPIC_REDO)) {
+                state |= TOPIC_REDO;
+                missed.emplace_back(t.subject, t.topic);
+            }
+            if (status == ProgressStatus::Skipped || (state & TOPIC_STARTED)) continue;
+            state |= TOPIC_STARTED;
+            resume.startedTopics.push_back(t.topic);
+            if (!reviews) continue;
+            // The chain's next review on or after firstDay, assuming the ones
+            // due on kept days were done.
+            int due = d + REVIEW_INTERVALS[0];
+            uint32_t stage = 0;
+            while (due < firstDay && ++stage < (uint32_t)REVIEW_STAGES) due += REVIEW_INTERVALS[stage];
+            if (stage < (uint32_t)REVIEW_STAGES && due < days) resume.reviews.emplace_back(due, Review{t.subject, t.topic, stage});
+        }
+    }
+
+    // Topics still missed, grouped by subject in the order they were missed.
+    resume.redoStart.assign((size_t)n + 1, 0);
+    size_t listed = 0;
+    for (const pair<uint32_t, uint32_t> &m : missed) {
+        uint8_t &state = topicState[m.second];
+        if ((state & (TOPIC_REDO | TOPIC_LISTED)) != TOPIC_REDO) continue;
+        state |= TOPIC_LISTED;
+        resume.redoStart[m.first + 1]++;
+        missed[listed++] = m;
+    }
+    for (uint32_t i = 0; i < n; ++i) resume.redoStart[i + 1] += resume.redoStart[i];
+    resume.redoTopics.resize(listed);
+    cursor.assign(resume.redoStart.begin(), resume.redoStart.end() - 1);
+    for (size_t k = 0; k < listed; ++k) resume.redoTopics[cursor[missed[k].first]++] = missed[k].second;
+
+    owed.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        SubjectProgress &p = subjects[i];
+        p.owedMinutes = p.plannedMinutes > p.doneMinutes ? p.plannedMinutes - p.doneMinutes : 0;
+        owed[i] = p.owedMinutes;
+    }
+
+    // The generator lets go of the table first, so it can be refilled in place.
+    generator.setSubjectTable(nullptr);
+    if (!table || table.use_count() > 1) table = make_shared<SubjectTable>();
+    fillSubjectTable(*table, names, plan.subjects, owed);
+    generator.setParameters(days, plan.minutesPerDay);
+    generator.setSlotLimits(plan.maxChunkMinutes, plan.minSlotMinutes);
+    generator.setAvailability(plan.availability);
+    generator.setReviews(plan.reviewMinutes, plan.reviewSharePercent);
+    generator.setPolicies(plan.policies);
+    generator.setSubjectTable(table);
+    generator.setResume(resume);
+    generator.prepare();
+
+    uint32_t kept = current.dayOffset(firstDay);
+    out.start(names, days, kept + generator.slotBound());
+    for (int d = 0; d < firstDay; ++d) out.appendDay(current.day(d), current.dayStats(d));
+    while (generator.nextDay()) out.appendDay(generator.currentDay(), generator.currentDayStats());
+    perf.addItems(out.slotCount() - kept);
+    return true;
+}
+
+uint32_t Replanner::totalDebtMinutes() const {
+    uint32_t total = 0;
+    for (const SubjectProgress &p : subjects) total += p.debtMinutes();
+    return total;
+}
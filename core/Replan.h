@@ -0,0 +1,54 @@
+// Replan.h
+//  Replanning from a given day: the days before it stay exactly as they
+//  were, study time planned on them but not done (per the progress journal)
+//  is carried forward as debt, and only the remaining days are planned
+//  again. A replan is one pass over the schedule plus a generation of the
+//  remaining days, on buffers kept between calls.
+
+#pragma once
+
+#include "ProgressJournal.h"
+#include "Schedule.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SubjectProgress {
+    uint32_t plannedMinutes = 0; // study minutes in the whole plan replanned
+    uint32_t keptMinutes = 0;    // of those, on the kept days
+    uint32_t doneMinutes = 0;    // studied on the kept days; slots without a record count as done
+    uint32_t owedMinutes = 0;    // plannedMinutes - doneMinutes, what the remaining days share
+
+    uint32_t debtMinutes() const { return keptMinutes - doneMinutes; }
+};
+
+class Replanner {
+public:
+    // Writes to out a plan that keeps days [0, firstDay) of current and plans
+    // [firstDay, plan.days) again. The remaining time is shared in proportion
+    // to what each subject is still owed, so skipped and partly done slots
+    // raise their subject's share; their topics are studied again first.
+    // current must have been generated from plan.subjects and must not be
+    // out. Returns false, leaving out untouched, when it was not.
+    bool replan(const PlanInput &plan, const Schedule &current, const ProgressJournal &journal, int firstDay,
+                Schedule &out, std::string &error);
+
+    // Per subject, as of the last replan().
+    const std::vector<SubjectProgress> &progress() const { return subjects; }
+    uint32_t totalDebtMinutes() const;
+
+private:
+    ScheduleGenerator generator{0, 0};
+    std::shared_ptr<SubjectTable> table; // refilled in place while the generator is its only other user
+    PlanResume resume;
+    std::vector<SubjectProgress> subjects;
+    std::vector<uint64_t> owed;
+    std::vector<uint8_t> topicState;                    // per flat topic id, see Replan.cpp
+    std::vector<std::pair<uint32_t, uint32_t>> missed;  // subject and topic of slots not done, in plan order
+    std::vector<uint32_t> cursor;                       // per subject: fill position in resume.redoTopics
+};
@@ -0,0 +1,107 @@
+// ReviewQueue.h
+//  Calendar queue of pending spaced-repetition reviews: one FIFO bucket per
+//  plan day, linked through a single node array. Scheduling a review,
+//  taking the next one due and carrying a day's leftovers forward are all
+//  O(1), however many reviews are pending.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Review {
+    uint32_t subject;
+    uint32_t topic; // flat topic id, see ScheduleNames
+    uint32_t stage; // index into the review intervals of the next review
+};
+
+class ReviewQueue {
+public:
+    // Empties the queue for a plan of days days. capacity, when known, is
+    // the most reviews pending at once; reserving it keeps push() from
+    // reallocating.
+    void reset(int days, size_t capacity = 0) {
+        buckets.assign((size_t)(days > 0 ? days : 0), Bucket());
+        nodes.clear();
+        nodes.reserve(capacity);
+        freeNodes = NONE;
+        count = 0;
+    }
+
+    // Adds r behind the reviews already due on day. Returns false, without
+    // adding it, when day is outside the plan.
+    bool push(int day, const Review &r) {
+        if (day < 0 || (size_t)day >= buckets.size()) return false;
+        uint32_t n = freeNodes;
+        if (n != NONE) {
+            freeNodes = nodes[n].next;
+            nodes[n] = Node{r, NONE};
+        } else {
+            n = (uint32_t)nodes.size();
+            nodes.push_back(Node{r, NONE});
+        }
+        Bucket &b = buckets[day];
+        if (b.tail != NONE) nodes[b.tail].next = n;
+        else b.head = n;
+        b.tail = n;
+        ++count;
+        return true;
+    }
+
+    bool empty(int day) const { return buckets[day].head == NONE; }
+
+    // The review due first on day; empty(day) must be false.
+    const Review &front(int day) const { return nodes[buckets[day].head].review; }
+
+    void pop(int day) {
+        Bucket &b = buckets[day];
+        uint32_t n = b.head;
+        b.head = nodes[n].next;
+        if (b.head == NONE) b.tail = NONE;
+        nodes[n].next = freeNodes;
+        freeNodes = n;
+        --count;
+    }
+
+    // Moves the reviews left on day in front of those due on day + 1, so
+    // overdue reviews come first. Reviews left on the last day are dropped.
+    void carryOver(int day) {
+        Bucket &b = buckets[day];
+        if (b.head == NONE) return;
+        if ((size_t)day + 1 < buckets.size()) {
+            Bucket &next = buckets[day + 1];
+            nodes[b.tail].next = next.head;
+            if (next.head == NONE) next.tail = b.tail;
+            next.head = b.head;
+        } else {
+            for (uint32_t n = b.head; n != NONE;) {
+                uint32_t following = nodes[n].next;
+                nodes[n].next = freeNodes;
+                freeNodes = n;
+                --count;
+                n = following;
+            }
+        }
+        b = Bucket();
+    }
+
+    size_t pending() const { return count; }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Node {
+        Review review;
+        uint32_t next;
+    };
+    struct Bucket {
+        uint32_t head = NONE;
+        uint32_t tail = NONE;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Bucket> buckets;
+    uint32_t freeNodes = NONE; // popped nodes, reused by push()
+    size_t count = 0;
+};
@@ -0,0 +1,160 @@
+// Schedule.h
+//  Compact generated schedule: one flat array of fixed-size records holding
+//  indices into shared name tables, plus per-day offsets into that array.
+//  Names are only looked up when a slot is displayed or exported.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Subject and topic names for one subject list. Topic ids are flat: the
+// topics of subject s are ids topicBase[s] .. topicBase[s + 1] - 1.
+struct ScheduleNames {
+    std::vector<std::string> subjects;
+    std::vector<std::string> topics;
+    std::vector<uint32_t> topicBase;
+};
+
+inline bool sameNames(const ScheduleNames &a, const ScheduleNames &b) {
+    return a.topicBase == b.topicBase && a.subjects == b.subjects && a.topics == b.topics;
+}
+
+enum class SlotKind : uint16_t {
+    Study,
+    Review, // spaced-repetition review of a topic studied earlier
+};
+
+// Shown in front of the topic of a review slot.
+static constexpr const char *REVIEW_PREFIX = "Review: ";
+
+struct ScheduleSlot {
+    uint32_t subject; // index into the subject list the schedule was generated from
+    uint32_t topic;   // flat topic id, see ScheduleNames
+    uint16_t minutes; // at most one day
+    SlotKind kind;
+};
+
+// Per-day totals, accumulated while the schedule is built.
+struct DayStats {
+    int difficultySum = 0; // sum of the subject difficulty of every slot
+    int topicCount = 0;    // number of slots
+    int minutes = 0;
+};
+
+class Schedule {
+public:
+    // Contiguous range of one day's records, usable in range-for.
+    class DayView {
+    public:
+        DayView(const ScheduleSlot *b, const ScheduleSlot *e) : first(b), last(e) {}
+        const ScheduleSlot *begin() const { return first; }
+        const ScheduleSlot *end() const { return last; }
+        size_t size() const { return (size_t)(last - first); }
+        bool empty() const { return first == last; }
+    private:
+        const ScheduleSlot *first;
+        const ScheduleSlot *last;
+    };
+
+    int dayCount() const { return dayOffsets.empty() ? 0 : (int)dayOffsets.size() - 1; }
+    bool empty() const { return dayCount() == 0; }
+    size_t slotCount() const { return records.size(); }
+
+    DayView day(int d) const {
+        const ScheduleSlot *base = records.data();
+        return DayView(base + dayOffsets[d], base + dayOffsets[d + 1]);
+    }
+
+    const DayStats &dayStats(int d) const { return stats[d]; }
+
+    // Index of the first slot of day d in allSlots(); dayOffset(dayCount()) == slotCount().
+    uint32_t dayOffset(int d) const { return dayOffsets[d]; }
+    const std::vector<ScheduleSlot> &allSlots() const { return records; }
+
+    // Day (0-based) that slot index i belongs to; O(log days).
+    int dayOfSlot(size_t i) const {
+        auto it = std::upper_bound(dayOffsets.begin(), dayOffsets.end(), (uint32_t)i);
+        return (int)(it - dayOffsets.begin()) - 1;
+    }
+
+    const std::string &subjectName(const ScheduleSlot &s) const { return names->subjects[s.subject]; }
+    const std::string &topicName(const ScheduleSlot &s) const { return names->topics[s.topic]; }
+    const std::shared_ptr<const ScheduleNames> &nameTables() const { return names; }
+
+    // Empties the schedule and drops its names, keeping every buffer.
+    void clear() {
+        names.reset();
+        records.clear();
+        dayOffsets.clear();
+        stats.clear();
+    }
+
+    // Building: start(), then addSlot() for each slot of a day followed by endDay().
+    // slotCapacity, when known, is reserved up front so the slots never regrow.
+    void start(std::shared_ptr<const ScheduleNames> n, int days, size_t slotCapacity = 0) {
+        names = std::move(n);
+        records.clear();
+        records.reserve(slotCapacity);
+        dayOffsets.clear();
+        dayOffsets.reserve((size_t)days + 1);
+        dayOffsets.push_back(0);
+        stats.clear();
+        stats.reserve((size_t)days);
+        current = DayStats();
+    }
+    void addSlot(const ScheduleSlot &s, int difficulty) {
+        records.push_back(s);
+        current.difficultySum += difficulty;
+        current.topicCount++;
+        current.minutes += (int)s.minutes;
+    }
+    void endDay() {
+        dayOffsets.push_back((uint32_t)records.size());
+        stats.push_back(current);
+        current = DayStats();
+    }
+    // Replaces the contents with already built arrays, e.g. from a mapped profile.
+    void assign(std::shared_ptr<const ScheduleNames> n, const ScheduleSlot *s, size_t count,
+                const uint32_t *offsets, int days, const DayStats *dayTotals) {
+        names = std::move(n);
+        records.assign(s, s + count);
+        dayOffsets.assign(offsets, offsets + days + 1);
+        stats.assign(dayTotals, dayTotals + days);
+        current = DayStats();
+    }
+    // Keeps the first days days and drops the rest, e.g. to append others after them.
+    void truncate(int days) {
+        records.resize(dayOffsets[(size_t)days]);
+        dayOffsets.resize((size_t)days + 1);
+        stats.resize((size_t)days);
+        current = DayStats();
+    }
+    // Overwrites day d in place with as many slots as it already has.
+    void replaceDay(int d, const std::vector<ScheduleSlot> &day, const DayStats &totals) {
+        std::copy(day.begin(), day.end(), records.begin() + dayOffsets[(size_t)d]);
+        stats[(size_t)d] = totals;
+    }
+    void setNames(std::shared_ptr<const ScheduleNames> n) { names = std::move(n); }
+    // Adds a whole day whose totals are already known.
+    void appendDay(const std::vector<ScheduleSlot> &day, const DayStats &totals) {
+        records.insert(records.end(), day.begin(), day.end());
+        dayOffsets.push_back((uint32_t)records.size());
+        stats.push_back(totals);
+    }
+    void appendDay(const DayView &day, const DayStats &totals) {
+        records.insert(records.end(), day.begin(), day.end());
+        dayOffsets.push_back((uint32_t)records.size());
+        stats.push_back(totals);
+    }
+
+private:
+    std::vector<ScheduleSlot> records;
+    std::vector<uint32_t> dayOffsets;
+    std::vector<DayStats> stats;
+    DayStats current;
+    std::shared_ptr<const ScheduleNames> names;
+};
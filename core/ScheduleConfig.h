@@ -0,0 +1,30 @@
+// ScheduleConfig.h
+//  Shared limits and defaults for the scheduling core and its front ends.
+//  Durations are whole minutes throughout the core; hours only appear where
+//  people type or read them.
+
+#pragma once
+
+static constexpr int MINUTES_PER_DAY = 24 * 60;
+static constexpr int DEFAULT_DAYS = 14;
+static constexpr int DEFAULT_MINUTES_PER_DAY = 4 * 60;
+static constexpr int MAX_DAYS = 365;
+static constexpr int DEFAULT_MAX_CHUNK_MINUTES = 2 * 60; // longest single study slot
+static constexpr int DEFAULT_MIN_SLOT_MINUTES = 15;      // shortest slot, also the allocation unit
+static constexpr int DEFAULT_REVIEW_MINUTES = 15;        // one spaced-repetition review, when enabled
+static constexpr int DEFAULT_REVIEW_SHARE_PERCENT = 25;  // part of each day kept free for reviews
+static constexpr int MAX_REVIEW_SHARE_PERCENT = 99;      // study always keeps part of the day
+
+// Days between a topic's first study and its reviews, each counted from the
+// previous review.
+static constexpr int REVIEW_INTERVALS[] = {1, 3, 7, 14, 30, 60};
+static constexpr int REVIEW_STAGES = (int)(sizeof REVIEW_INTERVALS / sizeof REVIEW_INTERVALS[0]);
+
+// Hours as entered by a user, rounded to the nearest minute.
+inline int hoursToMinutes(double hours) { return hours <= 0.0 ? 0 : (int)(hours * 60.0 + 0.5); }
+
+// Clock placement: the part of each day sessions may use, as minutes after
+// midnight, and the pause after every session.
+static constexpr int DEFAULT_DAY_START_MINUTE = 9 * 60;
+static constexpr int DEFAULT_DAY_END_MINUTE = 22 * 60;
+static constexpr int DEFAULT_BREAK_MINUTES = 10;
@@ -0,0 +1,537 @@
+// ScheduleGenerator.cpp
+
+#include "ScheduleGenerator.h"
+#include "PerfStats.h"
+#include "ScheduleConfig.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+// Weight, difficulty and exam day of subject i, adjusting the total weight.
+template <class Weighting>
+void fillSubjectRow(SubjectTable &table, size_t i, const Subject &sub) {
+    uint64_t w = Weighting::weight(sub.getDifficulty(), sub.getImportance(), sub.getTopicsCount());
+    table.totalWeight = table.totalWeight - table.weights[i] + w;
+    table.weights[i] = w;
+    table.difficulty[i] = sub.getDifficulty();
+    table.examDay[i] = max(sub.getExamDay(), 0);
+}
+
+void sortDeadlineOrder(SubjectTable &table) {
+    // Clamping exam days to the plan length later keeps this order, so it
+    // serves every plan length.
+    vector<uint32_t> &order = table.deadlineOrder;
+    uint32_t n = (uint32_t)table.size();
+    order.resize(n);
+    for (uint32_t i = 0; i < n; ++i) order[i] = i;
+    const vector<int> &exam = table.examDay;
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        unsigned ea = exam[a] > 0 ? (unsigned)exam[a] : UINT32_MAX;
+        unsigned eb = exam[b] > 0 ? (unsigned)exam[b] : UINT32_MAX;
+        return ea != eb ? ea < eb : a < b;
+    });
+}
+
+// Refills table and names from subjects. Assigning into existing elements
+// reuses their storage, so refilling with the same subjects allocates nothing.
+void fillSubjectTable(SubjectTable &table, ScheduleNames &names, const vector<Subject> &subjects, WeightingPolicy weighting) {
+    size_t n = subjects.size();
+    size_t topicCount = 0;
+    for (const Subject &sub : subjects) topicCount += sub.hasTopics() ? sub.getTopicsList().size() : 1;
+
+    names.subjects.resize(n);
+    names.topics.resize(topicCount);
+    names.topicBase.resize(n + 1);
+    table.weights.assign(n, 0);
+    table.difficulty.resize(n);
+    table.examDay.resize(n);
+    table.totalWeight = 0;
+    table.weighting = weighting;
+    uint32_t topic = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Subject &sub = subjects[i];
+        names.subjects[i] = sub.getName();
+        names.topicBase[i] = topic;
+        if (sub.hasTopics()) {
+            for (const string &t : sub.getTopicsList()) names.topics[topic++] = t;
+        } else {
+            names.topics[topic++] = sub.getTopicAtIndex(0);
+        }
+    }
+    names.topicBase[n] = topic;
+    withWeighting(weighting, [&](auto w) {
+        for (size_t i = 0; i < n; ++i) fillSubjectRow<decltype(w)>(table, i, subjects[i]);
+    });
+    sortDeadlineOrder(table);
+}
+
+// Whether names already holds the name and topics of subject i.
+bool sameSubjectNames(const ScheduleNames &names, size_t i, const Subject &sub) {
+    if (names.subjects[i] != sub.getName()) return false;
+    uint32_t base = names.topicBase[i];
+    uint32_t count = names.topicBase[i + 1] - base;
+    if (!sub.hasTopics()) return count == 1 && names.topics[base] == sub.getTopicAtIndex(0);
+    const vector<string> &topics = sub.getTopicsList();
+    return count == topics.size() && equal(topics.begin(), topics.end(), names.topics.begin() + base);
+}
+}
+
+shared_ptr<const SubjectTable> makeSubjectTable(const vector<Subject> &subjects, WeightingPolicy weighting) {
+    auto table = make_shared<SubjectTable>();
+    auto names = make_shared<ScheduleNames>();
+    fillSubjectTable(*table, *names, subjects, weighting);
+    table->names = move(names);
+    return table;
+}
+
+shared_ptr<const SubjectTable> withWeights(const SubjectTable &table, vector<uint64_t> weights) {
+    auto copy = make_shared<SubjectTable>(table);
+    copy->weights = move(weights);
+    copy->weights.resize(table.size(), 0);
+    copy->totalWeight = 0;
+    for (uint64_t w : copy->weights) copy->totalWeight += w;
+    return copy;
+}
+
+void fillSubjectTable(SubjectTable &table, shared_ptr<const ScheduleNames> names, const vector<Subject> &subjects,
+                      const vector<uint64_t> &weights) {
+    size_t n = subjects.size();
+    table.names = move(names);
+    table.weights.assign(weights.begin(), weights.begin() + min(weights.size(), n));
+    table.weights.resize(n, 0);
+    table.difficulty.resize(n);
+    table.examDay.resize(n);
+    table.totalWeight = 0;
+    for (size_t i = 0; i < n; ++i) {
+        table.totalWeight += table.weights[i];
+        table.difficulty[i] = subjects[i].getDifficulty();
+        table.examDay[i] = max(subjects[i].getExamDay(), 0);
+    }
+    sortDeadlineOrder(table);
+}
+
+void ScheduleGenerator::setSubjects(const vector<Subject> &s) {
+    // Subjects whose revision is unchanged since the last call are what the
+    // table already holds; only the others are looked at, or all of them
+    // when the weighting policy changed.
+    size_t n = s.size();
+    bool sameList = table && table == ownTable && loadedRevisions.size() == n;
+    dirtySubjects.clear();
+    if (sameList) {
+        bool reweigh = ownTable->weighting != policies.weighting;
+        for (size_t i = 0; i < n; ++i)
+            if (reweigh || s[i].getRevision() != loadedRevisions[i]) dirtySubjects.push_back((uint32_t)i);
+        if (dirtySubjects.empty()) return;
+        for (uint32_t i : dirtySubjects)
+            if (!sameSubjectNames(*ownNames, i, s[i])) sameList = false;
+    }
+
+    table.reset();
+    if (sameList) {
+        // Only weights, difficulties or exams changed: the names stay as they
+        // are, shared with any schedule made from them, and only the edited
+        // rows of the table are refilled.
+        if (ownTable.use_count() > 1) ownTable = make_shared<SubjectTable>(*ownTable);
+        bool examsChanged = false;
+        ownTable->weighting = policies.weighting;
+        withWeighting(policies.weighting, [&](auto w) {
+            for (uint32_t i : dirtySubjects) {
+                int exam = ownTable->examDay[i];
+                fillSubjectRow<decltype(w)>(*ownTable, i, s[i]);
+                examsChanged |= ownTable->examDay[i] != exam;
+                loadedRevisions[i] = s[i].getRevision();
+            }
+        });
+        if (examsChanged) sortDeadlineOrder(*ownTable);
+        table = ownTable;
+        return;
+    }
+
+    // The generator's own schedule is replaced by the next run anyway, so
+    // it does not keep the old tables alive.
+    if (ownNames && schedule.nameTables() == ownNames) schedule.clear();
+    if (!ownTable || ownTable.use_count() > 1 || ownNames.use_count() > 2) {
+        ownTable = make_shared<SubjectTable>();
+        ownNames = make_shared<ScheduleNames>();
+        ownTable->names = ownNames;
+    }
+    fillSubjectTable(*ownTable, *ownNames, s, policies.weighting);
+    table = ownTable;
+    loadedRevisions.resize(n);
+    for (size_t i = 0; i < n; ++i) loadedRevisions[i] = s[i].getRevision();
+}
+
+namespace {
+// Heap order: earliest deadline group first, then the most remaining
+// demand, then the lower subject index.
+struct LessDemand {
+    template <class D>
+    bool operator()(const D &a, const D &b) const {
+        if (a.group != b.group) return a.group > b.group;
+        return a.units != b.units ? a.units < b.units : a.subject > b.subject;
+    }
+};
+}
+
+// Largest remainder apportionment of units over order[first, last): each
+// subject gets the floor of its weighted share, the leftover units go to
+// the largest fractional parts. Shares within a group share the
+// denominator groupWeight, so the remainders compare exactly as integers.
+void ScheduleGenerator::apportion(uint64_t units, size_t first, size_t last, uint64_t groupWeight) {
+    const vector<uint64_t> &weights = table->weights;
+    const vector<uint32_t> &order = table->deadlineOrder;
+    uint64_t given = 0;
+    remainders.clear();
+    for (size_t k = first; k < last; ++k) {
+        uint32_t i = order[k];
+        uint64_t share = groupWeight > 0 ? weights[i] * units : 0;
+        uint32_t whole = groupWeight > 0 ? (uint32_t)(share / groupWeight) : 0;
+        demand[i].units = whole;
+        remainders.emplace_back(groupWeight > 0 ? share % groupWeight : 0, i);
+        given += whole;
+    }
+    if (given < units && !remainders.empty()) {
+        size_t extra = (size_t)min<uint64_t>(units - given, remainders.size());
+        nth_element(remainders.begin(), remainders.begin() + extra, remainders.end(),
+                    [](const pair<uint64_t, uint32_t> &a, const pair<uint64_t, uint32_t> &b) {
+                        return a.first != b.first ? a.first > b.first : a.second < b.second;
+                    });
+        for (size_t k = 0; k < extra; ++k) demand[remainders[k].second].units++;
+    }
+}
+
+void ScheduleGenerator::prepare() {
+    if (!table) setSubjects(vector<Subject>());
+    const vector<uint64_t> &weights = table->weights;
+    const vector<uint32_t> &order = table->deadlineOrder;
+    uint64_t totalWeight = table->totalWeight;
+
+    int dayCount = max(days, 0);
+    unitMinutes = (uint32_t)max(1, min({minSlotMinutes, maxChunkMinutes, minutesPerDay}));
+    maxChunkUnits = max<uint32_t>(1, (uint32_t)max(maxChunkMinutes, 0) / unitMinutes);
+    auto unitsFor = [this](int minutes) { return (uint32_t)max(minutes, 0) / unitMinutes; };
+
+    dayUnits.assign(dayCount, unitsFor(minutesPerDay));
+    for (const DayAvailability &a : availability)
+        if (a.day >= 0 && a.day < dayCount) dayUnits[a.day] = unitsFor(a.minutes);
+    // Kept days of a resumed plan have no time left to hand out.
+    int firstDay = min(max(resume.firstDay, 0), dayCount);
+    fill(dayUnits.begin(), dayUnits.begin() + firstDay, 0);
+    // A slot takes at least one unit, so this holds any day whatever the
+    // weights; a reused generator keeps it across edits.
+    if (dayCount > 0) dayRecords.reserve(*max_element(dayUnits.begin(), dayUnits.end()));
+
+    // With reviews, study is planned on the part of each day they do not
+    // claim; what a day's reviews leave of their share is handed back to
+    // study that day (returnReviewTime), so the study total follows the
+    // reviews actually placed.
+    reviewUnits = reviewMinutes > 0 ? min(max<uint32_t>(1, unitsFor(reviewMinutes)), maxChunkUnits) : 0;
+    reviewShare = reviewUnits ? (uint32_t)min(max(reviewSharePercent, 0), MAX_REVIEW_SHARE_PERCENT) : 0;
+    capacityBefore.assign(dayCount + 1, 0);
+    uint64_t allUnits = 0;
+    for (int d = 0; d < dayCount; ++d) {
+        capacityBefore[d + 1] = capacityBefore[d] + dayUnits[d] - reviewCapacity(d);
+        allUnits += dayUnits[d];
+    }
+    uint64_t totalUnits = capacityBefore[dayCount];
+
+    // A subject can be studied up to the day before its exam; subjects
+    // without one use the whole plan.
+    uint32_t n = (uint32_t)table->size();
+    auto endDay = [&](uint32_t i) {
+        int exam = table->examDay[i];
+        return exam > 0 ? min(exam - 1, dayCount) : dayCount;
+    };
+
+    // Water-filling over deadline groups, earliest first: a group gets its
+    // weighted share of the time still unassigned, capped by what is left
+    // before its exam once earlier groups are placed. Time an early exam
+    // cannot use goes to the later groups. This keeps every prefix of
+    // groups within the capacity before its deadline, which is exactly
+    // when an earliest-deadline-first placement meets all of them.
+    demand.resize(n);
+    for (uint32_t i = 0; i < n; ++i) demand[i] = Demand{0, i, 0};
+    groupEnd.clear();
+    groupRemaining.clear();
+    uint64_t unassigned = totalUnits, used = 0;
+    uint64_t weightLeft = totalWeight;
+    for (size_t first = 0; first < n;) {
+        uint32_t end = (uint32_t)endDay(order[first]);
+        size_t last = first;
+        uint64_t groupWeight = 0;
+        while (last < n && (uint32_t)endDay(order[last]) == end) groupWeight += weights[order[last++]];
+
+        uint64_t room = capacityBefore[end] - used;
+        // Rounded half up: groupWeight * unassigned / weightLeft.
+        uint64_t grant = last == n ? unassigned
+                                   : (weightLeft > 0 ? (2 * groupWeight * unassigned + weightLeft) / (2 * weightLeft) : 0);
+        grant = min({grant, room, unassigned});
+        apportion(grant, first, last, groupWeight);
+
+        uint32_t group = (uint32_t)groupEnd.size();
+        for (size_t k = first; k < last; ++k) demand[order[k]].group = group;
+        groupEnd.push_back(end);
+        groupRemaining.push_back(grant);
+        used += grant;
+        unassigned -= grant;
+        weightLeft -= groupWeight;
+        first = last;
+    }
+
+    // A shortfall is at least one unit below the unconstrained share
+    // weight * totalUnits / totalWeight.
+    shortfallList.clear();
+    for (const Demand &d : demand) {
+        uint64_t share = weights[d.subject] * totalUnits;
+        if (totalWeight > 0 && share >= ((uint64_t)d.units + 1) * totalWeight)
+            shortfallList.push_back(DeadlineShortfall{d.subject, (uint32_t)(share * unitMinutes / totalWeight), d.units * unitMinutes});
+    }
+
+    plannedUnits = used;
+    slotLimit = reviewUnits ? allUnits : used;
+    served.clear();
+    served.reserve(n);
+    if (reviewUnits) {
+        subjectGroup.resize(n);
+        for (const Demand &d : demand) subjectGroup[d.subject] = d.group;
+    }
+    demand.erase(remove_if(demand.begin(), demand.end(), [](const Demand &d) { return d.units == 0; }), demand.end());
+    make_heap(demand.begin(), demand.end(), LessDemand());
+    outstanding.assign(groupEnd.size(), 0);
+
+    withRotation(policies.rotation, cyclicRotation, leastRecentRotation,
+                 [this](auto &rotation) { rotation.reset(*table->names, resume.nextTopic); });
+    redoNext.clear();
+    if (resume.redoStart.size() == (size_t)n + 1) redoNext.assign(resume.redoStart.begin(), resume.redoStart.end() - 1);
+    if (reviewUnits) {
+        size_t topics = table->names->topics.size();
+        reviews.reset(dayCount, topics);
+        topicStarted.assign(topics, 0);
+        reviewEnd.resize(n);
+        for (uint32_t i = 0; i < n; ++i) reviewEnd[i] = (uint32_t)endDay(i);
+        returnedUnits.assign(n, 0);
+        returnPending.assign(n, 0);
+        returnJoining.clear();
+        returnJoining.reserve(n);
+        inDemand.assign(n, 0);
+        for (const Demand &d : demand) inDemand[d.subject] = 1;
+        returnQueue.clear();
+        for (uint32_t i = 0; i < n; ++i)
+            if (table->weights[i] > 0 && reviewEnd[i] > (uint32_t)firstDay) returnQueue.push_back(i);
+        make_heap(returnQueue.begin(), returnQueue.end(), [this](uint32_t a, uint32_t b) { return returnOrder(a, b); });
+        for (uint32_t t : resume.startedTopics)
+            if (t < topics) topicStarted[t] = 1;
+        for (const pair<int, Review> &due : resume.reviews)
+            if (due.second.subject < n && due.second.topic < topics) scheduleReview(max(due.first, firstDay), due.second);
+    }
+    nextDayIndex = firstDay;
+}
+
+// How much of today's capacity each prefix of groups must receive so that
+// the rest still fits in the days left before its deadline.
+void ScheduleGenerator::startDay(int day) {
+    firstOutstanding = groupEnd.size();
+    if (groupEnd.size() < 2) return; // one group: any full day keeps it feasible
+    uint64_t pending = 0;
+    for (size_t g = 0; g < groupEnd.size(); ++g) {
+        pending += groupRemaining[g];
+        uint32_t end = max<uint32_t>(groupEnd[g], (uint32_t)day + 1);
+        uint64_t later = capacityBefore[end] - capacityBefore[day + 1];
+        outstanding[g] = pending > later ? pending - later : 0;
+        if (outstanding[g] && firstOutstanding == groupEnd.size()) firstOutstanding = g;
+    }
+}
+
+void ScheduleGenerator::placeUnits(uint32_t group, uint32_t units) {
+    groupRemaining[group] -= units;
+    if (firstOutstanding == groupEnd.size()) return;
+    for (size_t g = group; g < outstanding.size(); ++g)
+        outstanding[g] = outstanding[g] > units ? outstanding[g] - units : 0;
+    while (firstOutstanding < outstanding.size() && outstanding[firstOutstanding] == 0) ++firstOutstanding;
+}
+
+void ScheduleGenerator::addSlot(uint32_t subject, uint32_t topic, uint32_t units, SlotKind kind) {
+    uint32_t minutes = units * unitMinutes;
+    dayRecords.push_back(ScheduleSlot{subject, topic, (uint16_t)minutes, kind});
+    dayTotals.difficultySum += table->difficulty[subject];
+    dayTotals.topicCount++;
+    dayTotals.minutes += (int)minutes;
+}
+
+// Queues r for day unless that is past the plan or the subject's exam.
+void ScheduleGenerator::scheduleReview(int day, const Review &r) {
+    if ((uint32_t)day < reviewEnd[r.subject]) reviews.push(day, r);
+}
+
+// Whether subject a comes after b for the next returned unit: by the
+// Sainte-Lague divisor method, the highest weight / (2 * units returned + 1)
+// goes first, then the lower index.
+bool ScheduleGenerator::returnOrder(uint32_t a, uint32_t b) const {
+    const vector<uint64_t> &weights = table->weights;
+    uint64_t ka = weights[a] * (2 * (uint64_t)returnedUnits[b] + 1);
+    uint64_t kb = weights[b] * (2 * (uint64_t)returnedUnits[a] + 1);
+    return ka != kb ? ka < kb : a > b;
+}
+
+// Adds units of today's unused review share to the study demand of the
+// subjects that can still study. Units go one at a time by returnOrder, so
+// what the days return adds up to shares proportional to the weights
+// whatever the daily amounts, at O(log subjects) a unit. Subjects still in
+// the demand heap take theirs when next popped; the others rejoin it.
+void ScheduleGenerator::returnReviewTime(uint32_t units) {
+    uint32_t day = (uint32_t)nextDayIndex;
+    auto later = [this](uint32_t a, uint32_t b) { return returnOrder(a, b); };
+    while (units > 0 && !returnQueue.empty()) {
+        pop_heap(returnQueue.begin(), returnQueue.end(), later);
+        uint32_t i = returnQueue.back();
+        if (reviewEnd[i] <= day) {
+            returnQueue.pop_back(); // past its exam, for good
+            continue;
+        }
+        returnedUnits[i]++;
+        returnPending[i]++;
+        groupRemaining[subjectGroup[i]]++;
+        if (!inDemand[i]) {
+            inDemand[i] = 1;
+            returnJoining.push_back(i);
+        }
+        --units;
+        push_heap(returnQueue.begin(), returnQueue.end(), later);
+    }
+    for (uint32_t i : returnJoining) {
+        demand.push_back(Demand{returnPending[i], i, subjectGroup[i]});
+        push_heap(demand.begin(), demand.end(), LessDemand());
+        returnPending[i] = 0;
+    }
+    returnJoining.clear();
+}
+
+// Places reviews due today, oldest first, in up to budget units. Each one
+// placed queues the topic's next review. Returns the units used.
+template <class Rotation>
+uint32_t ScheduleGenerator::placeReviews(uint32_t budget, Rotation &rotation) {
+    int day = nextDayIndex;
+    uint32_t used = 0;
+    while (budget - used >= reviewUnits && !reviews.empty(day)) {
+        Review r = reviews.front(day);
+        reviews.pop(day);
+        if ((uint32_t)day >= reviewEnd[r.subject]) continue; // carried past its exam
+        addSlot(r.subject, r.topic, reviewUnits, SlotKind::Review);
+        rotation.studied(r.subject, r.topic);
+        used += reviewUnits;
+        if (++r.stage < (uint32_t)REVIEW_STAGES) scheduleReview(day + REVIEW_INTERVALS[r.stage], r);
+    }
+    return used;
+}
+
+template <class Rotation>
+bool ScheduleGenerator::advanceDay(Rotation &rotation) {
+    if (nextDayIndex >= days) return false;
+
+    dayRecords.clear();
+    dayTotals = DayStats();
+    uint32_t left = dayUnits[nextDayIndex];
+    if (reviewUnits) {
+        uint32_t share = min(left, reviewCapacity(nextDayIndex));
+        uint32_t placed = placeReviews(share, rotation);
+        left -= placed;
+        if (placed < share) returnReviewTime(share - placed);
+    }
+    startDay(nextDayIndex);
+
+    auto requeueServed = [this] {
+        for (const Demand &d : served) {
+            demand.push_back(d);
+            push_heap(demand.begin(), demand.end(), LessDemand());
+        }
+        served.clear();
+    };
+
+    // Rounds: the earliest deadline, then the most remaining demand, gets
+    // the next slot, and each subject gets at most one slot per round. A
+    // new round starts when every subject with demand has been served, or
+    // early when an earlier group still needs today's time to stay on
+    // track for its exam.
+    while (left > 0) {
+        if (demand.empty()) {
+            if (served.empty()) break;
+            requeueServed();
+            continue;
+        }
+
+        pop_heap(demand.begin(), demand.end(), LessDemand());
+        Demand d = demand.back();
+        demand.pop_back();
+
+        if (reviewUnits && returnPending[d.subject]) {
+            // Review time was returned to it since it was queued.
+            d.units += returnPending[d.subject];
+            returnPending[d.subject] = 0;
+            demand.push_back(d);
+            push_heap(demand.begin(), demand.end(), LessDemand());
+            continue;
+        }
+        if (groupEnd[d.group] <= (uint32_t)nextDayIndex) {
+            // Past its exam; cannot happen while the plan is feasible.
+            groupRemaining[d.group] -= d.units;
+            if (reviewUnits) inDemand[d.subject] = 0;
+            continue;
+        }
+        if (d.group > firstOutstanding && !served.empty()) {
+            demand.push_back(d);
+            push_heap(demand.begin(), demand.end(), LessDemand());
+            requeueServed();
+            continue;
+        }
+
+        uint32_t units = min({d.units, maxChunkUnits, left});
+        uint32_t i = d.subject;
+        uint32_t topic;
+        if (!redoNext.empty() && redoNext[i] < resume.redoStart[i + 1]) {
+            topic = resume.redoTopics[redoNext[i]++];
+            rotation.studied(i, topic);
+        } else {
+            topic = rotation.next(i);
+        }
+
+        addSlot(i, topic, units, SlotKind::Study);
+        if (reviewUnits && !topicStarted[topic]) {
+            topicStarted[topic] = 1;
+            scheduleReview(nextDayIndex + REVIEW_INTERVALS[0], Review{i, topic, 0});
+        }
+
+        d.units -= units;
+        left -= units;
+        placeUnits(d.group, units);
+        if (d.units > 0) served.push_back(d);
+        else if (reviewUnits) inDemand[i] = 0;
+    }
+
+    // Subjects served today compete again tomorrow.
+    requeueServed();
+
+    // Time study left over takes more of today's reviews; the rest wait.
+    if (reviewUnits) {
+        placeReviews(left, rotation);
+        reviews.carryOver(nextDayIndex);
+    }
+
+    ++nextDayIndex;
+    return true;
+}
+
+bool ScheduleGenerator::nextDay() {
+    return withRotation(policies.rotation, cyclicRotation, leastRecentRotation,
+                        [this](auto &rotation) { return advanceDay(rotation); });
+}
+
+void ScheduleGenerator::generateSchedule() {
+    PerfScope perf(PerfProbe::Generate);
+    prepare();
+    schedule.start(table->names, days, slotBound());
+    while (nextDay())
+        schedule.appendDay(dayRecords, dayTotals);
+    perf.addItems(schedule.slotCount());
+}
@@ -0,0 +1,237 @@
+// ScheduleGenerator.h
+//  ScheduleGenerator: proportional study-time allocation, planned earliest
+//  exam first so every subject's time lands before its exam, with optional
+//  spaced-repetition reviews of every topic studied
+
+#pragma once
+
+#include "ReviewQueue.h"
+#include "Schedule.h"
+#include "ScheduleConfig.h"
+#include "SchedulePolicies.h"
+#include "Subject.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Study minutes for one day that differ from the plan's minutes per day.
+struct DayAvailability {
+    int day; // 0-based
+    int minutes;
+};
+
+// A subject whose exam leaves less study time than its weighted share.
+struct DeadlineShortfall {
+    uint32_t subject;
+    uint32_t wantedMinutes;  // weighted share of all available time
+    uint32_t plannedMinutes; // what fits before the exam
+};
+
+// The part of a plan that does not depend on days or hours: interned
+// names, weights and exam days. It is immutable once built, so generators
+// for many variants of one plan can share it instead of each copying the
+// subjects and recomputing the weights.
+struct SubjectTable {
+    std::shared_ptr<const ScheduleNames> names;
+    std::vector<uint64_t> weights;  // by the weighting policy unless overridden
+    uint64_t totalWeight = 0;
+    WeightingPolicy weighting = WeightingPolicy::Product;
+    std::vector<int> difficulty;
+    std::vector<int> examDay;       // 1-based, 0 when none
+    std::vector<uint32_t> deadlineOrder; // subjects by exam day (none last), then index
+
+    size_t size() const { return weights.size(); }
+};
+
+std::shared_ptr<const SubjectTable> makeSubjectTable(const std::vector<Subject> &subjects,
+                                                     WeightingPolicy weighting = WeightingPolicy::Product);
+
+// Copy of table sharing its names, with weights replaced. weights must
+// have one entry per subject.
+std::shared_ptr<const SubjectTable> withWeights(const SubjectTable &table, std::vector<uint64_t> weights);
+
+// Refills table over names, which must hold exactly these subjects, with
+// their difficulties and exam days and the given weights, one per subject.
+// Reusing a table allocates nothing once its buffers have grown.
+void fillSubjectTable(SubjectTable &table, std::shared_ptr<const ScheduleNames> names,
+                      const std::vector<Subject> &subjects, const std::vector<uint64_t> &weights);
+
+// Where a replan picks up a plan whose earlier days are kept: study time is
+// only planned from firstDay on. Each subject first studies its redo topics
+// again, then continues its topic rotation at nextTopic. Topics listed as
+// started had their first slot on a kept day, so they start no new review
+// chain; the reviews of those chains still due are listed by due day.
+struct PlanResume {
+    int firstDay = 0;
+    std::vector<size_t> nextTopic;      // per subject: position in its topic rotation
+    std::vector<uint32_t> redoStart;    // subjects + 1 offsets into redoTopics
+    std::vector<uint32_t> redoTopics;   // flat topic ids, in the order they are studied again
+    std::vector<uint32_t> startedTopics;
+    std::vector<std::pair<int, Review>> reviews;
+
+    void clear() {
+        firstDay = 0;
+        nextTopic.clear();
+        redoStart.clear();
+        redoTopics.clear();
+        startedTopics.clear();
+        reviews.clear();
+    }
+};
+
+class ScheduleGenerator {
+private:
+    std::shared_ptr<const SubjectTable> table;
+    // Table built by setSubjects(), refilled in place by the next call
+    // when no schedule or other generator still refers to it.
+    std::shared_ptr<SubjectTable> ownTable;
+    std::shared_ptr<ScheduleNames> ownNames;
+    std::vector<uint64_t> loadedRevisions; // Subject::getRevision() of each subject in ownTable
+    std::vector<uint32_t> dirtySubjects;   // scratch: subjects edited since the last setSubjects()
+    Schedule schedule;
+    int days;
+    int minutesPerDay;
+    int maxChunkMinutes = DEFAULT_MAX_CHUNK_MINUTES;
+    int minSlotMinutes = DEFAULT_MIN_SLOT_MINUTES;
+    std::vector<DayAvailability> availability;
+    int reviewMinutes = 0;
+    int reviewSharePercent = DEFAULT_REVIEW_SHARE_PERCENT;
+    SchedulePolicies policies;
+
+    // Remaining demand of one subject, in units of the minimum slot length.
+    // Subjects sharing an exam day form a deadline group; groups are
+    // numbered by ascending last study day.
+    struct Demand {
+        uint32_t units;
+        uint32_t subject;
+        uint32_t group;
+    };
+
+    // Allocation state for the current run. Time is handed out in whole
+    // units of unitMinutes, so no slot is shorter than the minimum.
+    uint32_t unitMinutes = 1;
+    uint32_t maxChunkUnits = 0;
+    std::vector<uint32_t> dayUnits;       // capacity of each day
+    std::vector<uint64_t> capacityBefore; // units of days [0, d)
+    std::vector<uint32_t> groupEnd;       // per group: first day it can no longer use
+    std::vector<uint64_t> groupRemaining; // per group: units still to place
+    std::vector<uint64_t> outstanding;    // per group: units today must still give to groups <= it
+    size_t firstOutstanding = 0;
+    uint64_t plannedUnits = 0;            // units handed out by prepare()
+    uint64_t slotLimit = 0;               // most slots the run can produce
+    std::vector<Demand> demand; // heap: earliest group, then most remaining units
+    std::vector<Demand> served; // subjects already given a slot in this round
+    std::vector<DeadlineShortfall> shortfallList;
+
+    // Spaced repetition: pending reviews by due day. A topic's first slot
+    // starts its chain of reviews; later slots of the same topic do not.
+    uint32_t reviewUnits = 0;             // length of one review, 0 when off
+    uint32_t reviewShare = 0;             // percent of each day kept for reviews
+    ReviewQueue reviews;
+    std::vector<uint8_t> topicStarted;    // per flat topic id
+    std::vector<uint32_t> reviewEnd;      // per subject: first day without reviews
+    std::vector<uint32_t> subjectGroup;   // per subject: its deadline group
+    std::vector<uint32_t> returnedUnits;  // per subject: unused review units handed to it so far
+    std::vector<uint32_t> returnQueue;    // heap: subjects by returnOrder
+    std::vector<uint32_t> returnPending;  // per subject: returned units not yet in its demand entry
+    std::vector<uint32_t> returnJoining;  // scratch: subjects without demand given units today
+    std::vector<uint8_t> inDemand;        // per subject: has an entry in demand or served
+
+    PlanResume resume;
+    std::vector<uint32_t> redoNext;       // per subject: next entry of resume.redoTopics
+
+    // Topic order; only the one policies.rotation selects is used in a run.
+    CyclicRotation cyclicRotation;
+    LeastRecentRotation leastRecentRotation;
+
+    // Scratch buffers kept between runs so a reused generator does not reallocate them.
+    std::vector<std::pair<uint64_t, uint32_t>> remainders; // exact remainder numerators
+
+    void apportion(uint64_t units, size_t first, size_t last, uint64_t groupWeight);
+    void startDay(int day);
+    void placeUnits(uint32_t group, uint32_t units);
+    void addSlot(uint32_t subject, uint32_t topic, uint32_t units, SlotKind kind);
+    void scheduleReview(int day, const Review &r);
+    bool returnOrder(uint32_t a, uint32_t b) const;
+    void returnReviewTime(uint32_t units);
+    // The day loop, instantiated once per rotation policy.
+    template <class Rotation> uint32_t placeReviews(uint32_t budget, Rotation &rotation);
+    template <class Rotation> bool advanceDay(Rotation &rotation);
+    uint32_t reviewCapacity(int day) const { return (uint32_t)((uint64_t)dayUnits[day] * reviewShare / 100); }
+
+    // Lazy generation state: the day produced by the last nextDay() call.
+    int nextDayIndex = 0;
+    std::vector<ScheduleSlot> dayRecords;
+    DayStats dayTotals;
+public:
+    ScheduleGenerator(int d, int minutesPerDay) : days(d), minutesPerDay(minutesPerDay) {}
+
+    void setParameters(int d, int mpd) { days = d; minutesPerDay = mpd; }
+
+    // Every slot lasts a whole multiple of minSlot minutes and at most
+    // maxChunk minutes. minSlot is clamped to maxChunk and to the day length.
+    void setSlotLimits(int maxChunk, int minSlot) { maxChunkMinutes = maxChunk; minSlotMinutes = minSlot; }
+
+    // Per-day study minutes overriding minutesPerDay; 0 makes a day free.
+    void setAvailability(const std::vector<DayAvailability> &days) { availability = days; }
+
+    // Spaced-repetition reviews of minutes each (rounded down to whole
+    // minimum slots), 0 to turn them off. Every studied topic is reviewed
+    // REVIEW_INTERVALS days after its first slot, then again after each
+    // longer interval. Each day keeps up to sharePercent (below 100) of its
+    // time for the reviews due; whatever they leave goes to study, and
+    // reviews that do not fit move to the next day ahead of that day's own.
+    void setReviews(int minutes, int sharePercent = DEFAULT_REVIEW_SHARE_PERCENT) {
+        reviewMinutes = minutes;
+        reviewSharePercent = sharePercent;
+    }
+
+    // Weighting and topic rotation. The weighting applies to the tables
+    // setSubjects() builds from then on; tables from setSubjectTable() keep
+    // their own weights.
+    void setPolicies(const SchedulePolicies &p) { policies = p; }
+    const SchedulePolicies &getPolicies() const { return policies; }
+
+    // Plans only the days from r.firstDay on, continuing where the kept
+    // days left off; an empty PlanResume (the default) plans the whole range.
+    // The buffers are assigned, not replaced, so resuming again reuses them.
+    void setResume(const PlanResume &r) { resume = r; }
+
+    // Reads the subjects without keeping a reference to them. Names and
+    // weights go into the generator's own table, whose buffers are reused
+    // by the next call, so regenerating a plan allocates nothing once the
+    // buffers have grown. Subjects are tracked by revision: a call with the
+    // same list only refills the edited subjects, and keeps the names
+    // (shared with earlier schedules) when only numbers were edited.
+    void setSubjects(const std::vector<Subject> &s);
+
+    // Uses a table built once and shared with other generators.
+    void setSubjectTable(std::shared_ptr<const SubjectTable> t) { table = std::move(t); }
+
+    void generateSchedule();
+
+    const Schedule& getSchedule() const { return schedule; }
+
+    // Lazy generation, one day at a time: prepare(), then nextDay() until it
+    // returns false. Only the current day is held in memory; its slots stay
+    // valid until the next call. getSchedule() is not touched.
+    void prepare();
+    bool nextDay();
+    int currentDayIndex() const { return nextDayIndex - 1; }
+    Schedule::DayView currentDay() const { return Schedule::DayView(dayRecords.data(), dayRecords.data() + dayRecords.size()); }
+    const DayStats &currentDayStats() const { return dayTotals; }
+
+    // Subjects the last prepare() could not give their full share because
+    // of their exam day, in subject order.
+    const std::vector<DeadlineShortfall> &shortfalls() const { return shortfallList; }
+
+    // Upper bound on the slots the last prepare() will produce, for sizing
+    // the output before the first day.
+    size_t slotBound() const { return (size_t)slotLimit; }
+
+    int getDays() const { return days; }
+    const std::shared_ptr<const ScheduleNames> &nameTables() const { return table->names; }
+    const SubjectTable &subjectTable() const { return *table; }
+};
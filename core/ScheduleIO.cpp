@@ -0,0 +1,465 @@
+// ScheduleIO.cpp
+
+#include "ScheduleIO.h"
+#include "ClockPlacement.h"
+#include "Json.h"
+#include "PerfStats.h"
+
+#include <charconv>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+using namespace std;
+
+static string trimmed(const string &s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == string::npos) return string();
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static bool lineError(string &error, int lineNo, const string &msg) {
+    error = "line " + to_string(lineNo) + ": " + msg;
+    return false;
+}
+
+// True when nothing but blanks is left on the line.
+static bool atEnd(istringstream &fields) {
+    fields >> ws;
+    return fields.eof();
+}
+
+// Line-at-a-time parser shared by readPlan and readBatch. A line is a
+// setting only when the whole of it reads as one; inside a subject block
+// any other line is a topic, so topics such as "days of the week" or
+// "exam technique" are kept.
+namespace {
+class PlanParser {
+public:
+    bool feed(const string &line, int lineNo, PlanInput &plan, string &error) {
+        istringstream fields(line);
+        string keyword;
+        fields >> keyword;
+
+        if (keyword == "days") {
+            int d = 0;
+            string msg = "days must be between 1 and " + to_string(MAX_DAYS);
+            if (!(fields >> d) || !atEnd(fields)) return topic(line, lineNo, plan, error, msg);
+            if (d < 1 || d > MAX_DAYS) return lineError(error, lineNo, msg);
+            plan.days = d;
+            inSubject = false;
+        } else if (keyword == "hours") {
+            double h = 0.0;
+            string msg = "hours must be between 0.5 and 24";
+            if (!(fields >> h) || !atEnd(fields)) return topic(line, lineNo, plan, error, msg);
+            if (h < 0.5 || h > 24.0) return lineError(error, lineNo, msg);
+            plan.minutesPerDay = hoursToMinutes(h);
+            inSubject = false;
+        } else if (keyword == "max-chunk" || keyword == "min-slot") {
+            double h = 0.0;
+            string msg = keyword + " must be between 0.05 and 24";
+            if (!(fields >> h) || !atEnd(fields)) return topic(line, lineNo, plan, error, msg);
+            if (h < 0.05 || h > 24.0) return lineError(error, lineNo, msg);
+            (keyword == "max-chunk" ? plan.maxChunkMinutes : plan.minSlotMinutes) = hoursToMinutes(h);
+            inSubject = false;
+        } else if (keyword == "available") {
+            int d = 0;
+            double h = -1.0;
+            string msg = "expected 'available <day 1-" + to_string(MAX_DAYS) + "> <hours 0-24>'";
+            if (!(fields >> d >> h) || !atEnd(fields)) return topic(line, lineNo, plan, error, msg);
+            if (d < 1 || d > MAX_DAYS || h < 0.0 || h > 24.0) return lineError(error, lineNo, msg);
+            plan.availability.push_back(DayAvailability{d - 1, hoursToMinutes(h)});
+            inSubject = false;
+        } else if (keyword == "reviews") {
+            double h = 0.0;
+            int share = DEFAULT_REVIEW_SHARE_PERCENT;
+            string msg = "expected 'reviews <hours per review> [percent of each day]'";
+            if (!(fields >> h) || (!atEnd(fields) && (!(fields >> share) || !atEnd(fields))))
+                return topic(line, lineNo, plan, error, msg);
+            if (h < 0.0 || h > 24.0) return lineError(error, lineNo, msg);
+            if (share < 1 || share > MAX_REVIEW_SHARE_PERCENT)
+                return lineError(error, lineNo, "review share must be between 1 and 99 percent");
+            plan.reviewMinutes = hoursToMinutes(h);
+            plan.reviewSharePercent = share;
+            inSubject = false;
+        } else if (keyword == "weighting") {
+            string name;
+            WeightingPolicy weighting = plan.policies.weighting;
+            if (!(fields >> name) || !atEnd(fields) || !parseWeighting(name, weighting))
+                return topic(line, lineNo, plan, error, "weighting must be product, log-difficulty or importance-squared");
+            plan.policies.weighting = weighting;
+            inSubject = false;
+        } else if (keyword == "rotation") {
+            string name;
+            RotationPolicy rotation = plan.policies.rotation;
+            if (!(fields >> name) || !atEnd(fields) || !parseRotation(name, rotation))
+                return topic(line, lineNo, plan, error, "rotation must be cyclic or least-recent");
+            plan.policies.rotation = rotation;
+            inSubject = false;
+        } else if (keyword == "exam" && inSubject) {
+            int d = 0;
+            if (!(fields >> d) || !atEnd(fields)) return topic(line, lineNo, plan, error);
+            if (d < 1 || d > MAX_DAYS)
+                return lineError(error, lineNo, "exam day must be between 1 and " + to_string(MAX_DAYS));
+            plan.subjects.back().setExamDay(d);
+        } else if (keyword == "subject") {
+            int diff = 0, imp = 0;
+            string name;
+            string msg = "expected 'subject <difficulty 1-10> <importance 1-10> <name>'";
+            if (!(fields >> diff >> imp)) return topic(line, lineNo, plan, error, msg);
+            getline(fields, name);
+            name = trimmed(name);
+            if (name.empty()) return topic(line, lineNo, plan, error, "subject name cannot be empty");
+            if (diff < 1 || diff > 10 || imp < 1 || imp > 10) return lineError(error, lineNo, msg);
+            if (!finish(lineNo, plan, error)) return false;
+
+            Subject s;
+            s.setName(name);
+            s.setDifficulty(diff);
+            s.setImportance(imp);
+            plan.subjects.push_back(s);
+            inSubject = true;
+        } else {
+            return topic(line, lineNo, plan, error);
+        }
+        return true;
+    }
+
+    // Checks the subject block that is currently open, if any.
+    bool finish(int lineNo, const PlanInput &plan, string &error) {
+        if (!plan.subjects.empty() && !plan.subjects.back().hasTopics())
+            return lineError(error, lineNo, "subject '" + plan.subjects.back().getName() + "' has no topics");
+        return true;
+    }
+
+    void reset() { inSubject = false; }
+
+private:
+    bool inSubject = false;
+
+    // Adds line as a topic of the open subject; outside of one it is an
+    // error, reported as notTopic (e.g. the malformed setting it starts as).
+    bool topic(const string &line, int lineNo, PlanInput &plan, string &error,
+               const string &notTopic = "topic outside of a subject block") {
+        if (!inSubject) return lineError(error, lineNo, notTopic);
+        plan.subjects.back().addTopic(line);
+        plan.subjects.back().setTopics(plan.subjects.back().getTopicsCount() + 1);
+        return true;
+    }
+};
+}
+
+void loadPlan(ScheduleGenerator &gen, const PlanInput &plan) {
+    gen.setParameters(plan.days, plan.minutesPerDay);
+    gen.setSlotLimits(plan.maxChunkMinutes, plan.minSlotMinutes);
+    gen.setAvailability(plan.availability);
+    gen.setReviews(plan.reviewMinutes, plan.reviewSharePercent);
+    gen.setPolicies(plan.policies);
+    gen.setSubjects(plan.subjects);
+}
+
+bool readPlan(istream &in, PlanInput &plan, string &error) {
+    PlanParser parser;
+    string raw;
+    int lineNo = 0;
+
+    while (getline(in, raw)) {
+        ++lineNo;
+        string line = trimmed(raw);
+        if (line.empty() || line[0] == '#') continue;
+        if (!parser.feed(line, lineNo, plan, error)) return false;
+    }
+    return parser.finish(lineNo, plan, error);
+}
+
+static bool keyError(string &error, const string &key, const string &msg) {
+    error = key + ": " + msg;
+    return false;
+}
+
+// Reads the optional number at key into value; false when present but out of [lo, hi].
+static bool jsonNumber(const JsonValue &obj, const char *key, double lo, double hi, double &value, bool &present) {
+    const JsonValue *v = obj.find(key);
+    present = v != nullptr;
+    if (!v) return true;
+    if (!v->isNumber() || v->number < lo || v->number > hi) return false;
+    value = v->number;
+    return true;
+}
+
+static bool jsonInt(const JsonValue &obj, const char *key, int lo, int hi, int &value, bool &present) {
+    double d = 0.0;
+    if (!jsonNumber(obj, key, lo, hi, d, present)) return false;
+    if (!present) return true;
+    if (d != (double)(int)d) return false;
+    value = (int)d;
+    return true;
+}
+
+bool readPlanJson(string_view text, PlanInput &plan, string &error) {
+    JsonValue root;
+    if (!parseJson(text, root, error)) return false;
+    if (!root.isObject()) {
+        error = "expected a JSON object";
+        return false;
+    }
+
+    bool present = false;
+    double h = 0.0;
+    if (!jsonInt(root, "days", 1, MAX_DAYS, plan.days, present))
+        return keyError(error, "days", "must be a whole number between 1 and " + to_string(MAX_DAYS));
+    if (!jsonNumber(root, "hours", 0.5, 24.0, h, present))
+        return keyError(error, "hours", "must be between 0.5 and 24");
+    if (present) plan.minutesPerDay = hoursToMinutes(h);
+    if (!jsonNumber(root, "max_chunk", 0.05, 24.0, h, present))
+        return keyError(error, "max_chunk", "must be between 0.05 and 24");
+    if (present) plan.maxChunkMinutes = hoursToMinutes(h);
+    if (!jsonNumber(root, "min_slot", 0.05, 24.0, h, present))
+        return keyError(error, "min_slot", "must be between 0.05 and 24");
+    if (present) plan.minSlotMinutes = hoursToMinutes(h);
+    if (!jsonNumber(root, "reviews", 0.0, 24.0, h, present))
+        return keyError(error, "reviews", "must be between 0 and 24");
+    if (present) plan.reviewMinutes = hoursToMinutes(h);
+    if (!jsonInt(root, "review_share", 1, MAX_REVIEW_SHARE_PERCENT, plan.reviewSharePercent, present))
+        return keyError(error, "review_share", "must be a whole number between 1 and 99");
+
+    if (const JsonValue *weighting = root.find("weighting")) {
+        if (!weighting->isString() || !parseWeighting(weighting->text, plan.policies.weighting))
+            return keyError(error, "weighting", "must be \"product\", \"log-difficulty\" or \"importance-squared\"");
+    }
+    if (const JsonValue *rotation = root.find("rotation")) {
+        if (!rotation->isString() || !parseRotation(rotation->text, plan.policies.rotation))
+            return keyError(error, "rotation", "must be \"cyclic\" or \"least-recent\"");
+    }
+
+    if (const JsonValue *available = root.find("available")) {
+        if (!available->isArray())
+            return keyError(error, "available", "expected an array of {\"day\", \"hours\"}");
+        for (size_t i = 0; i < available->items.size(); ++i) {
+            const JsonValue &a = available->items[i];
+            string key = "available[" + to_string(i) + "]";
+            int d = 0;
+            bool hasDay = false, hasHours = false;
+            if (!a.isObject() || !jsonInt(a, "day", 1, MAX_DAYS, d, hasDay) ||
+                !jsonNumber(a, "hours", 0.0, 24.0, h, hasHours) || !hasDay || !hasHours)
+                return keyError(error, key, "expected {\"day\": 1-" + to_string(MAX_DAYS) + ", \"hours\": 0-24}");
+            plan.availability.push_back(DayAvailability{d - 1, hoursToMinutes(h)});
+        }
+    }
+
+    const JsonValue *subjects = root.find("subjects");
+    if (!subjects || !subjects->isArray())
+        return keyError(error, "subjects", "expected an array of subjects");
+    plan.subjects.reserve(plan.subjects.size() + subjects->items.size());
+    for (size_t i = 0; i < subjects->items.size(); ++i) {
+        const JsonValue &js = subjects->items[i];
+        string key = "subjects[" + to_string(i) + "]";
+        if (!js.isObject()) return keyError(error, key, "expected an object");
+
+        const JsonValue *name = js.find("name");
+        if (!name || !name->isString() || name->text.empty())
+            return keyError(error, key + ".name", "expected a non-empty string");
+        int diff = 0, imp = 0, exam = 0;
+        bool hasDiff = false, hasImp = false;
+        if (!jsonInt(js, "difficulty", 1, 10, diff, hasDiff) || !hasDiff)
+            return keyError(error, key + ".difficulty", "must be a whole number between 1 and 10");
+        if (!jsonInt(js, "importance", 1, 10, imp, hasImp) || !hasImp)
+            return keyError(error, key + ".importance", "must be a whole number between 1 and 10");
+        if (!jsonInt(js, "exam", 1, MAX_DAYS, exam, present))
+            return keyError(error, key + ".exam", "must be a whole number between 1 and " + to_string(MAX_DAYS));
+        const JsonValue *topics = js.find("topics");
+        if (!topics || !topics->isArray() || topics->items.empty())
+            return keyError(error, key + ".topics", "expected a non-empty array of strings");
+
+        Subject s;
+        s.setName(name->text);
+        s.setDifficulty(diff);
+        s.setImportance(imp);
+        s.setExamDay(exam);
+        s.reserveTopics(topics->items.size());
+        for (const JsonValue &t : topics->items) {
+            if (!t.isString()) return keyError(error, key + ".topics", "expected a non-empty array of strings");
+            s.addTopic(t.text);
+        }
+        s.setTopics((int)topics->items.size());
+        plan.subjects.push_back(move(s));
+    }
+    return true;
+}
+
+bool readBatch(istream &in, vector<BatchJob> &jobs, string &error) {
+    PlanParser parser;
+    PlanInput defaults;
+    string raw;
+    int lineNo = 0;
+
+    while (getline(in, raw)) {
+        ++lineNo;
+        string line = trimmed(raw);
+        if (line.empty() || line[0] == '#') continue;
+
+        if (line.compare(0, 8, "student ") == 0 || line == "student") {
+            if (!jobs.empty() && !parser.finish(lineNo, jobs.back().plan, error)) return false;
+            string id = trimmed(line.substr(7));
+            if (id.empty())
+                return lineError(error, lineNo, "student id cannot be empty");
+            BatchJob job;
+            job.id = id;
+            job.plan = defaults; // every setting; defaults has no subjects
+            jobs.push_back(move(job));
+            parser.reset();
+            continue;
+        }
+
+        // Settings before the first student are defaults for every student.
+        PlanInput &target = jobs.empty() ? defaults : jobs.back().plan;
+        if (!parser.feed(line, lineNo, target, error)) return false;
+        if (jobs.empty() && !defaults.subjects.empty())
+            return lineError(error, lineNo, "subjects must follow a 'student <id>' line");
+    }
+    if (!jobs.empty() && !parser.finish(lineNo, jobs.back().plan, error)) return false;
+    return true;
+}
+
+size_t formatTimeTo(char *buf, int minutes) {
+    int h = minutes / 60;
+    int m = minutes % 60;
+    char *p = buf;
+    if (h == 0 && m > 0) {
+        p = to_chars(p, buf + 32, m).ptr;
+        memcpy(p, " min", 4);
+        return (size_t)(p + 4 - buf);
+    }
+    p = to_chars(p, buf + 32, h).ptr;
+    *p++ = 'h';
+    if (m == 0)
+        return (size_t)(p - buf);
+    *p++ = ' ';
+    if (m < 10) *p++ = '0';
+    p = to_chars(p, buf + 32, m).ptr;
+    *p++ = 'm';
+    return (size_t)(p - buf);
+}
+
+string formatTime(int minutes) {
+    char buf[32];
+    return string(buf, formatTimeTo(buf, minutes));
+}
+
+void writeCsvHeader(CsvWriter &csv, bool withStudent, bool withTimes) {
+    if (withStudent) csv.field("Student");
+    csv.field("Day");
+    if (withTimes) {
+        csv.field("Start");
+        csv.field("End");
+    }
+    csv.field("Subject");
+    csv.field("Topic");
+    csv.field("Time");
+    csv.endRow();
+}
+
+// starts, when given, holds the clock times of this day's slots.
+static size_t writeCsvDay(CsvWriter &csv, int d, Schedule::DayView day, const ScheduleNames &names, const string &student,
+                          const uint16_t *starts = nullptr) {
+    for (const ScheduleSlot &t : day) {
+        if (!student.empty()) csv.field(student);
+        csv.field(d + 1);
+        if (starts) {
+            uint16_t start = *starts++;
+            if (start == NO_CLOCK_TIME) {
+                csv.field("");
+                csv.field("");
+            } else {
+                csv.clockField(start);
+                csv.clockField(start + t.minutes);
+            }
+        }
+        csv.field(names.subjects[t.subject]);
+        csv.field(t.kind == SlotKind::Review ? REVIEW_PREFIX : "", names.topics[t.topic]);
+        csv.timeField((int)t.minutes);
+        csv.endRow();
+    }
+    return day.size();
+}
+
+size_t writeCsvRows(CsvWriter &csv, const Schedule &schedule, const string &student, const vector<uint16_t> *starts) {
+    PerfScope perf(PerfProbe::SaveCsv);
+    size_t rows = 0;
+    if (schedule.empty()) return rows;
+    if (starts && starts->size() != schedule.slotCount()) starts = nullptr;
+    const ScheduleNames &names = *schedule.nameTables();
+    for (int d = 0; d < schedule.dayCount(); ++d)
+        rows += writeCsvDay(csv, d, schedule.day(d), names, student,
+                            starts ? starts->data() + schedule.dayOffset(d) : nullptr);
+    perf.addItems(rows);
+    return rows;
+}
+
+// Counted as generation: the CSV text is written while the days are produced.
+size_t streamCsvRows(CsvWriter &csv, ScheduleGenerator &gen, const string &student) {
+    PerfScope perf(PerfProbe::Generate);
+    size_t rows = 0;
+    gen.prepare();
+    const ScheduleNames &names = *gen.nameTables();
+    while (gen.nextDay())
+        rows += writeCsvDay(csv, gen.currentDayIndex(), gen.currentDay(), names, student);
+    perf.addItems(rows);
+    return rows;
+}
+
+size_t streamJsonSchedule(string &out, ScheduleGenerator &gen) {
+    PerfScope perf(PerfProbe::Generate);
+    size_t slots = 0;
+    gen.prepare();
+    const ScheduleNames &names = *gen.nameTables();
+    char num[32];
+    auto appendNumber = [&](long long v) { out.append(num, (size_t)(to_chars(num, num + sizeof num, v).ptr - num)); };
+
+    out += "{\"days\":";
+    appendNumber(gen.getDays());
+    out += ",\"slots\":[";
+    while (gen.nextDay()) {
+        int day = gen.currentDayIndex() + 1;
+        for (const ScheduleSlot &t : gen.currentDay()) {
+            if (slots++ > 0) out += ',';
+            out += "{\"day\":";
+            appendNumber(day);
+            out += ",\"subject\":";
+            appendJsonString(out, names.subjects[t.subject]);
+            out += ",\"topic\":";
+            appendJsonString(out, names.topics[t.topic]);
+            out += ",\"minutes\":";
+            appendNumber(t.minutes);
+            out += t.kind == SlotKind::Review ? ",\"review\":true}" : ",\"review\":false}";
+        }
+    }
+    out += "],\"shortfalls\":[";
+    bool first = true;
+    for (const DeadlineShortfall &s : gen.shortfalls()) {
+        if (!first) out += ',';
+        first = false;
+        out += "{\"subject\":";
+        appendJsonString(out, names.subjects[s.subject]);
+        out += ",\"wanted_minutes\":";
+        appendNumber(s.wantedMinutes);
+        out += ",\"planned_minutes\":";
+        appendNumber(s.plannedMinutes);
+        out += '}';
+    }
+    out += "]}";
+    perf.addItems(slots);
+    return slots;
+}
+
+bool writeCsv(ostream &out, const Schedule &schedule, const vector<uint16_t> *starts) {
+    // Reused across exports so the large buffer is only allocated once per thread.
+    static thread_local string buffer;
+    CsvWriter csv(buffer, &out);
+    if (starts && starts->size() != schedule.slotCount()) starts = nullptr;
+    writeCsvHeader(csv, false, starts != nullptr);
+    writeCsvRows(csv, schedule, string(), starts);
+    return csv.flush();
+}
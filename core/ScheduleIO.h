@@ -0,0 +1,103 @@
+// ScheduleIO.h
+//  Plain-text plan input and CSV schedule output for the headless tools
+
+#pragma once
+
+#include "CsvWriter.h"
+#include "ScheduleConfig.h"
+#include "ScheduleGenerator.h"
+#include "SchedulePolicies.h"
+#include "Schedule.h"
+#include "Subject.h"
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Everything needed for one generateSchedule() run.
+struct PlanInput {
+    int days = DEFAULT_DAYS;
+    int minutesPerDay = DEFAULT_MINUTES_PER_DAY;
+    int maxChunkMinutes = DEFAULT_MAX_CHUNK_MINUTES;
+    int minSlotMinutes = DEFAULT_MIN_SLOT_MINUTES;
+    std::vector<DayAvailability> availability; // days whose minutes differ from minutesPerDay
+    int reviewMinutes = 0;                       // spaced-repetition reviews, 0 when off
+    int reviewSharePercent = DEFAULT_REVIEW_SHARE_PERCENT;
+    SchedulePolicies policies;                   // weighting and topic rotation
+    std::vector<Subject> subjects;
+};
+
+// Sets gen's parameters and subjects from plan.
+void loadPlan(ScheduleGenerator &gen, const PlanInput &plan);
+
+// Reads a plan in the line format below. Times are given in hours and
+// stored rounded to whole minutes. Blank lines and lines starting
+// with '#' are ignored; every other line after a subject header is one topic.
+//
+//   days 14
+//   hours 4
+//   max-chunk 2      (optional, longest slot in hours)
+//   min-slot 0.25    (optional, shortest slot in hours)
+//   available 6 0    (optional, study hours on day 6 instead of 'hours')
+//   reviews 0.25 25  (optional, spaced-repetition reviews of 0.25 hours,
+//                     kept to 25% of each day; the percentage is optional)
+//   weighting product  (optional: product, log-difficulty or importance-squared)
+//   rotation cyclic    (optional: cyclic or least-recent topic order)
+//   subject <difficulty> <importance> <name>
+//   exam 10          (optional, 1-based day of this subject's exam)
+//   <topic>
+//
+// Returns false and fills error (with the line number) on malformed input.
+bool readPlan(std::istream &in, PlanInput &plan, std::string &error);
+
+// Reads a plan from a JSON object with the same settings as the line
+// format, e.g. for the service (hours as numbers, all keys optional
+// except subjects):
+//
+//   {"days": 14, "hours": 4, "max_chunk": 2, "min_slot": 0.25,
+//    "available": [{"day": 6, "hours": 0}], "reviews": 0.25, "review_share": 25,
+//    "weighting": "product", "rotation": "cyclic",
+//    "subjects": [{"name": "Math", "difficulty": 8, "importance": 9,
+//                  "exam": 10, "topics": ["Algebra", "Calculus"]}]}
+//
+// Returns false and fills error (naming the offending key) on malformed input.
+bool readPlanJson(std::string_view text, PlanInput &plan, std::string &error);
+
+// One student's plan inside a batch file.
+struct BatchJob {
+    std::string id;
+    PlanInput plan;
+};
+
+// Reads a batch: the plan format above, split into students by
+// "student <id>" lines. Settings before the first student are defaults
+// for all students; after a student line they apply to that student only.
+bool readBatch(std::istream &in, std::vector<BatchJob> &jobs, std::string &error);
+
+// Converts minutes into "Xh Ym" / "N min" display text.
+std::string formatTime(int minutes);
+
+// formatTime() into buf (at least 32 bytes, not NUL-terminated); returns the length.
+size_t formatTimeTo(char *buf, int minutes);
+
+// Writes the schedule as "Day,Subject,Topic,Time" CSV. With the clock
+// times from ClockPlacer::place() it is "Day,Start,End,Subject,Topic,Time",
+// Start and End left empty for slots that were not placed.
+bool writeCsv(std::ostream &out, const Schedule &schedule, const std::vector<uint16_t> *starts = nullptr);
+
+// CSV building blocks. With a non-empty student id every row starts with a
+// Student column, as in batch output.
+void writeCsvHeader(CsvWriter &csv, bool withStudent, bool withTimes = false);
+size_t writeCsvRows(CsvWriter &csv, const Schedule &schedule, const std::string &student = std::string(),
+                    const std::vector<uint16_t> *starts = nullptr);
+
+// Generates gen's plan day by day and writes each day as soon as it is
+// produced, so only one day of slots is ever held. Returns the rows written.
+size_t streamCsvRows(CsvWriter &csv, ScheduleGenerator &gen, const std::string &student = std::string());
+
+// Generates gen's plan day by day into out as
+//   {"days":14,"slots":[{"day":1,"subject":...,"topic":...,"minutes":60,"review":false},...],
+//    "shortfalls":[{"subject":...,"wanted_minutes":...,"planned_minutes":...}]}
+// Returns the slots written.
+size_t streamJsonSchedule(std::string &out, ScheduleGenerator &gen);
@@ -0,0 +1,211 @@
+// ScheduleIndex.cpp
+
+#include "ScheduleIndex.h"
+#include "PerfStats.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+// Position of the lowest set bit of a non-zero word.
+inline unsigned lowestBit(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(bits);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (unsigned)index;
+#else
+    unsigned index = 0;
+    for (; !(bits & 1); bits >>= 1) ++index;
+    return index;
+#endif
+}
+
+char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+uint32_t gramBucket(const char *p, uint32_t buckets) {
+    uint32_t g = (uint32_t)(unsigned char)p[0] | (uint32_t)(unsigned char)p[1] << 8 | (uint32_t)(unsigned char)p[2] << 16;
+    return (g * 2654435761u) >> 16 & (buckets - 1);
+}
+
+// Turns per-list counts in start[1 ..] into offsets and returns the total.
+uint32_t prefixSum(vector<uint32_t> &start) {
+    start[0] = 0;
+    for (size_t i = 1; i < start.size(); ++i) start[i] += start[i - 1];
+    return start.back();
+}
+
+bool coversNames(const shared_ptr<const ScheduleNameIndex> &index, const shared_ptr<const ScheduleNames> &names) {
+    if (!index) return false;
+    const shared_ptr<const ScheduleNames> &indexed = index->nameTables();
+    return indexed == names || sameNames(*indexed, *names);
+}
+}
+
+ScheduleNameIndex::ScheduleNameIndex(shared_ptr<const ScheduleNames> n) : names(move(n)) {
+    size_t count = names->subjects.size() + names->topics.size();
+    nameStart.reserve(count + 1);
+    nameStart.push_back(0);
+    auto addName = [&](const string &name) {
+        for (char c : name) folded.push_back(foldCase(c));
+        nameStart.push_back((uint32_t)folded.size());
+    };
+    for (const string &name : names->subjects) addName(name);
+    for (const string &name : names->topics) addName(name);
+
+    // Two passes over every trigram of every name; a name is listed once per
+    // bucket however often its trigrams land there.
+    gramStart.assign(GRAM_BUCKETS + 1, 0);
+    vector<uint32_t> lastSeen(GRAM_BUCKETS, UINT32_MAX);
+    for (uint32_t id = 0; id < (uint32_t)count; ++id) {
+        for (uint32_t p = nameStart[id]; p + 3 <= nameStart[id + 1]; ++p) {
+            uint32_t b = gramBucket(&folded[p], GRAM_BUCKETS);
+            if (lastSeen[b] == id) continue;
+            lastSeen[b] = id;
+            gramStart[b + 1]++;
+        }
+    }
+    gramList.resize(prefixSum(gramStart));
+    vector<uint32_t> &cursor = lastSeen;
+    cursor.assign(gramStart.begin(), gramStart.end() - 1);
+    for (uint32_t id = 0; id < (uint32_t)count; ++id) {
+        for (uint32_t p = nameStart[id]; p + 3 <= nameStart[id + 1]; ++p) {
+            uint32_t b = gramBucket(&folded[p], GRAM_BUCKETS);
+            if (cursor[b] > gramStart[b] && gramList[cursor[b] - 1] == id) continue;
+            gramList[cursor[b]++] = id;
+        }
+    }
+}
+
+void ScheduleNameIndex::match(string_view query, vector<uint32_t> &subjectsOut, vector<uint32_t> &topicsOut) const {
+    subjectsOut.clear();
+    topicsOut.clear();
+    if (query.empty()) return;
+
+    string q(query);
+    for (char &c : q) c = foldCase(c);
+    uint32_t subjects = (uint32_t)names->subjects.size();
+    auto take = [&](uint32_t id) {
+        if (foldedName(id).find(q) == string_view::npos) return;
+        if (id < subjects) subjectsOut.push_back(id);
+        else topicsOut.push_back(id - subjects);
+    };
+
+    if (q.size() < 3) {
+        for (uint32_t id = 0; id + 1 < (uint32_t)nameStart.size(); ++id) take(id);
+        return;
+    }
+    // Every match contains every trigram of the query; the rarest one's
+    // bucket is the shortest candidate list.
+    uint32_t best = gramBucket(q.data(), GRAM_BUCKETS);
+    for (size_t p = 1; p + 3 <= q.size(); ++p) {
+        uint32_t b = gramBucket(q.data() + p, GRAM_BUCKETS);
+        if (gramStart[b + 1] - gramStart[b] < gramStart[best + 1] - gramStart[best]) best = b;
+    }
+    for (uint32_t p = gramStart[best]; p < gramStart[best + 1]; ++p) take(gramList[p]);
+}
+
+void ScheduleIndex::clear() {
+    slotDays.clear();
+    subjectSlotStart.clear();
+    subjectSlotList.clear();
+    subjectDayStart.clear();
+    subjectDayList.clear();
+    topicSlotStart.clear();
+    topicSlotList.clear();
+}
+
+void ScheduleIndex::build(const Schedule &schedule, shared_ptr<const ScheduleNameIndex> names) {
+    PerfScope perf(PerfProbe::Index);
+    perf.addItems(schedule.slotCount());
+    clear();
+    if (schedule.empty()) return;
+
+    const shared_ptr<const ScheduleNames> &tables = schedule.nameTables();
+    if (coversNames(names, tables)) nameIdx = move(names);
+    else if (!coversNames(nameIdx, tables)) nameIdx = make_shared<ScheduleNameIndex>(tables);
+
+    size_t subjects = tables->subjects.size();
+    size_t topics = tables->topics.size();
+    const vector<ScheduleSlot> &slots = schedule.allSlots();
+    int days = schedule.dayCount();
+
+    // Counting pass: slots per subject and topic, distinct days per subject
+    slotDays.resize(slots.size());
+    subjectSlotStart.assign(subjects + 1, 0);
+    subjectDayStart.assign(subjects + 1, 0);
+    topicSlotStart.assign(topics + 1, 0);
+    cursor.assign(subjects, UINT32_MAX); // last day each subject was seen on
+    for (int d = 0; d < days; ++d) {
+        for (uint32_t i = schedule.dayOffset(d); i < schedule.dayOffset(d + 1); ++i) {
+            const ScheduleSlot &s = slots[i];
+            slotDays[i] = (uint32_t)d;
+            if (s.topic < topics) topicSlotStart[s.topic + 1]++;
+            if (s.subject >= subjects) continue;
+            subjectSlotStart[s.subject + 1]++;
+            if (cursor[s.subject] != (uint32_t)d) {
+                cursor[s.subject] = (uint32_t)d;
+                subjectDayStart[s.subject + 1]++;
+            }
+        }
+    }
+    subjectSlotList.resize(prefixSum(subjectSlotStart));
+    subjectDayList.resize(prefixSum(subjectDayStart));
+    topicSlotList.resize(prefixSum(topicSlotStart));
+
+    // Fill pass in plan order, so every list comes out ascending
+    cursor.assign(subjectSlotStart.begin(), subjectSlotStart.end() - 1);
+    for (uint32_t i = 0; i < (uint32_t)slots.size(); ++i)
+        if (slots[i].subject < subjects) subjectSlotList[cursor[slots[i].subject]++] = i;
+    for (size_t s = 0; s < subjects; ++s) {
+        uint32_t out = subjectDayStart[s];
+        for (uint32_t p = subjectSlotStart[s]; p < subjectSlotStart[s + 1]; ++p) {
+            uint32_t d = slotDays[subjectSlotList[p]];
+            if (out == subjectDayStart[s] || subjectDayList[out - 1] != d) subjectDayList[out++] = d;
+        }
+    }
+    cursor.assign(topicSlotStart.begin(), topicSlotStart.end() - 1);
+    for (uint32_t i = 0; i < (uint32_t)slots.size(); ++i)
+        if (slots[i].topic < topics) topicSlotList[cursor[slots[i].topic]++] = i;
+}
+
+size_t ScheduleIndex::search(string_view query, vector<uint32_t> &out, size_t limit) const {
+    PerfScope perf(PerfProbe::Search);
+    out.clear();
+    if (empty()) return 0;
+    vector<uint32_t> subjects, topics;
+    nameIdx->match(query, subjects, topics);
+    if (subjects.empty() && topics.empty()) return 0;
+    // One list is already in plan order; several are merged through a
+    // bitmap over the slots, which also drops slots matched twice.
+    if (subjects.size() + topics.size() == 1) {
+        Postings hits = subjects.empty() ? topicSlots(topics[0]) : subjectSlots(subjects[0]);
+        out.assign(hits.begin(), hits.begin() + min(hits.size(), limit));
+        perf.addItems(hits.size());
+        return hits.size();
+    }
+    vector<uint64_t> marks((slotDays.size() + 63) / 64, 0);
+    auto mark = [&](Postings hits) {
+        for (uint32_t i : hits) marks[i >> 6] |= uint64_t(1) << (i & 63);
+    };
+    for (uint32_t s : subjects) mark(subjectSlots(s));
+    for (uint32_t t : topics) mark(topicSlots(t));
+
+    size_t total = 0;
+    for (size_t w = 0; w < marks.size(); ++w) {
+        for (uint64_t bits = marks[w]; bits; bits &= bits - 1) {
+            if (out.size() < limit) out.push_back((uint32_t)(w * 64 + lowestBit(bits)));
+            total++;
+        }
+    }
+    perf.addItems(total);
+    return total;
+}
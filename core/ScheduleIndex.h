@@ -0,0 +1,102 @@
+// ScheduleIndex.h
+//  Inverted index over a generated schedule: the slots and days of every
+//  subject, the slots of every topic, and a trigram index over the subject
+//  and topic names for case-insensitive substring search. Each kind of
+//  posting list is stored back to back with one offsets array, so a build is
+//  a few counting passes and every query reads contiguous memory.
+
+#pragma once
+
+#include "Schedule.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ascending ids of one posting list, usable in range-for.
+class Postings {
+public:
+    Postings() = default;
+    Postings(const uint32_t *b, const uint32_t *e) : first(b), last(e) {}
+    const uint32_t *begin() const { return first; }
+    const uint32_t *end() const { return last; }
+    size_t size() const { return (size_t)(last - first); }
+    bool empty() const { return first == last; }
+    uint32_t operator[](size_t i) const { return first[i]; }
+private:
+    const uint32_t *first = nullptr;
+    const uint32_t *last = nullptr;
+};
+
+// Trigram index over one set of name tables. Immutable once built, so every
+// schedule generated from the same subject list can share it.
+class ScheduleNameIndex {
+public:
+    explicit ScheduleNameIndex(std::shared_ptr<const ScheduleNames> n);
+
+    const std::shared_ptr<const ScheduleNames> &nameTables() const { return names; }
+
+    // Subjects and topics whose name contains query, ignoring ASCII case.
+    // Queries of three or more bytes only check the names that share the
+    // query's rarest trigram; shorter ones scan every name.
+    void match(std::string_view query, std::vector<uint32_t> &subjectsOut, std::vector<uint32_t> &topicsOut) const;
+
+private:
+    static constexpr uint32_t GRAM_BUCKETS = 1u << 16; // trigrams are hashed; matching drops collisions
+
+    std::shared_ptr<const ScheduleNames> names;
+    std::string folded;              // every name lower-cased, back to back; subjects, then topics
+    std::vector<uint32_t> nameStart; // names + 1 offsets into folded
+    std::vector<uint32_t> gramStart; // GRAM_BUCKETS + 1 offsets into gramList
+    std::vector<uint32_t> gramList;  // name ids per bucket, ascending
+
+    std::string_view foldedName(uint32_t id) const {
+        return std::string_view(folded).substr(nameStart[id], nameStart[id + 1] - nameStart[id]);
+    }
+};
+
+class ScheduleIndex {
+public:
+    // Indexes schedule in O(slots + topics), reusing the buffers. The name
+    // index is kept, or taken from names, when it covers equal name tables;
+    // otherwise it is rebuilt in O(name characters).
+    void build(const Schedule &schedule, std::shared_ptr<const ScheduleNameIndex> names = nullptr);
+    void clear();
+
+    bool empty() const { return slotDays.empty(); }
+    size_t subjectCount() const { return subjectSlotStart.empty() ? 0 : subjectSlotStart.size() - 1; }
+    size_t topicCount() const { return topicSlotStart.empty() ? 0 : topicSlotStart.size() - 1; }
+    const std::shared_ptr<const ScheduleNameIndex> &nameIndex() const { return nameIdx; }
+
+    // Slot indices (into Schedule::allSlots()) of subject s, in plan order.
+    Postings subjectSlots(uint32_t s) const { return postings(subjectSlotStart, subjectSlotList, s); }
+    // Days on which subject s has at least one slot.
+    Postings subjectDays(uint32_t s) const { return postings(subjectDayStart, subjectDayList, s); }
+    // Slot indices of topic t (flat topic id), studies and reviews alike.
+    Postings topicSlots(uint32_t t) const { return postings(topicSlotStart, topicSlotList, t); }
+
+    // O(1), unlike Schedule::dayOfSlot().
+    int dayOfSlot(size_t i) const { return (int)slotDays[i]; }
+
+    // Slots whose subject or topic name contains query (ignoring ASCII
+    // case), in plan order. Writes at most limit of them to out and returns
+    // how many there are in total.
+    size_t search(std::string_view query, std::vector<uint32_t> &out, size_t limit = SIZE_MAX) const;
+
+private:
+    std::vector<uint32_t> slotDays; // per slot
+    std::vector<uint32_t> subjectSlotStart, subjectSlotList;
+    std::vector<uint32_t> subjectDayStart, subjectDayList;
+    std::vector<uint32_t> topicSlotStart, topicSlotList;
+    std::vector<uint32_t> cursor; // fill positions and last seen days while building
+    std::shared_ptr<const ScheduleNameIndex> nameIdx;
+
+    static Postings postings(const std::vector<uint32_t> &start, const std::vector<uint32_t> &list, uint32_t i) {
+        if (i + 1 >= start.size()) return Postings();
+        const uint32_t *base = list.data();
+        return Postings(base + start[i], base + start[i + 1]);
+    }
+};
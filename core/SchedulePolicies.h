@@ -0,0 +1,233 @@
+// SchedulePolicies.h
+//  How subjects are weighted and in which order a subject's topics are
+//  studied. Each policy is a small type the generator is instantiated on,
+//  so the per-slot topic pick is inlined rather than called through a
+//  virtual interface; withWeighting() and withRotation() pick one of the
+//  instantiations from a run-time setting.
+
+#pragma once
+
+#include "Schedule.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class WeightingPolicy : uint8_t {
+    Product,           // difficulty × importance × topics
+    LogDifficulty,     // log2(1 + difficulty) × importance × topics
+    ImportanceSquared, // difficulty × importance² × topics
+};
+
+enum class RotationPolicy : uint8_t {
+    Cyclic,      // topics in list order, over and over
+    LeastRecent, // the topic studied or reviewed longest ago
+};
+
+struct SchedulePolicies {
+    WeightingPolicy weighting = WeightingPolicy::Product;
+    RotationPolicy rotation = RotationPolicy::Cyclic;
+
+    bool operator==(const SchedulePolicies &o) const { return weighting == o.weighting && rotation == o.rotation; }
+    bool operator!=(const SchedulePolicies &o) const { return !(*this == o); }
+};
+
+// Names used in plan files and on the command line.
+inline const char *weightingName(WeightingPolicy p) {
+    switch (p) {
+    case WeightingPolicy::LogDifficulty: return "log-difficulty";
+    case WeightingPolicy::ImportanceSquared: return "importance-squared";
+    default: return "product";
+    }
+}
+
+inline const char *rotationName(RotationPolicy p) {
+    return p == RotationPolicy::LeastRecent ? "least-recent" : "cyclic";
+}
+
+inline bool parseWeighting(std::string_view name, WeightingPolicy &p) {
+    if (name == "product") p = WeightingPolicy::Product;
+    else if (name == "log-difficulty") p = WeightingPolicy::LogDifficulty;
+    else if (name == "importance-squared") p = WeightingPolicy::ImportanceSquared;
+    else return false;
+    return true;
+}
+
+inline bool parseRotation(std::string_view name, RotationPolicy &p) {
+    if (name == "cyclic") p = RotationPolicy::Cyclic;
+    else if (name == "least-recent") p = RotationPolicy::LeastRecent;
+    else return false;
+    return true;
+}
+
+// log2(x) in 1/256ths, rounded down, by repeated squaring of the mantissa.
+// Integer only, so weights derived from it are the same on every machine.
+inline uint64_t log2Fixed8(uint64_t x) {
+    if (x == 0) return 0;
+    unsigned whole = 0;
+    while (x >> (whole + 1)) ++whole;
+    uint64_t result = (uint64_t)whole << 8;
+    // Mantissa x / 2^whole in [1, 2), as a 31-bit fraction.
+    uint64_t m = whole >= 31 ? x >> (whole - 31) : x << (31 - whole);
+    for (int bit = 7; bit >= 0; --bit) {
+        m = (m * m) >> 31;
+        if (m >> 32) {
+            m >>= 1;
+            result |= 1ull << bit;
+        }
+    }
+    return result;
+}
+
+// Weighting policies: the weight of one subject, a small integer so that
+// every share computed from the weights is an exact integer quotient and
+// no float rounding reaches the result.
+struct ProductWeighting {
+    static uint64_t weight(int difficulty, int importance, int topics) {
+        return (uint64_t)std::max(difficulty, 0) * (uint64_t)std::max(importance, 0) * (uint64_t)std::max(1, topics);
+    }
+};
+
+struct LogDifficultyWeighting {
+    static uint64_t weight(int difficulty, int importance, int topics) {
+        if (difficulty <= 0) return 0;
+        return log2Fixed8(1 + (uint64_t)difficulty) * (uint64_t)std::max(importance, 0) * (uint64_t)std::max(1, topics);
+    }
+};
+
+struct ImportanceSquaredWeighting {
+    static uint64_t weight(int difficulty, int importance, int topics) {
+        uint64_t imp = (uint64_t)std::max(importance, 0);
+        return (uint64_t)std::max(difficulty, 0) * imp * imp * (uint64_t)std::max(1, topics);
+    }
+};
+
+// Calls f with a value of the weighting policy type p selects.
+template <class F>
+decltype(auto) withWeighting(WeightingPolicy p, F &&f) {
+    switch (p) {
+    case WeightingPolicy::LogDifficulty: return f(LogDifficultyWeighting());
+    case WeightingPolicy::ImportanceSquared: return f(ImportanceSquaredWeighting());
+    default: return f(ProductWeighting());
+    }
+}
+
+// Rotation policies: next() picks the topic a subject studies next and
+// counts it as studied; studied() records a topic studied out of turn (a
+// redo or a review). Both are called once per slot and do not allocate
+// once reset() has sized the state for a plan.
+
+// Each subject steps through its topics in list order from its start
+// position. Out-of-turn study does not move it.
+class CyclicRotation {
+public:
+    // start: per subject, the position to continue from; empty for all 0.
+    void reset(const ScheduleNames &names, const std::vector<size_t> &start) {
+        topicBase = names.topicBase.data();
+        size_t n = names.subjects.size();
+        position.assign(n, 0);
+        if (start.size() == n) std::copy(start.begin(), start.end(), position.begin());
+    }
+
+    uint32_t next(uint32_t subject) {
+        uint32_t base = topicBase[subject];
+        uint32_t count = topicBase[subject + 1] - base;
+        return base + (uint32_t)(position[subject]++ % count);
+    }
+
+    void studied(uint32_t, uint32_t) {}
+
+private:
+    const uint32_t *topicBase = nullptr;
+    std::vector<size_t> position;
+};
+
+// Least recently studied first. Topics not studied yet in this run come
+// first, in the cyclic order; the studied ones follow in a list per
+// subject from least to most recently studied, and every study or review
+// moves a topic to its tail. Until something is studied out of turn this
+// is the cyclic order. Only the topics studied are touched, so a run costs
+// nothing per topic it never reaches.
+class LeastRecentRotation {
+public:
+    void reset(const ScheduleNames &names, const std::vector<size_t> &start) {
+        topicBase = names.topicBase.data();
+        size_t n = names.subjects.size();
+        before.resize(names.topics.size());
+        after.resize(names.topics.size());
+        listed.resize(names.topics.size(), 0);
+        // A new run number unlists every topic without clearing them.
+        if (++run == 0) {
+            std::fill(listed.begin(), listed.end(), 0);
+            run = 1;
+        }
+        first.assign(n, 0);
+        taken.assign(n, 0);
+        head.assign(n, NONE);
+        tail.assign(n, NONE);
+        for (size_t i = 0; i < n && start.size() == n; ++i) {
+            uint32_t count = topicBase[i + 1] - topicBase[i];
+            first[i] = count ? (uint32_t)(start[i] % count) : 0;
+        }
+    }
+
+    uint32_t next(uint32_t subject) {
+        uint32_t base = topicBase[subject];
+        uint32_t count = topicBase[subject + 1] - base;
+        // Unstudied topics in cyclic order, skipping those studied out of turn.
+        while (taken[subject] < count) {
+            uint32_t t = base + (first[subject] + taken[subject]++) % count;
+            if (listed[t] != run) {
+                append(subject, t);
+                return t;
+            }
+        }
+        uint32_t t = head[subject];
+        studied(subject, t);
+        return t;
+    }
+
+    void studied(uint32_t subject, uint32_t topic) {
+        if (listed[topic] != run) {
+            append(subject, topic);
+            return;
+        }
+        if (tail[subject] == topic) return;
+        if (before[topic] == NONE) head[subject] = after[topic];
+        else after[before[topic]] = after[topic];
+        before[after[topic]] = before[topic];
+        after[topic] = NONE;
+        link(subject, topic);
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    const uint32_t *topicBase = nullptr;
+    uint32_t run = 0;
+    std::vector<uint32_t> listed;        // per flat topic id: run it was last listed in
+    std::vector<uint32_t> before, after; // per flat topic id: neighbours in its subject's list
+    std::vector<uint32_t> first, taken;  // per subject: start position, unstudied topics handed out
+    std::vector<uint32_t> head, tail;    // per subject
+
+    void append(uint32_t subject, uint32_t topic) {
+        listed[topic] = run;
+        after[topic] = NONE;
+        link(subject, topic);
+    }
+
+    // Puts topic, already unlinked, at the tail of subject's list.
+    void link(uint32_t subject, uint32_t topic) {
+        before[topic] = tail[subject];
+        if (tail[subject] == NONE) head[subject] = topic;
+        else after[tail[subject]] = topic;
+        tail[subject] = topic;
+    }
+};
+
+// Calls f with a reference to whichever of the rotations p selects.
+template <class F>
+decltype(auto) withRotation(RotationPolicy p, CyclicRotation &cyclic, LeastRecentRotation &leastRecent, F &&f) {
+    if (p == RotationPolicy::LeastRecent) return f(leastRecent);
+    return f(cyclic);
+}
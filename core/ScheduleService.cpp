@@ -0,0 +1,649 @@
+// ScheduleService.cpp
+
+#include "ScheduleService.h"
+#include "Json.h"
+#include "ScheduleIO.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define ADEXA_HAVE_SOCKETS 1
+#endif
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace {
+constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+// Responses larger than this are not kept as a connection's write buffer.
+constexpr size_t KEEP_BUFFER_BYTES = 1 << 20;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+const char *reasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 503: return "Service Unavailable";
+    }
+    return "Error";
+}
+
+string errorJson(const string &msg) {
+    string out = "{\"error\":";
+    appendJsonString(out, msg);
+    out += '}';
+    return out;
+}
+
+bool equalsNoCase(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = (char)(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = (char)(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+string_view trimmedView(string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+#ifdef ADEXA_HAVE_SOCKETS
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#endif
+}
+
+// One client socket with its unparsed input and unsent output. Requests
+// on a connection are answered in order: while one is with the batcher,
+// the next is not read.
+struct ScheduleService::Connection {
+    int fd = -1;
+    uint64_t id = 0;
+    string in;
+    string out;
+    size_t outPos = 0;
+    bool busy = false;             // a schedule request is with the batcher
+    bool closeWhenFlushed = false; // 'Connection: close' or a fatal request error
+    bool peerClosed = false;
+    Clock::time_point lastActive;
+
+    bool flushed() const { return outPos >= out.size(); }
+};
+
+void writeServiceStatsJson(string &out, const ServiceStats &s) {
+    out += "{\"uptime_s\":";
+    appendJsonDecimal(out, s.uptimeSeconds);
+    out += ",\"requests\":";
+    appendJsonNumber(out, s.requests);
+    out += ",\"completed\":";
+    appendJsonNumber(out, s.completed);
+    out += ",\"failed\":";
+    appendJsonNumber(out, s.failed);
+    out += ",\"rejected\":";
+    appendJsonNumber(out, s.rejected);
+    out += ",\"in_flight\":";
+    appendJsonNumber(out, s.inFlight);
+    out += ",\"connections\":";
+    appendJsonNumber(out, s.connections);
+    out += ",\"batches\":";
+    appendJsonNumber(out, s.batches);
+    out += ",\"mean_batch\":";
+    appendJsonDecimal(out, s.meanBatch);
+    out += ",\"latency_us\":{\"p50\":";
+    appendJsonNumber(out, s.p50Micros);
+    out += ",\"p90\":";
+    appendJsonNumber(out, s.p90Micros);
+    out += ",\"p99\":";
+    appendJsonNumber(out, s.p99Micros);
+    out += ",\"max\":";
+    appendJsonNumber(out, s.maxMicros);
+    out += ",\"mean\":";
+    appendJsonDecimal(out, s.meanMicros);
+    out += "},\"throughput_per_s\":";
+    appendJsonDecimal(out, s.recentPerSecond);
+    out += "}";
+}
+
+ScheduleService::ScheduleService(const ServiceOptions &o) : options(o) {}
+
+ScheduleService::~ScheduleService() {
+    stop();
+}
+
+ServiceStats ScheduleService::stats() const {
+    ServiceStats s;
+    s.requests = requests.load();
+    s.completed = completed.load();
+    s.failed = failed.load();
+    s.rejected = rejected.load();
+    s.inFlight = inFlight.load();
+    s.batches = batches.load();
+    s.connections = openConnections.load();
+    s.meanBatch = s.batches ? (double)batchedJobs.load() / (double)s.batches : 0.0;
+    s.p50Micros = latency.percentile(50.0);
+    s.p90Micros = latency.percentile(90.0);
+    s.p99Micros = latency.percentile(99.0);
+    s.maxMicros = latency.max();
+    s.meanMicros = latency.mean();
+    if (!running) return s;
+
+    s.uptimeSeconds = chrono::duration<double>(Clock::now() - started).count();
+    // The current second counts with the part of it that has passed.
+    int64_t now = (int64_t)s.uptimeSeconds;
+    double span = min(s.uptimeSeconds, (RATE_SECONDS - 1) + (s.uptimeSeconds - (double)now));
+    uint64_t answeredRecently = 0;
+    {
+        lock_guard<mutex> lock(rateMutex);
+        for (int64_t sec = max<int64_t>(0, now - (RATE_SECONDS - 1)); sec <= now; ++sec)
+            if (rateSecond[sec % RATE_SECONDS] == sec) answeredRecently += rateCount[sec % RATE_SECONDS];
+    }
+    s.recentPerSecond = span > 0.0 ? (double)answeredRecently / span : 0.0;
+    return s;
+}
+
+void ScheduleService::countAnswered(Clock::time_point now) {
+    int64_t sec = (int64_t)chrono::duration_cast<chrono::seconds>(now - started).count();
+    int slot = (int)(sec % RATE_SECONDS);
+    lock_guard<mutex> lock(rateMutex);
+    if (rateSecond[slot] != sec) {
+        rateSecond[slot] = sec;
+        rateCount[slot] = 0;
+    }
+    ++rateCount[slot];
+}
+
+bool ScheduleService::start(string &error) {
+#ifdef ADEXA_HAVE_SOCKETS
+    if (running) return true;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)options.port);
+    if (options.port < 0 || options.port > 65535 || inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1) {
+        error = "invalid address " + options.host + ":" + to_string(options.port);
+        return false;
+    }
+    string where = options.host + ":" + to_string(options.port);
+
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        error = string("cannot create a socket: ") + strerror(errno);
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    socklen_t len = sizeof addr;
+    int fds[2] = {-1, -1};
+    if (bind(listenFd, (sockaddr *)&addr, sizeof addr) != 0 || listen(listenFd, SOMAXCONN) != 0 ||
+        getsockname(listenFd, (sockaddr *)&addr, &len) != 0 || !setNonBlocking(listenFd) || pipe(fds) != 0) {
+        error = "cannot listen on " + where + ": " + strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    boundPort = ntohs(addr.sin_port);
+    wakeRead = fds[0];
+    wakeWrite = fds[1];
+    setNonBlocking(wakeRead);
+    setNonBlocking(wakeWrite);
+
+    pool = make_unique<WorkStealingPool>(options.threads);
+    generators.clear();
+    while (generators.size() < pool->size())
+        generators.emplace_back(DEFAULT_DAYS, DEFAULT_MINUTES_PER_DAY);
+
+    started = Clock::now();
+    stopping = false;
+    ioFinished = false;
+    running = true;
+    ioThread = thread(&ScheduleService::ioLoop, this);
+    batchThread = thread(&ScheduleService::batchLoop, this);
+    return true;
+#else
+    error = "the service needs POSIX sockets";
+    return false;
+#endif
+}
+
+void ScheduleService::stop() {
+#ifdef ADEXA_HAVE_SOCKETS
+    if (!running) return;
+    stopping = true;
+    char byte = 0;
+    (void)!::write(wakeWrite, &byte, 1);
+    ioThread.join();
+    {
+        lock_guard<mutex> lock(queueMutex);
+        ioFinished = true;
+    }
+    queueChanged.notify_all();
+    batchThread.join();
+    pool.reset();
+    pending.clear();
+    answered.clear();
+    ::close(wakeRead);
+    ::close(wakeWrite);
+    wakeRead = wakeWrite = -1;
+    running = false;
+#endif
+}
+
+// --- Batching ---------------------------------------------------------------
+
+void ScheduleService::batchLoop() {
+    vector<unique_ptr<Job>> batch;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueChanged.wait(lock, [&] { return !pending.empty() || ioFinished; });
+            if (pending.empty()) return;
+            // Requests that arrive within the window share this batch. While
+            // the pool works on one batch the next one fills up by itself,
+            // so under load batches grow without any extra waiting.
+            if (pending.size() < options.maxBatch && options.batchWindowMicros > 0) {
+                auto deadline = Clock::now() + chrono::microseconds(options.batchWindowMicros);
+                queueChanged.wait_until(lock, deadline, [&] { return pending.size() >= options.maxBatch || ioFinished; });
+            }
+            size_t n = min(pending.size(), max<size_t>(1, options.maxBatch));
+            for (size_t i = 0; i < n; ++i) {
+                batch.push_back(move(pending.front()));
+                pending.pop_front();
+            }
+        }
+
+        runBatch(batch);
+
+        {
+            lock_guard<mutex> lock(queueMutex);
+            for (auto &job : batch) answered.push_back(move(job));
+        }
+        batch.clear();
+#ifdef ADEXA_HAVE_SOCKETS
+        // A full pipe already holds a wakeup, so a failed write is fine.
+        char byte = 0;
+        (void)!::write(wakeWrite, &byte, 1);
+#endif
+    }
+}
+
+void ScheduleService::runBatch(vector<unique_ptr<Job>> &batch) {
+    ++batches;
+    batchedJobs += batch.size();
+
+    // Contiguous runs of jobs, two per worker so stealing can even out
+    // plans of different sizes; each run reuses its worker's generator.
+    size_t runs = min(batch.size(), (size_t)pool->size() * 2);
+    size_t perRun = (batch.size() + runs - 1) / runs;
+    for (size_t first = 0; first < batch.size(); first += perRun) {
+        size_t last = min(batch.size(), first + perRun);
+        pool->submit([this, &batch, first, last](unsigned worker) {
+            for (size_t i = first; i < last; ++i) generate(*batch[i], generators[worker]);
+        });
+    }
+    pool->wait();
+}
+
+void ScheduleService::generate(Job &job, ScheduleGenerator &gen) {
+    PlanInput plan;
+    string error;
+    if (!readPlanJson(job.body, plan, error)) {
+        job.status = 400;
+        job.response = errorJson(error);
+        return;
+    }
+    if (plan.subjects.empty()) {
+        job.status = 400;
+        job.response = errorJson("subjects: no subjects in the plan");
+        return;
+    }
+    string().swap(job.body);
+    loadPlan(gen, plan);
+    streamJsonSchedule(job.response, gen);
+}
+
+// --- I/O --------------------------------------------------------------------
+
+#ifdef ADEXA_HAVE_SOCKETS
+
+void ScheduleService::ioLoop() {
+    vector<pollfd> fds;
+    vector<uint64_t> ids;
+    bool listening = true;
+    Clock::time_point drainDeadline;
+    const auto idleTimeout = chrono::seconds(options.idleTimeoutSeconds);
+
+    for (;;) {
+        if (stopping && listening) {
+            ::close(listenFd);
+            listenFd = -1;
+            listening = false;
+            drainDeadline = Clock::now() + chrono::seconds(10);
+        }
+
+        // Close whatever is finished or has idled too long.
+        Clock::time_point now = Clock::now();
+        for (auto it = connections.begin(); it != connections.end();) {
+            Connection &c = *it->second;
+            bool idle = !c.busy && c.flushed() && (!listening || now - c.lastActive > idleTimeout);
+            if (idle) {
+                ::close(c.fd);
+                it = connections.erase(it);
+                --openConnections;
+            } else {
+                ++it;
+            }
+        }
+        if (!listening && ((connections.empty() && inFlight == 0) || now > drainDeadline)) break;
+
+        fds.clear();
+        ids.clear();
+        fds.push_back(pollfd{wakeRead, POLLIN, 0});
+        bool acceptNow = listening && connections.size() < options.maxConnections;
+        fds.push_back(pollfd{acceptNow ? listenFd : -1, POLLIN, 0});
+        for (auto &entry : connections) {
+            Connection &c = *entry.second;
+            short events = 0;
+            if (!c.busy && !c.peerClosed && listening) events |= POLLIN;
+            if (!c.flushed()) events |= POLLOUT;
+            // A closed peer would report POLLHUP on every call until its answer is ready.
+            fds.push_back(pollfd{events == 0 && c.peerClosed ? -1 : c.fd, events, 0});
+            ids.push_back(entry.first);
+        }
+
+        if (poll(fds.data(), (nfds_t)fds.size(), 1000) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN) {
+            char drain[256];
+            while (::read(wakeRead, drain, sizeof drain) > 0) {
+            }
+        }
+        deliverAnswers();
+        if (fds[1].revents & POLLIN) acceptClients();
+
+        for (size_t k = 0; k < ids.size(); ++k) {
+            short revents = fds[k + 2].revents;
+            if (revents == 0) continue;
+            auto it = connections.find(ids[k]);
+            if (it == connections.end()) continue; // closed while answering
+            Connection &c = *it->second;
+            bool keep = !(revents & (POLLERR | POLLNVAL));
+            if (keep && (revents & (POLLIN | POLLHUP))) keep = readClient(c) && handleRequests(c);
+            if (keep && (revents & POLLOUT)) keep = flushClient(c);
+            if (!keep) {
+                ::close(c.fd);
+                connections.erase(it);
+                --openConnections;
+            }
+        }
+    }
+    closeAll();
+}
+
+void ScheduleService::acceptClients() {
+    while (connections.size() < options.maxConnections) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN, or out of descriptors until a client leaves
+        }
+        setNonBlocking(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+        auto c = make_unique<Connection>();
+        c->fd = fd;
+        c->id = nextConnection++;
+        c->lastActive = Clock::now();
+        connections.emplace(c->id, move(c));
+        ++openConnections;
+    }
+}
+
+bool ScheduleService::readClient(Connection &c) {
+    char buf[16 * 1024];
+    for (;;) {
+        ssize_t n = ::recv(c.fd, buf, sizeof buf, 0);
+        if (n > 0) {
+            c.in.append(buf, (size_t)n);
+            c.lastActive = Clock::now();
+            if (c.in.size() > MAX_HEADER_BYTES + options.maxBodyBytes) return false;
+            continue;
+        }
+        if (n == 0) {
+            c.peerClosed = true;
+            return true; // a complete request may still be buffered
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Parses and answers (or queues) the complete requests in c.in, one at a
+// time; returns false when the connection should be closed.
+bool ScheduleService::handleRequests(Connection &c) {
+    while (!c.busy && !c.closeWhenFlushed) {
+        size_t headerEnd = c.in.find("\r\n\r\n");
+        if (headerEnd == string::npos) {
+            if (c.in.size() > MAX_HEADER_BYTES) {
+                c.closeWhenFlushed = true;
+                respond(c, 431, errorJson("request headers too large"));
+            }
+            break;
+        }
+        string_view head(c.in.data(), headerEnd);
+        size_t lineEnd = min(head.find("\r\n"), head.size());
+        string_view requestLine = head.substr(0, lineEnd);
+        size_t sp1 = requestLine.find(' ');
+        size_t sp2 = sp1 == string_view::npos ? sp1 : requestLine.find(' ', sp1 + 1);
+        if (sp2 == string_view::npos) {
+            c.closeWhenFlushed = true;
+            respond(c, 400, errorJson("malformed request line"));
+            break;
+        }
+        string_view method = requestLine.substr(0, sp1);
+        string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        string_view version = requestLine.substr(sp2 + 1);
+        target = target.substr(0, target.find('?'));
+
+        size_t contentLength = 0;
+        bool chunked = false;
+        bool keepAlive = version == "HTTP/1.1";
+        bool badLength = false;
+        for (size_t pos = lineEnd; pos < head.size();) {
+            size_t next = min(head.find("\r\n", pos + 2), head.size());
+            string_view line = head.substr(pos + 2, next - pos - 2);
+            pos = next;
+            size_t colon = line.find(':');
+            if (colon == string_view::npos) continue;
+            string_view name = trimmedView(line.substr(0, colon));
+            string_view value = trimmedView(line.substr(colon + 1));
+            if (equalsNoCase(name, "Content-Length")) {
+                auto r = from_chars(value.data(), value.data() + value.size(), contentLength);
+                badLength = r.ec != errc() || r.ptr != value.data() + value.size();
+            } else if (equalsNoCase(name, "Transfer-Encoding")) {
+                chunked = true;
+            } else if (equalsNoCase(name, "Connection")) {
+                if (equalsNoCase(value, "close")) keepAlive = false;
+                else if (equalsNoCase(value, "keep-alive")) keepAlive = true;
+            }
+        }
+        if (badLength) {
+            c.closeWhenFlushed = true;
+            respond(c, 400, errorJson("invalid Content-Length"));
+            break;
+        }
+        if (chunked) {
+            c.closeWhenFlushed = true;
+            respond(c, 411, errorJson("send the body with a Content-Length"));
+            break;
+        }
+        if (contentLength > options.maxBodyBytes) {
+            c.closeWhenFlushed = true;
+            respond(c, 413, errorJson("body larger than " + to_string(options.maxBodyBytes) + " bytes"));
+            break;
+        }
+        size_t total = headerEnd + 4 + contentLength;
+        if (c.in.size() < total) break; // the rest of the body is still on its way
+
+        bool isSchedule = target == "/schedule";
+        bool isStats = target == "/stats";
+        bool isHealth = target == "/health";
+        bool isPost = method == "POST";
+        bool isGet = method == "GET";
+        if (!keepAlive) c.closeWhenFlushed = true;
+
+        if (isSchedule && isPost) {
+            auto job = make_unique<Job>();
+            job->body.assign(c.in, headerEnd + 4, contentLength);
+            c.in.erase(0, total);
+            ++requests;
+            if (stopping) {
+                c.closeWhenFlushed = true;
+                respond(c, 503, errorJson("shutting down"));
+            } else if (inFlight >= options.maxQueue) {
+                // Backpressure: turn the request away now rather than
+                // letting latency grow without bound.
+                ++rejected;
+                respond(c, 503, errorJson("too many requests queued; retry shortly"), "Retry-After: 1\r\n");
+            } else {
+                ++inFlight;
+                c.busy = true;
+                job->connection = c.id;
+                job->arrived = Clock::now();
+                {
+                    lock_guard<mutex> lock(queueMutex);
+                    pending.push_back(move(job));
+                }
+                queueChanged.notify_one();
+            }
+            continue;
+        }
+
+        c.in.erase(0, total);
+        if (isStats && isGet) {
+            string body;
+            writeServiceStatsJson(body, stats());
+            respond(c, 200, body);
+        } else if (isHealth && isGet) {
+            respond(c, 200, "{\"status\":\"ok\"}");
+        } else if (isSchedule) {
+            respond(c, 405, errorJson("use POST"), "Allow: POST\r\n");
+        } else if (isStats || isHealth) {
+            respond(c, 405, errorJson("use GET"), "Allow: GET\r\n");
+        } else {
+            respond(c, 404, errorJson("no such endpoint"));
+        }
+    }
+    return flushClient(c);
+}
+
+void ScheduleService::respond(Connection &c, int status, const string &body, const char *extraHeaders) {
+    if (c.flushed()) {
+        c.out.clear();
+        c.outPos = 0;
+    }
+    c.out += "HTTP/1.1 ";
+    appendJsonNumber(c.out, (uint64_t)status);
+    c.out += ' ';
+    c.out += reasonPhrase(status);
+    c.out += "\r\nContent-Type: application/json\r\nContent-Length: ";
+    appendJsonNumber(c.out, body.size());
+    c.out += "\r\n";
+    c.out += extraHeaders;
+    if (c.closeWhenFlushed) c.out += "Connection: close\r\n";
+    c.out += "\r\n";
+    c.out += body;
+}
+
+// Sends what it can of c.out; returns false when the connection is done.
+bool ScheduleService::flushClient(Connection &c) {
+    while (!c.flushed()) {
+        ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, SEND_FLAGS);
+        if (n > 0) {
+            c.outPos += (size_t)n;
+            c.lastActive = Clock::now();
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    if (c.out.capacity() > KEEP_BUFFER_BYTES) string().swap(c.out);
+    c.out.clear();
+    c.outPos = 0;
+    if (c.busy) return true;
+    return !c.closeWhenFlushed && !c.peerClosed;
+}
+
+void ScheduleService::deliverAnswers() {
+    vector<unique_ptr<Job>> done;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        done.swap(answered);
+    }
+    if (done.empty()) return;
+
+    Clock::time_point now = Clock::now();
+    for (auto &job : done) {
+        --inFlight;
+        ++(job->status == 200 ? completed : failed);
+        latency.record((uint64_t)chrono::duration_cast<chrono::microseconds>(now - job->arrived).count());
+        countAnswered(now);
+
+        auto it = connections.find(job->connection);
+        if (it == connections.end()) continue; // the client went away
+        Connection &c = *it->second;
+        c.busy = false;
+        respond(c, job->status, job->response);
+        // Answer the next pipelined request, if any, and send.
+        if (!handleRequests(c)) {
+            ::close(c.fd);
+            connections.erase(it);
+            --openConnections;
+        }
+    }
+}
+
+void ScheduleService::closeAll() {
+    for (auto &entry : connections) ::close(entry.second->fd);
+    connections.clear();
+    openConnections = 0;
+    if (listenFd >= 0) ::close(listenFd);
+    listenFd = -1;
+}
+
+#else
+
+void ScheduleService::ioLoop() {}
+
+#endif
@@ -0,0 +1,152 @@
+// ScheduleService.h
+//  Local schedule-generation service: a small HTTP/1.1 server that takes
+//  JSON plans (see readPlanJson()) and answers with JSON schedules.
+//  Requests that arrive together are micro-batched onto a work-stealing
+//  pool; once too many are waiting, new ones are turned away with 503
+//  instead of queueing without bound.
+//
+//   POST /schedule  plan in, {"days":...,"slots":[...],"shortfalls":[...]} out
+//   GET  /stats     counters, batch sizes, latency percentiles, throughput
+//   GET  /health    {"status":"ok"}
+
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "ScheduleGenerator.h"
+#include "WorkStealingPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int DEFAULT_SERVICE_PORT = 8765;
+
+struct ServiceOptions {
+    std::string host = "127.0.0.1"; // numeric IPv4 address; keep it local
+    int port = DEFAULT_SERVICE_PORT; // 0 picks a free port, see ScheduleService::port()
+    unsigned threads = 0;            // generator threads, 0 for one per core
+    size_t maxQueue = 256;           // schedule requests accepted but not yet answered
+    size_t maxBatch = 64;            // requests handed to the pool together
+    int batchWindowMicros = 200;     // how long a batch waits to fill up
+    size_t maxBodyBytes = 16u << 20;
+    size_t maxConnections = 1024;    // further clients wait in the listen backlog
+    int idleTimeoutSeconds = 30;     // keep-alive connections without a request are closed
+};
+
+struct ServiceStats {
+    uint64_t requests = 0;   // schedule requests received
+    uint64_t completed = 0;  // answered with a schedule
+    uint64_t failed = 0;     // answered with 400 (bad plan)
+    uint64_t rejected = 0;   // answered with 503 because the queue was full
+    uint64_t inFlight = 0;   // accepted and not yet answered
+    uint64_t batches = 0;
+    uint64_t connections = 0; // currently open
+    double meanBatch = 0.0;
+    // Microseconds from a request being read to its response being queued.
+    uint64_t p50Micros = 0;
+    uint64_t p90Micros = 0;
+    uint64_t p99Micros = 0;
+    uint64_t maxMicros = 0;
+    double meanMicros = 0.0;
+    double recentPerSecond = 0.0; // schedule requests answered per second over the last few seconds
+    double uptimeSeconds = 0.0;
+};
+
+// {"requests":...,"latency_us":{"p50":...},...}
+void writeServiceStatsJson(std::string &out, const ServiceStats &stats);
+
+class ScheduleService {
+public:
+    explicit ScheduleService(const ServiceOptions &o = ServiceOptions());
+    ~ScheduleService();
+
+    ScheduleService(const ScheduleService &) = delete;
+    ScheduleService &operator=(const ScheduleService &) = delete;
+
+    // Binds the socket and starts the I/O, batching and generator threads.
+    bool start(std::string &error);
+
+    // Stops accepting connections, answers every request already accepted,
+    // then shuts down. Safe to call more than once.
+    void stop();
+
+    // The bound port, also when options.port was 0.
+    int port() const { return boundPort; }
+
+    // Safe to call from any thread.
+    ServiceStats stats() const;
+
+private:
+    struct Connection;
+
+    // One schedule request on its way through the batcher.
+    struct Job {
+        uint64_t connection;
+        std::string body;
+        std::chrono::steady_clock::time_point arrived;
+        int status = 200;
+        std::string response; // JSON body
+    };
+
+    ServiceOptions options;
+    int listenFd = -1;
+    int wakeRead = -1;  // self-pipe: the batcher wakes the I/O thread
+    int wakeWrite = -1;
+    int boundPort = 0;
+    std::chrono::steady_clock::time_point started;
+
+    std::unique_ptr<WorkStealingPool> pool;
+    std::vector<ScheduleGenerator> generators; // one per pool worker
+    std::thread ioThread;
+    std::thread batchThread;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> running{false};
+
+    // I/O thread only.
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+    uint64_t nextConnection = 1;
+
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::deque<std::unique_ptr<Job>> pending;  // read, waiting for a batch
+    std::vector<std::unique_ptr<Job>> answered; // generated, waiting to be written
+    bool ioFinished = false;                    // the batcher may exit once pending is empty
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> inFlight{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> batchedJobs{0};
+    std::atomic<uint64_t> openConnections{0};
+    LatencyHistogram latency;
+
+    // Schedule requests answered per second of uptime, in a ring of recent seconds.
+    static constexpr int RATE_SECONDS = 8;
+    mutable std::mutex rateMutex;
+    int64_t rateSecond[RATE_SECONDS] = {};
+    uint64_t rateCount[RATE_SECONDS] = {};
+
+    void ioLoop();
+    void batchLoop();
+    void runBatch(std::vector<std::unique_ptr<Job>> &batch);
+    void generate(Job &job, ScheduleGenerator &gen);
+
+    void acceptClients();
+    bool readClient(Connection &c);
+    bool handleRequests(Connection &c);
+    bool flushClient(Connection &c);
+    void deliverAnswers();
+    void respond(Connection &c, int status, const std::string &body, const char *extraHeaders = "");
+    void countAnswered(std::chrono::steady_clock::time_point now);
+    void closeAll();
+};
@@ -0,0 +1,71 @@
+// Subject.h
+//  Subject model class
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Subject {
+private:
+    std::string name;
+    int difficulty;
+    int importance;
+    int topics;
+    int remainingMinutes;
+    int examDay;
+    std::vector<std::string> topicsList;
+    uint64_t revision = nextRevision();
+    uint64_t identity = revision;
+
+    static uint64_t nextRevision() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    void touch() { revision = nextRevision(); }
+public:
+    Subject() : name(""), difficulty(1), importance(1), topics(0), remainingMinutes(0), examDay(0) {}
+    Subject(const std::string &n, int diff, int imp, int t, const std::vector<std::string> &topicNames)
+        : name(n), difficulty(diff), importance(imp), topics(t), remainingMinutes(0), examDay(0), topicsList(topicNames) {}
+
+    const std::string &getName() const { return name; }
+    int getDifficulty() const { return difficulty; }
+    int getImportance() const { return importance; }
+    int getTopicsCount() const { return topics; }
+    int getRemainingMinutes() const { return remainingMinutes; }
+    void setRemainingMinutes(int minutes) { remainingMinutes = minutes; touch(); }
+
+    // 1-based plan day of the exam, 0 when there is none. Study time is
+    // only planned on the days before it.
+    int getExamDay() const { return examDay; }
+    bool hasExam() const { return examDay > 0; }
+    void setExamDay(int day) { examDay = day; touch(); }
+
+    bool hasTopics() const { return !topicsList.empty(); }
+    const std::vector<std::string> &getTopicsList() const { return topicsList; }
+
+    const std::string &getTopicAtIndex(size_t idx) const {
+        static const std::string placeholder("Topic");
+        if (topicsList.empty()) return placeholder;
+        return topicsList[idx % topicsList.size()];
+    }
+
+    // Changes with every edit; a copy keeps it until one of the two is
+    // edited, so equal revisions mean equal contents.
+    uint64_t getRevision() const { return revision; }
+
+    // Set once when the subject is created and kept through every edit and
+    // by its copies, so front ends can tell which subject is which.
+    uint64_t getId() const { return identity; }
+
+    void addTopic(std::string_view t) { topicsList.emplace_back(t); touch(); }
+    void reserveTopics(size_t n) { topicsList.reserve(n); }
+    void setName(const std::string &n) { name = n; touch(); }
+    void setDifficulty(int d) { difficulty = d; touch(); }
+    void setImportance(int i) { importance = i; touch(); }
+    void setTopics(int t) { topics = t; touch(); }
+    void setTopicsList(const std::vector<std::string> &tlist) { topicsList = tlist; topics = (int)tlist.size(); touch(); }
+};
@@ -0,0 +1,350 @@
+// SyllabusImport.cpp
+
+#include "SyllabusImport.h"
+#include "MappedFile.h"
+#include "PerfStats.h"
+#include "ScheduleConfig.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+constexpr uint32_t NO_SUBJECT = UINT32_MAX;
+
+// A topic still inside the source buffer. CSV fields that contained
+// doubled quotes are kept raw and unescaped when they are copied out.
+struct TopicRef {
+    const char *text;
+    uint32_t length;
+    uint32_t subject : 31;
+    uint32_t escaped : 1;
+};
+
+struct NewSubject {
+    string_view name;
+    int difficulty;
+    int importance;
+    int examDay;
+};
+
+bool lineError(string &error, size_t lineNo, const string &msg) {
+    error = "line " + to_string(lineNo) + ": " + msg;
+    return false;
+}
+
+string_view trim(string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t' || s[b] == '\r')) ++b;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r')) --e;
+    return s.substr(b, e - b);
+}
+
+bool equalsIgnoreCase(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    return true;
+}
+
+// line is keyword alone or keyword followed by blanks and the rest.
+bool startsWithKeyword(string_view line, string_view keyword) {
+    return line.substr(0, keyword.size()) == keyword &&
+           (line.size() == keyword.size() || line[keyword.size()] == ' ' || line[keyword.size()] == '\t');
+}
+
+// Whole of s as an integer, or false.
+bool parseInt(string_view s, int &value) {
+    if (s.empty()) return false;
+    auto r = from_chars(s.data(), s.data() + s.size(), value);
+    return r.ec == errc() && r.ptr == s.data() + s.size();
+}
+
+// Splits off the first blank-separated word of s.
+string_view firstWord(string_view &s) {
+    size_t n = 0;
+    while (n < s.size() && s[n] != ' ' && s[n] != '\t') ++n;
+    string_view word = s.substr(0, n);
+    s = trim(s.substr(n));
+    return word;
+}
+
+void unescapeInto(string &out, string_view raw) {
+    out.clear();
+    for (size_t i = 0; i < raw.size(); ++i) {
+        out += raw[i];
+        if (raw[i] == '"') ++i; // skip the second quote of the pair
+    }
+}
+
+// Collects subjects and topics as views into the source text, so nothing
+// is copied until the whole input has been validated.
+class SyllabusParser {
+public:
+    explicit SyllabusParser(const vector<Subject> &existing) : existingCount(existing.size()) {
+        byName.reserve(existing.size() * 2);
+        for (size_t i = 0; i < existing.size(); ++i) byName.emplace(existing[i].getName(), (uint32_t)i);
+    }
+
+    bool parseCsv(string_view text, string &error);
+    bool parseOutline(string_view text, string &error);
+
+    // Appends everything parsed to subjects: every topic list is reserved
+    // to its final size first, then each topic is copied in once.
+    void commit(vector<Subject> &subjects, SyllabusImportStats *stats);
+
+private:
+    size_t existingCount;
+    // Existing names are viewed in place and must not move before commit().
+    unordered_map<string_view, uint32_t> byName;
+    vector<NewSubject> added;
+    vector<TopicRef> topics;
+    deque<string> unescapedNames; // CSV names that had doubled quotes
+    string_view lastName;
+    uint32_t lastSubject = NO_SUBJECT;
+
+    // Rows of one subject usually follow each other, so the previous name
+    // is checked before the hash table.
+    uint32_t subjectFor(string_view name, int difficulty, int importance) {
+        if (lastSubject != NO_SUBJECT && name == lastName) return lastSubject;
+        auto it = byName.find(name);
+        uint32_t s;
+        if (it != byName.end()) {
+            s = it->second;
+        } else {
+            s = (uint32_t)(existingCount + added.size());
+            added.push_back(NewSubject{name, difficulty, importance, 0});
+            byName.emplace(name, s);
+        }
+        lastName = name;
+        lastSubject = s;
+        return s;
+    }
+
+    void addTopic(string_view text, uint32_t subject, bool escaped) {
+        topics.push_back(TopicRef{text.data(), (uint32_t)text.size(), subject, escaped ? 1u : 0u});
+    }
+};
+
+bool SyllabusParser::parseCsv(string_view text, string &error) {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    size_t lineNo = 1;
+    bool firstRow = true;
+    string_view fields[4];
+    bool escaped[4];
+
+    while (p < end) {
+        size_t rowLine = lineNo;
+        int count = 0;
+        for (;;) {
+            string_view f;
+            bool esc = false;
+            if (p < end && *p == '"') {
+                const char *start = ++p;
+                const char *close;
+                for (;;) {
+                    close = static_cast<const char *>(memchr(p, '"', (size_t)(end - p)));
+                    if (!close) return lineError(error, rowLine, "unterminated quoted field");
+                    if (close + 1 < end && close[1] == '"') {
+                        esc = true;
+                        p = close + 2;
+                        continue;
+                    }
+                    break;
+                }
+                f = string_view(start, (size_t)(close - start));
+                lineNo += (size_t)count_if(f.begin(), f.end(), [](char c) { return c == '\n'; });
+                p = close + 1;
+                if (p < end && *p == '\r') ++p;
+                if (p < end && *p != ',' && *p != '\n')
+                    return lineError(error, lineNo, "unexpected text after a quoted field");
+            } else {
+                const char *q = p;
+                while (q < end && *q != ',' && *q != '\n') ++q;
+                f = trim(string_view(p, (size_t)(q - p)));
+                p = q;
+            }
+            if (count == 4) return lineError(error, rowLine, "expected 'subject,topic[,difficulty,importance]'");
+            fields[count] = f;
+            escaped[count] = esc;
+            ++count;
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            break;
+        }
+        if (p < end) { // at the newline
+            ++p;
+            ++lineNo;
+        }
+
+        if (count == 1 && fields[0].empty()) continue;
+        if (firstRow) {
+            firstRow = false;
+            if (count >= 2 && equalsIgnoreCase(fields[0], "subject") && equalsIgnoreCase(fields[1], "topic")) continue;
+        }
+        if (count == 1 || count == 3)
+            return lineError(error, rowLine, "expected 'subject,topic[,difficulty,importance]'");
+
+        int difficulty = DEFAULT_IMPORT_SCORE, importance = DEFAULT_IMPORT_SCORE;
+        if (count == 4 && (!parseInt(fields[2], difficulty) || !parseInt(fields[3], importance) ||
+                           difficulty < 1 || difficulty > 10 || importance < 1 || importance > 10))
+            return lineError(error, rowLine, "difficulty and importance must be between 1 and 10");
+
+        string_view name = fields[0];
+        if (escaped[0]) {
+            unescapedNames.emplace_back();
+            unescapeInto(unescapedNames.back(), name);
+            name = unescapedNames.back();
+        }
+        if (name.empty()) return lineError(error, rowLine, "subject name cannot be empty");
+        if (fields[1].empty()) return lineError(error, rowLine, "topic cannot be empty");
+        addTopic(fields[1], subjectFor(name, difficulty, importance), escaped[1]);
+    }
+    return true;
+}
+
+bool SyllabusParser::parseOutline(string_view text, string &error) {
+    uint32_t current = NO_SUBJECT;
+    size_t currentTopics = 0;
+    auto finish = [&](size_t lineNo) {
+        // Like a plan file, a new subject needs at least one topic.
+        if (current != NO_SUBJECT && current >= existingCount && currentTopics == 0)
+            return lineError(error, lineNo, "subject '" + string(added[current - existingCount].name) + "' has no topics");
+        return true;
+    };
+
+    size_t lineNo = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t nl = text.find('\n', pos);
+        if (nl == string_view::npos) nl = text.size();
+        string_view line = trim(text.substr(pos, nl - pos));
+        pos = nl + 1;
+        ++lineNo;
+        if (line.empty() || line[0] == '#') continue;
+
+        // As in a plan file, a line is a header or an exam day only when all
+        // of it reads as one; inside a subject any other line is a topic,
+        // e.g. "exam technique". A header's name is free text, so every
+        // "subject <name>" line still starts a subject.
+        bool header = startsWithKeyword(line, "subject");
+        string_view rest = header ? trim(line.substr(7)) : string_view();
+        int day = 0;
+        if (header && (!rest.empty() || current == NO_SUBJECT)) {
+            if (!finish(lineNo)) return false;
+            int difficulty = DEFAULT_IMPORT_SCORE, importance = DEFAULT_IMPORT_SCORE;
+            string_view afterScores = rest;
+            int d = 0, i = 0;
+            if (parseInt(firstWord(afterScores), d) && parseInt(firstWord(afterScores), i) && !afterScores.empty()) {
+                if (d < 1 || d > 10 || i < 1 || i > 10)
+                    return lineError(error, lineNo, "difficulty and importance must be between 1 and 10");
+                difficulty = d;
+                importance = i;
+                rest = afterScores;
+            }
+            if (rest.empty()) return lineError(error, lineNo, "subject name cannot be empty");
+            current = subjectFor(rest, difficulty, importance);
+            currentTopics = 0;
+        } else if (current != NO_SUBJECT && startsWithKeyword(line, "exam") && parseInt(trim(line.substr(4)), day)) {
+            if (day < 1 || day > MAX_DAYS)
+                return lineError(error, lineNo, "exam day must be between 1 and " + to_string(MAX_DAYS));
+            if (current >= existingCount) added[current - existingCount].examDay = day;
+        } else {
+            if (current == NO_SUBJECT) return lineError(error, lineNo, "topic outside of a subject block");
+            addTopic(line, current, false);
+            ++currentTopics;
+        }
+    }
+    return finish(lineNo);
+}
+
+void SyllabusParser::commit(vector<Subject> &subjects, SyllabusImportStats *stats) {
+    size_t total = existingCount + added.size();
+    vector<uint32_t> counts(total, 0);
+    for (const TopicRef &t : topics) counts[t.subject]++;
+
+    subjects.reserve(total);
+    for (const NewSubject &n : added) {
+        Subject s;
+        s.setName(string(n.name));
+        s.setDifficulty(n.difficulty);
+        s.setImportance(n.importance);
+        s.setExamDay(n.examDay);
+        subjects.push_back(move(s));
+    }
+    for (size_t i = 0; i < total; ++i)
+        if (counts[i]) subjects[i].reserveTopics(subjects[i].getTopicsList().size() + counts[i]);
+
+    string scratch;
+    for (const TopicRef &t : topics) {
+        string_view text(t.text, t.length);
+        if (t.escaped) {
+            unescapeInto(scratch, text);
+            text = scratch;
+        }
+        subjects[t.subject].addTopic(text);
+    }
+
+    size_t extended = 0;
+    for (size_t i = 0; i < total; ++i) {
+        if (!counts[i]) continue;
+        subjects[i].setTopics((int)subjects[i].getTopicsList().size());
+        if (i < existingCount) ++extended;
+    }
+    if (stats) {
+        stats->subjectsAdded = added.size();
+        stats->subjectsExtended = extended;
+        stats->topics = topics.size();
+    }
+}
+}
+
+void splitTopicLines(string_view text, vector<string> &topics) {
+    for (size_t pos = 0; pos < text.size();) {
+        size_t nl = text.find('\n', pos);
+        if (nl == string_view::npos) nl = text.size();
+        string_view line = trim(text.substr(pos, nl - pos));
+        if (!line.empty()) topics.emplace_back(line);
+        pos = nl + 1;
+    }
+}
+
+bool importSyllabusText(string_view text, SyllabusFormat format, vector<Subject> &subjects, string &error,
+                        SyllabusImportStats *stats) {
+    PerfScope perf(PerfProbe::Import);
+    if (text.size() > UINT32_MAX) {
+        error = "syllabus larger than 4 GiB";
+        return false;
+    }
+    SyllabusParser parser(subjects);
+    bool ok = format == SyllabusFormat::Csv ? parser.parseCsv(text, error) : parser.parseOutline(text, error);
+    if (!ok) return false;
+    SyllabusImportStats counts;
+    parser.commit(subjects, &counts);
+    perf.addItems(counts.topics);
+    if (stats) *stats = counts;
+    return true;
+}
+
+bool importSyllabus(const string &path, vector<Subject> &subjects, string &error, SyllabusFormat format,
+                    SyllabusImportStats *stats) {
+    MappedFile file;
+    if (!file.open(path, error, true)) return false;
+    if (format == SyllabusFormat::Auto) {
+        bool csv = path.size() >= 4 && equalsIgnoreCase(string_view(path).substr(path.size() - 4), ".csv");
+        format = csv ? SyllabusFormat::Csv : SyllabusFormat::Outline;
+    }
+    if (!importSyllabusText(file.view(), format, subjects, error, stats)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
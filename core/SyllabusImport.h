@@ -0,0 +1,46 @@
+// SyllabusImport.h
+//  Bulk import of subjects and topics from syllabus files with thousands
+//  of topics per subject. The file is memory-mapped and split into string
+//  views in place; each topic is then copied exactly once, straight into
+//  its subject's reserved topic list.
+
+#pragma once
+
+#include "Subject.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Difficulty and importance of imported subjects that do not give them.
+static constexpr int DEFAULT_IMPORT_SCORE = 5;
+
+enum class SyllabusFormat {
+    Auto,    // Csv for a path ending in .csv, Outline otherwise
+    Csv,     // subject,topic[,difficulty,importance] rows; an optional
+             // "Subject,Topic" header row is skipped
+    Outline, // "subject [<difficulty> <importance>] <name>" headers, each
+             // followed by one topic per line and an optional "exam <day>";
+             // blank lines and lines starting with '#' are ignored
+};
+
+struct SyllabusImportStats {
+    size_t subjectsAdded = 0;
+    size_t subjectsExtended = 0; // existing subjects that received topics
+    size_t topics = 0;
+};
+
+// Adds the syllabus in path to subjects. Topics for a subject whose name
+// is already in subjects are appended to it, and its difficulty,
+// importance and exam day are kept. On error (with the line number) the
+// subjects are left unchanged.
+bool importSyllabus(const std::string &path, std::vector<Subject> &subjects, std::string &error,
+                    SyllabusFormat format = SyllabusFormat::Auto, SyllabusImportStats *stats = nullptr);
+
+// The same as importSyllabus() from text already in memory; Auto means Outline here.
+bool importSyllabusText(std::string_view text, SyllabusFormat format, std::vector<Subject> &subjects,
+                        std::string &error, SyllabusImportStats *stats = nullptr);
+
+// Appends every non-blank line of text, without surrounding blanks, to topics.
+void splitTopicLines(std::string_view text, std::vector<std::string> &topics);
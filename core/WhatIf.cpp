@@ -0,0 +1,97 @@
+// WhatIf.cpp
+
+#include "WhatIf.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void WhatIfExplorer::setPlan(const PlanInput &plan) {
+    settings.maxChunkMinutes = plan.maxChunkMinutes;
+    settings.minSlotMinutes = plan.minSlotMinutes;
+    settings.availability = plan.availability;
+    settings.reviewMinutes = plan.reviewMinutes;
+    settings.reviewSharePercent = plan.reviewSharePercent;
+    settings.policies = plan.policies;
+    tables.assign(1, makeSubjectTable(plan.subjects, plan.policies.weighting));
+}
+
+const vector<WhatIfResult> &WhatIfExplorer::run(const WhatIfGrid &grid) {
+    if (tables.empty()) setPlan(PlanInput());
+    while (generators.size() < pool.size())
+        generators.emplace_back(DEFAULT_DAYS, DEFAULT_MINUTES_PER_DAY);
+
+    // Weight sets are turned into tables once per run, not once per variant.
+    tables.resize(1);
+    for (const vector<uint64_t> &weights : grid.weightSets)
+        tables.push_back(withWeights(*tables[0], weights));
+
+    size_t sets = tables.size();
+    results.resize(grid.size());
+    size_t index = 0;
+    for (int days : grid.days) {
+        for (int minutes : grid.minutesPerDay) {
+            for (size_t w = 0; w < sets; ++w, ++index) {
+                WhatIfResult &result = results[index];
+                result.days = days;
+                result.minutesPerDay = minutes;
+                result.weightSet = (uint32_t)w;
+                pool.submit([this, &result](unsigned worker) { evaluate(generators[worker], result); });
+            }
+        }
+    }
+    pool.wait();
+    return results;
+}
+
+void WhatIfExplorer::evaluate(ScheduleGenerator &gen, WhatIfResult &result) {
+    const SubjectTable &table = *tables[result.weightSet];
+    gen.setParameters(result.days, result.minutesPerDay);
+    gen.setSlotLimits(settings.maxChunkMinutes, settings.minSlotMinutes);
+    gen.setAvailability(settings.availability);
+    gen.setReviews(settings.reviewMinutes, settings.reviewSharePercent);
+    gen.setPolicies(settings.policies);
+    gen.setSubjectTable(tables[result.weightSet]);
+    gen.prepare();
+
+    // Days are summarized as they are produced; no schedule is kept.
+    size_t n = table.size();
+    result.subjects.assign(n, WhatIfSubject());
+    result.totalMinutes = 0;
+    result.peakDay = 0;
+    result.peakMinutes = 0;
+    result.peakDifficulty = 0;
+    result.shortfalls = (uint32_t)gen.shortfalls().size();
+    while (gen.nextDay()) {
+        const DayStats &st = gen.currentDayStats();
+        if (st.minutes > result.peakMinutes) {
+            result.peakMinutes = st.minutes;
+            result.peakDay = gen.currentDayIndex();
+        }
+        result.peakDifficulty = max(result.peakDifficulty, st.difficultySum);
+        result.totalMinutes += (uint32_t)st.minutes;
+        for (const ScheduleSlot &t : gen.currentDay()) {
+            result.subjects[t.subject].minutes += t.minutes;
+            if (t.kind == SlotKind::Study) result.subjects[t.subject].topicsCovered++; // slot count until below
+        }
+    }
+
+    // Topics are visited in rotation, so k slots cover min(k, topics) of them.
+    const vector<uint32_t> &topicBase = table.names->topicBase;
+    result.minCoverage = n > 0 ? 1.0 : 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t topics = topicBase[i + 1] - topicBase[i];
+        WhatIfSubject &s = result.subjects[i];
+        s.topicsCovered = min(s.topicsCovered, topics);
+        result.minCoverage = min(result.minCoverage, topics ? (double)s.topicsCovered / topics : 1.0);
+    }
+}
+
+vector<uint64_t> scaleWeights(const SubjectTable &table, const vector<pair<uint32_t, double>> &factors) {
+    vector<uint64_t> weights(table.weights);
+    for (uint64_t &w : weights) w *= 100;
+    for (const auto &f : factors)
+        if (f.first < weights.size()) weights[f.first] = (uint64_t)llround(max(f.second, 0.0) * 100.0) * table.weights[f.first];
+    return weights;
+}
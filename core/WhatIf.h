@@ -0,0 +1,77 @@
+// WhatIf.h
+//  Sweeps a grid of plan variants (days × minutes per day × weight sets)
+//  on a thread pool and keeps only summary metrics per variant, so a whole
+//  grid is cheap enough to recompute while the user drags a control.
+
+#pragma once
+
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "WorkStealingPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct WhatIfGrid {
+    std::vector<int> days;
+    std::vector<int> minutesPerDay;
+    // Alternative weights, one entry per subject. Weight set 0 is always
+    // the plan's own weights; set k is weightSets[k - 1].
+    std::vector<std::vector<uint64_t>> weightSets;
+
+    size_t size() const { return days.size() * minutesPerDay.size() * (weightSets.size() + 1); }
+};
+
+struct WhatIfSubject {
+    uint32_t minutes = 0;
+    uint32_t topicsCovered = 0; // distinct topics studied at least once
+};
+
+struct WhatIfResult {
+    int days = 0;
+    int minutesPerDay = 0;
+    uint32_t weightSet = 0;
+
+    uint32_t totalMinutes = 0;
+    int peakDay = 0;             // 0-based day with the most minutes, first if tied
+    int peakMinutes = 0;
+    int peakDifficulty = 0;      // highest difficulty sum of any day
+    double minCoverage = 0.0;    // lowest share of a subject's topics covered
+    uint32_t shortfalls = 0;     // subjects short of their share because of exams
+    std::vector<WhatIfSubject> subjects;
+};
+
+class WhatIfExplorer {
+public:
+    explicit WhatIfExplorer(WorkStealingPool &p) : pool(p) {}
+
+    // Builds the subject table once; every later run() shares it. The
+    // plan's days and minutes per day are ignored, the grid sets them.
+    void setPlan(const PlanInput &plan);
+
+    const SubjectTable &subjectTable() const { return *tables[0]; }
+
+    // Generates every variant of grid and returns the results in grid
+    // order: days outermost, then minutes per day, then weight set. The
+    // reference stays valid until the next run().
+    const std::vector<WhatIfResult> &run(const WhatIfGrid &grid);
+
+private:
+    WorkStealingPool &pool;
+    PlanInput settings; // slot limits, availability, reviews and policies, without subjects
+
+    // [0] is the plan's table; the rest share its names with other weights.
+    std::vector<std::shared_ptr<const SubjectTable>> tables;
+
+    // One generator per worker, reused across runs so its buffers are too.
+    std::vector<ScheduleGenerator> generators;
+    std::vector<WhatIfResult> results;
+
+    void evaluate(ScheduleGenerator &gen, WhatIfResult &result);
+};
+
+// Weights of table with the listed subjects' weights multiplied by their
+// factors. Every weight is scaled by 100 so factors like 1.5 stay integral.
+std::vector<uint64_t> scaleWeights(const SubjectTable &table, const std::vector<std::pair<uint32_t, double>> &factors);
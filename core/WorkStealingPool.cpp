@@ -0,0 +1,96 @@
+// WorkStealingPool.cpp
+
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+namespace {
+thread_local const WorkStealingPool *currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i)
+        queues.push_back(make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (thread &t : workers) t.join();
+}
+
+void WorkStealingPool::submit(Job job) {
+    unsigned target = (currentPool == this) ? currentWorker
+                                            : nextQueue.fetch_add(1, memory_order_relaxed) % size();
+    // Counted before it is queued: a spinning worker may pop and finish it
+    // at once, and must not take the counts below zero.
+    {
+        lock_guard<mutex> lock(stateMutex);
+        ++unfinished;
+        pending.fetch_add(1, memory_order_release);
+    }
+    {
+        lock_guard<mutex> lock(queues[target]->mutex);
+        queues[target]->jobs.push_back(move(job));
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+bool WorkStealingPool::tryPop(unsigned self, Job &job) {
+    // Own deque is LIFO for cache warmth; steals take the oldest job.
+    {
+        Queue &own = *queues[self];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    unsigned n = size();
+    for (unsigned k = 1; k < n; ++k) {
+        Queue &victim = *queues[(self + k) % n];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned self) {
+    currentPool = this;
+    currentWorker = self;
+
+    for (;;) {
+        Job job;
+        if (tryPop(self, job)) {
+            pending.fetch_sub(1, memory_order_relaxed);
+            job(self);
+            job = nullptr;
+            lock_guard<mutex> lock(stateMutex);
+            if (--unfinished == 0) allDone.notify_all();
+            continue;
+        }
+
+        unique_lock<mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || pending.load(memory_order_acquire) > 0; });
+        if (stopping && pending.load(memory_order_acquire) == 0) return;
+    }
+}
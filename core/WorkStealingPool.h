@@ -0,0 +1,56 @@
+// WorkStealingPool.h
+//  Fixed-size thread pool with one job deque per worker; idle workers
+//  steal from the other deques so uneven jobs still keep every core busy.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    // The worker index passed to a job is stable for the pool's lifetime,
+    // so callers can keep per-thread scratch state indexed by it.
+    using Job = std::function<void(unsigned worker)>;
+
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned size() const { return (unsigned)queues.size(); } // complete before any worker starts
+
+    // Jobs submitted from a worker go to that worker's own deque.
+    void submit(Job job);
+
+    // Blocks until every submitted job has finished. Must not be called from a worker.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> pending{0};
+    size_t unfinished = 0;
+    bool stopping = false;
+    std::atomic<unsigned> nextQueue{0};
+
+    bool tryPop(unsigned self, Job &job);
+    void workerLoop(unsigned self);
+};
@@ -0,0 +1,102 @@
+// CalendarTests.cpp
+//  iCalendar import checks: recurrence expansion (COUNT, UNTIL, INTERVAL,
+//  BYDAY), EXDATE and RECURRENCE-ID, ignored events, and civil dates.
+
+#include "Calendar.h"
+#include "Check.h"
+#include "ScheduleConfig.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+string describe(const vector<TimeInterval> &intervals) {
+    string s;
+    for (const TimeInterval &t : intervals) s += "[" + to_string(t.start) + "," + to_string(t.end) + ")";
+    return s;
+}
+
+struct CalendarCase {
+    const char *name;
+    const char *events; // VEVENT blocks, wrapped in a VCALENDAR below
+    int days;
+    vector<TimeInterval> expected; // minutes from midnight of 2026-01-05, a Monday
+};
+
+const int DAY = MINUTES_PER_DAY;
+}
+
+void testCalendar() {
+    const CalendarCase cases[] = {
+        {"single event",
+         "BEGIN:VEVENT\nDTSTART:20260106T090000\nDTEND:20260106T103000\nEND:VEVENT\n", 7,
+         {{DAY + 540, DAY + 630}}},
+        {"DURATION instead of DTEND",
+         "BEGIN:VEVENT\nDTSTART:20260105T080000\nDURATION:PT1H15M\nEND:VEVENT\n", 7,
+         {{480, 555}}},
+        {"all-day event",
+         "BEGIN:VEVENT\nDTSTART;VALUE=DATE:20260107\nEND:VEVENT\n", 7,
+         {{2 * DAY, 3 * DAY}}},
+        {"daily COUNT",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;COUNT=3\nEND:VEVENT\n", 7,
+         {{540, 600}, {DAY + 540, DAY + 600}, {2 * DAY + 540, 2 * DAY + 600}}},
+        {"daily UNTIL is inclusive",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;UNTIL=20260107T090000\nEND:VEVENT\n", 7,
+         {{540, 600}, {DAY + 540, DAY + 600}, {2 * DAY + 540, 2 * DAY + 600}}},
+        {"INTERVAL",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;INTERVAL=3;COUNT=3\nEND:VEVENT\n", 14,
+         {{540, 600}, {3 * DAY + 540, 3 * DAY + 600}, {6 * DAY + 540, 6 * DAY + 600}}},
+        {"weekly BYDAY with COUNT",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=WEEKLY;BYDAY=MO,WE,FR;COUNT=4\nEND:VEVENT\n", 14,
+         {{540, 600}, {2 * DAY + 540, 2 * DAY + 600}, {4 * DAY + 540, 4 * DAY + 600}, {7 * DAY + 540, 7 * DAY + 600}}},
+        {"clipped to the plan",
+         "BEGIN:VEVENT\nDTSTART:20260101T090000\nDTEND:20260101T100000\nRRULE:FREQ=DAILY\nEND:VEVENT\n", 2,
+         {{540, 600}, {DAY + 540, DAY + 600}}},
+        {"EXDATE",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;COUNT=3\n"
+         "EXDATE:20260106T090000\nEND:VEVENT\n", 7,
+         {{540, 600}, {2 * DAY + 540, 2 * DAY + 600}}},
+        {"RECURRENCE-ID moves one instance",
+         "BEGIN:VEVENT\nUID:lecture\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;COUNT=3\nEND:VEVENT\n"
+         "BEGIN:VEVENT\nUID:lecture\nRECURRENCE-ID:20260106T090000\nDTSTART:20260106T140000\nDTEND:20260106T150000\nEND:VEVENT\n", 7,
+         {{540, 600}, {DAY + 840, DAY + 900}, {2 * DAY + 540, 2 * DAY + 600}}},
+        {"transparent and cancelled events are free",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nTRANSP:TRANSPARENT\nEND:VEVENT\n"
+         "BEGIN:VEVENT\nDTSTART:20260105T110000\nDTEND:20260105T120000\nSTATUS:CANCELLED\nEND:VEVENT\n", 7,
+         {}},
+        {"folded lines",
+         "BEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\nRRULE:FREQ=DAILY;\n COUNT=2\nEND:VEVENT\n", 7,
+         {{540, 600}, {DAY + 540, DAY + 600}}},
+    };
+    const CivilDate start{2026, 1, 5};
+    for (const CalendarCase &c : cases) {
+        string text = string("BEGIN:VCALENDAR\nVERSION:2.0\n") + c.events + "END:VCALENDAR\n";
+        vector<TimeInterval> busy;
+        string error;
+        bool ok = parseCalendar(text, start, c.days, busy, error);
+        sort(busy.begin(), busy.end(), [](const TimeInterval &a, const TimeInterval &b) { return a.start < b.start; });
+        check(ok, string("calendar ") + c.name + ": " + error);
+        bool same = busy.size() == c.expected.size() &&
+                    equal(busy.begin(), busy.end(), c.expected.begin(), [](const TimeInterval &a, const TimeInterval &b) {
+                        return a.start == b.start && a.end == b.end;
+                    });
+        check(same, string("calendar ") + c.name + ": got " + describe(busy) + ", expected " + describe(c.expected));
+    }
+
+    vector<TimeInterval> busy;
+    string error;
+    CalendarImportStats stats;
+    check(!parseCalendar("BEGIN:VEVENT\nEND:VEVENT\n", start, 7, busy, error), "calendar without VCALENDAR is rejected");
+    parseCalendar("BEGIN:VCALENDAR\nBEGIN:VEVENT\nDTSTART:20260105T090000\nDTEND:20260105T100000\n"
+                  "RRULE:FREQ=SECONDLY\nEND:VEVENT\nEND:VCALENDAR\n",
+                  start, 7, busy, error, &stats);
+    check(busy.empty() && stats.unsupported == 1, "calendar counts an unsupported rule and skips its event");
+
+    CivilDate d;
+    check(parseCivilDate("2024-02-29", d) && d.year == 2024 && d.month == 2 && d.day == 29, "leap day parses");
+    check(!parseCivilDate("2023-02-29", d), "2023-02-29 is rejected");
+    check(civilFromDays(daysFromCivil(CivilDate{2026, 12, 31})).day == 31, "civil date round trip");
+}
@@ -0,0 +1,20 @@
+// Check.h
+//  Failure counting shared by the adexa-tests suites, and the suites
+//  main() runs, one per core module.
+
+#pragma once
+
+#include <string>
+
+// Counts one check and prints what to stderr when ok is false.
+void check(bool ok, const std::string &what);
+
+void testCalendar();
+void testEditHistory();
+void testJson();
+void testCsvWriter();
+void testSyllabusImport();
+void testProfiles();
+void testReplan();
+void testScheduleIO();
+void testScheduleGenerator();
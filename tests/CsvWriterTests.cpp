@@ -0,0 +1,48 @@
+// CsvWriterTests.cpp
+//  RFC 4180 output checks: which fields are quoted and how quotes inside
+//  them are doubled.
+
+#include "Check.h"
+#include "CsvWriter.h"
+#include "Schedule.h"
+
+#include <string>
+
+using namespace std;
+
+void testCsvWriter() {
+    struct FieldCase {
+        const char *text;
+        const char *written;
+    };
+    const FieldCase fields[] = {
+        {"plain", "plain"},
+        {"", ""},
+        {"a,b", "\"a,b\""},
+        {"say \"hi\"", "\"say \"\"hi\"\"\""},
+        {"line\nbreak", "\"line\nbreak\""},
+        {"carriage\rreturn", "\"carriage\rreturn\""},
+        {"\"", "\"\"\"\""},
+    };
+    for (const FieldCase &f : fields) {
+        string buffer;
+        {
+            CsvWriter csv(buffer);
+            csv.field(f.text);
+            csv.field("x");
+            csv.endRow();
+        }
+        check(buffer == string(f.written) + ",x\n", string("csv field '") + f.text + "' is written as " + f.written);
+    }
+    {
+        string buffer;
+        {
+            CsvWriter csv(buffer);
+            csv.field(REVIEW_PREFIX, "a, b");
+            csv.field(42);
+            csv.timeField(75);
+            csv.endRow();
+        }
+        check(buffer == "\"" + string(REVIEW_PREFIX) + "a, b\",42,1h 15m\n", "csv prefixed field, number and time");
+    }
+}
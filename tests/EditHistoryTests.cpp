@@ -0,0 +1,165 @@
+// EditHistoryTests.cpp
+//  Undo/redo checks: every step restored through undo and redo gives back
+//  the subjects and schedule recorded for it, and restoring leaves the
+//  subjects and days the two states share where they were.
+
+#include "Check.h"
+#include "EditHistory.h"
+#include "Schedule.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "Subject.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+Subject makeSubject(const string &name, int difficulty, int importance, int topics) {
+    vector<string> list;
+    for (int t = 0; t < topics; ++t) list.push_back(name + " " + to_string(t + 1));
+    return Subject(name, difficulty, importance, topics, list);
+}
+
+bool sameSubjects(const vector<Subject> &a, const vector<Subject> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].getName() != b[i].getName() || a[i].getDifficulty() != b[i].getDifficulty() ||
+            a[i].getImportance() != b[i].getImportance() || a[i].getExamDay() != b[i].getExamDay() ||
+            a[i].getTopicsList() != b[i].getTopicsList() || a[i].getRevision() != b[i].getRevision())
+            return false;
+    return true;
+}
+
+bool sameSchedule(const Schedule &a, const Schedule &b) {
+    if (a.dayCount() != b.dayCount() || a.slotCount() != b.slotCount()) return false;
+    if (a.empty()) return true;
+    if (!sameNames(*a.nameTables(), *b.nameTables())) return false;
+    for (int d = 0; d < a.dayCount(); ++d) {
+        Schedule::DayView x = a.day(d), y = b.day(d);
+        if (x.size() != y.size() || a.dayStats(d).minutes != b.dayStats(d).minutes ||
+            a.dayStats(d).topicCount != b.dayStats(d).topicCount)
+            return false;
+        for (size_t k = 0; k < x.size(); ++k) {
+            const ScheduleSlot &s = x.begin()[k], &t = y.begin()[k];
+            if (s.subject != t.subject || s.topic != t.topic || s.minutes != t.minutes || s.kind != t.kind) return false;
+        }
+    }
+    return true;
+}
+
+// A copy of schedule with day d rebuilt by edit.
+template <class Edit>
+Schedule withDay(const Schedule &schedule, int d, Edit edit) {
+    Schedule out;
+    out.start(schedule.nameTables(), schedule.dayCount());
+    for (int k = 0; k < schedule.dayCount(); ++k) {
+        vector<ScheduleSlot> items(schedule.day(k).begin(), schedule.day(k).end());
+        DayStats stats = schedule.dayStats(k);
+        if (k == d) edit(items, stats);
+        out.appendDay(items, stats);
+    }
+    return out;
+}
+}
+
+void testEditHistory() {
+    // More subjects and days than one chunk holds, so restoring has chunks
+    // to share and chunks to rebuild.
+    PlanInput plan;
+    plan.days = 70;
+    plan.minutesPerDay = 6 * 60;
+    for (int i = 0; i < 40; ++i) plan.subjects.push_back(makeSubject("S" + to_string(i), i % 10 + 1, (i * 7) % 10 + 1, 6));
+    ScheduleGenerator gen(0, 0);
+
+    EditHistory history;
+    vector<vector<Subject>> subjectSteps;
+    vector<Schedule> scheduleSteps;
+    auto record = [&](const string &label, const vector<Subject> &subjects, const Schedule &schedule) {
+        history.record(label, subjects, schedule, false, 0);
+        subjectSteps.push_back(subjects);
+        scheduleSteps.push_back(schedule);
+    };
+
+    vector<Subject> subjects = plan.subjects;
+    record("start", subjects, Schedule());
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    record("generate", subjects, gen.getSchedule());
+    subjects[35].setImportance(subjects[35].getImportance() % 10 + 1);
+    record("edit", subjects, gen.getSchedule());
+    plan.subjects = subjects;
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    Schedule regenerated = gen.getSchedule();
+    record("regenerate", subjects, regenerated);
+    Schedule shortened = withDay(regenerated, 50, [](vector<ScheduleSlot> &items, DayStats &stats) {
+        items[0].minutes = (uint16_t)(items[0].minutes - 5);
+        stats.minutes -= 5;
+    });
+    record("shorten a slot", subjects, shortened);
+    Schedule fewer = withDay(shortened, 10, [](vector<ScheduleSlot> &items, DayStats &stats) {
+        stats.minutes -= items.back().minutes;
+        --stats.topicCount;
+        items.pop_back();
+    });
+    record("drop a slot", subjects, fewer);
+    subjects.erase(subjects.begin() + 3);
+    record("remove", subjects, fewer);
+    subjects.push_back(makeSubject("Added", 5, 5, 4));
+    record("add", subjects, fewer);
+    check(history.size() == subjectSteps.size(), "history: every step is kept");
+
+    // Walk back to the start and forward again, restoring from the step shown.
+    vector<Subject> working = subjects;
+    Schedule shown = fewer;
+    size_t step = history.size() - 1;
+    bool undoOk = true, redoOk = true;
+    while (history.canUndo()) {
+        const EditState &from = history.current();
+        const EditState &to = history.undo();
+        restoreSubjects(to, from, working);
+        restoreSchedule(*to.schedule, *from.schedule, shown);
+        --step;
+        undoOk &= sameSubjects(working, subjectSteps[step]) && sameSchedule(shown, scheduleSteps[step]);
+    }
+    check(undoOk && step == 0, "undo: every step restores the subjects and schedule recorded for it");
+    while (history.canRedo()) {
+        const EditState &from = history.current();
+        const EditState &to = history.redo();
+        restoreSubjects(to, from, working);
+        restoreSchedule(*to.schedule, *from.schedule, shown);
+        ++step;
+        redoOk &= sameSubjects(working, subjectSteps[step]) && sameSchedule(shown, scheduleSteps[step]);
+    }
+    check(redoOk && step == history.size() - 1, "redo: every step restores the subjects and schedule recorded for it");
+
+    // Undoing one subject's edit copies back that subject only, and redoing
+    // a change to one day leaves the other days' slots where they were.
+    auto go = [&](bool back) {
+        const EditState &from = history.current();
+        const EditState &to = back ? history.undo() : history.redo();
+        restoreSubjects(to, from, working);
+        restoreSchedule(*to.schedule, *from.schedule, shown);
+    };
+    while (history.undoLabel() != "edit") go(true);
+    const string *firstTopic = working[0].getTopicsList().data();
+    go(true);
+    check(working[0].getTopicsList().data() == firstTopic && sameSubjects(working, subjectSteps[1]),
+          "undo: subjects an edit did not touch are not copied back");
+    go(false);
+    go(false);
+    const ScheduleSlot *firstSlot = shown.allSlots().data();
+    go(false);
+    check(shown.allSlots().data() == firstSlot && sameSchedule(shown, scheduleSteps[4]),
+          "redo: a day of the same length is written over in place");
+
+    // Working forms that do not show from are rebuilt whole.
+    vector<Subject> none;
+    Schedule blank;
+    restoreSubjects(history.current(), history.current(), none);
+    restoreSchedule(*history.current().schedule, *history.current().schedule, blank);
+    check(sameSubjects(none, subjectSteps[4]) && sameSchedule(blank, scheduleSteps[4]),
+          "restore: forms that do not show the state restored from are rebuilt");
+}
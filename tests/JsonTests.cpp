@@ -0,0 +1,107 @@
+// JsonTests.cpp
+//  JSON reader checks: \u escapes and surrogate pairs, malformed documents
+//  and numbers, appendJsonString() round trips and the number writers.
+
+#include "Check.h"
+#include "Json.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace {
+struct JsonStringCase {
+    const char *name;
+    const char *text;
+    bool ok;
+    const char *expected; // the string value when ok
+};
+}
+
+void testJson() {
+    const JsonStringCase strings[] = {
+        {"plain", "\"abc\"", true, "abc"},
+        {"simple escapes", "\"a\\\"b\\\\c\\/d\\n\\t\"", true, "a\"b\\c/d\n\t"},
+        {"two-byte \\u", "\"\\u00e9\"", true, "\xc3\xa9"},
+        {"three-byte \\u", "\"\\u20ac\"", true, "\xe2\x82\xac"},
+        {"surrogate pair", "\"\\ud83d\\ude00\"", true, "\xf0\x9f\x98\x80"},
+        {"upper-case hex", "\"\\uD83D\\uDE00\"", true, "\xf0\x9f\x98\x80"},
+        {"unpaired high surrogate", "\"\\ud83d\"", false, ""},
+        {"high surrogate then a letter", "\"\\ud83dx\"", false, ""},
+        {"high surrogate then a non-surrogate", "\"\\ud83d\\u0041\"", false, ""},
+        {"lone low surrogate", "\"\\ude00\"", false, ""},
+        {"short \\u", "\"\\u12\"", false, ""},
+        {"invalid escape", "\"\\x41\"", false, ""},
+        {"raw control character", "\"a\nb\"", false, ""},
+        {"unterminated", "\"abc", false, ""},
+    };
+    for (const JsonStringCase &c : strings) {
+        JsonValue v;
+        string error;
+        bool ok = parseJson(c.text, v, error);
+        check(ok == c.ok, string("json ") + c.name + (c.ok ? " parses: " + error : " is rejected"));
+        if (ok && c.ok) check(v.isString() && v.text == c.expected, string("json ") + c.name + " decodes");
+    }
+
+    const char *malformed[] = {
+        "", "{", "[1,2,]", "{\"a\":1,}", "{\"a\" 1}", "{a:1}", "01", "1.", "-", "1e", "tru", "nul",
+        "[1] 2", "{\"a\":[}", "\"a\" \"b\"",
+    };
+    for (const char *text : malformed) {
+        JsonValue v;
+        string error;
+        check(!parseJson(text, v, error) && !error.empty(), string("json '") + text + "' is rejected with an error");
+    }
+
+    JsonValue v;
+    string error;
+    bool ok = parseJson(" {\"days\": 14, \"hours\": 2.5, \"on\": true, \"none\": null,"
+                        " \"list\": [1, -2e1, {\"x\": \"y\"}]} ",
+                        v, error);
+    check(ok && v.isObject(), "json document parses: " + error);
+    if (ok) {
+        const JsonValue *days = v.find("days");
+        const JsonValue *list = v.find("list");
+        check(days && days->isNumber() && days->number == 14.0, "json number member");
+        check(v.find("hours") && v.find("hours")->number == 2.5, "json fraction");
+        check(v.find("on") && v.find("on")->boolean, "json true");
+        check(v.find("none") && v.find("none")->isNull(), "json null");
+        check(list && list->isArray() && list->items.size() == 3 && list->items[1].number == -20.0, "json array");
+        check(list && list->items.size() == 3 && list->items[2].find("x") && list->items[2].find("x")->text == "y",
+              "json nested object");
+        check(!v.find("missing"), "json missing member");
+    }
+
+    JsonValue zeros;
+    check(parseJson("[0, -0.5, 10, 0e2]", zeros, error) && zeros.items.size() == 4 && zeros.items[1].number == -0.5 &&
+              zeros.items[2].number == 10.0,
+          "json zero and numbers starting with zero: " + error);
+
+    // appendJsonString() output reads back as the same string.
+    const string samples[] = {"", "plain", "quote \" and \\ backslash", "tab\tnewline\n\x01", "\xc3\xa9\xf0\x9f\x98\x80"};
+    for (const string &s : samples) {
+        string text;
+        appendJsonString(text, s);
+        JsonValue back;
+        check(parseJson(text, back, error) && back.isString() && back.text == s, "json string round trip of " + text);
+    }
+
+    // Numbers are written the same whatever the C locale, two decimals exact.
+    const pair<double, const char *> decimals[] = {
+        {0.0, "0.00"}, {12.5, "12.50"}, {1234.567, "1234.57"}, {0.994, "0.99"}, {0.996, "1.00"},
+        {-1.25, "-1.25"}, {-0.001, "0.00"}, {NAN, "0.00"}, {INFINITY, "0.00"},
+    };
+    for (const auto &d : decimals) {
+        string out;
+        appendJsonDecimal(out, d.first);
+        check(out == d.second, string("json decimal ") + d.second + ", got " + out);
+    }
+    string number;
+    appendJsonNumber(number, 0);
+    number += ',';
+    appendJsonNumber(number, UINT64_MAX);
+    check(number == "0,18446744073709551615", "json numbers 0 and UINT64_MAX, got " + number);
+}
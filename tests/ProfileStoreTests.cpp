@@ -0,0 +1,205 @@
+// ProfileStoreTests.cpp
+//  Binary profile checks: a save/open round trip of plan, subjects and
+//  schedule, and open() refusing damaged headers and records.
+
+#include "Check.h"
+#include "ProfileStore.h"
+#include "ScheduleConfig.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "Subject.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+PlanInput samplePlan() {
+    PlanInput plan;
+    plan.days = 21;
+    plan.minutesPerDay = 3 * 60;
+    plan.maxChunkMinutes = 90;
+    plan.minSlotMinutes = 15;
+    plan.availability.push_back(DayAvailability{6, 0});
+    plan.availability.push_back(DayAvailability{13, 60});
+    plan.reviewMinutes = 15;
+    plan.reviewSharePercent = 30;
+    plan.policies = SchedulePolicies{WeightingPolicy::LogDifficulty, RotationPolicy::LeastRecent};
+    Subject math("Mathematics", 8, 9, 3, {"Algebra", "Calculus, part 1", "Geometry"});
+    math.setExamDay(15);
+    Subject history("History", 4, 6, 2, {"World War I", "\"Quoted\" topic"});
+    plan.subjects = {math, history};
+    return plan;
+}
+
+bool readFile(const string &path, string &bytes) {
+    ifstream in(path, ios::binary);
+    bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    return (bool)in || in.eof();
+}
+
+bool writeFile(const string &path, const string &bytes) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), (streamsize)bytes.size());
+    return (bool)out;
+}
+}
+
+void testProfiles() {
+    const string path = "adexa-tests-profile.adxp";
+    const string damagedPath = "adexa-tests-damaged.adxp";
+    PlanInput plan = samplePlan();
+    ScheduleGenerator gen(0, 0);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const Schedule &schedule = gen.getSchedule();
+
+    string error;
+    check(saveProfile(path, plan, &schedule, error), "profile saves: " + error);
+    MappedProfile profile;
+    bool opened = profile.open(path, error);
+    check(opened, "profile opens: " + error);
+    if (opened) {
+        PlanInput back = profile.toPlan();
+        check(back.days == plan.days && back.minutesPerDay == plan.minutesPerDay &&
+                  back.maxChunkMinutes == plan.maxChunkMinutes && back.minSlotMinutes == plan.minSlotMinutes &&
+                  back.reviewMinutes == plan.reviewMinutes && back.reviewSharePercent == plan.reviewSharePercent &&
+                  back.policies == plan.policies,
+              "profile keeps the plan settings");
+        bool sameAvailability = back.availability.size() == plan.availability.size();
+        for (size_t k = 0; sameAvailability && k < back.availability.size(); ++k)
+            sameAvailability = back.availability[k].day == plan.availability[k].day &&
+                               back.availability[k].minutes == plan.availability[k].minutes;
+        check(sameAvailability, "profile keeps the availability");
+        bool sameSubjects = back.subjects.size() == plan.subjects.size();
+        for (size_t i = 0; sameSubjects && i < back.subjects.size(); ++i) {
+            const Subject &a = back.subjects[i], &b = plan.subjects[i];
+            sameSubjects = a.getName() == b.getName() && a.getDifficulty() == b.getDifficulty() &&
+                           a.getImportance() == b.getImportance() && a.getExamDay() == b.getExamDay() &&
+                           a.getTopicsList() == b.getTopicsList();
+        }
+        check(sameSubjects, "profile keeps the subjects");
+        check(planFingerprint(back) == planFingerprint(plan), "profile plan has the same fingerprint");
+
+        Schedule stored = profile.toSchedule();
+        bool sameSchedule = stored.dayCount() == schedule.dayCount() && stored.slotCount() == schedule.slotCount();
+        for (int d = 0; sameSchedule && d < schedule.dayCount(); ++d) {
+            Schedule::DayView a = stored.day(d), b = schedule.day(d);
+            sameSchedule = a.size() == b.size() && stored.dayStats(d).minutes == schedule.dayStats(d).minutes;
+            for (size_t k = 0; sameSchedule && k < a.size(); ++k) {
+                const ScheduleSlot &x = a.begin()[k], &y = b.begin()[k];
+                sameSchedule = x.subject == y.subject && x.topic == y.topic && x.minutes == y.minutes && x.kind == y.kind;
+            }
+        }
+        check(sameSchedule, "profile keeps the schedule");
+        profile.close();
+    }
+
+    string bytes;
+    check(readFile(path, bytes) && bytes.size() > sizeof(ProfileHeader), "profile reads back as bytes");
+    ProfileHeader header;
+    memcpy(&header, bytes.data(), sizeof header);
+
+    // Each damage must be refused by open() with an error, never crash later.
+    struct Damage {
+        const char *name;
+        void (*apply)(string &bytes, const ProfileHeader &h);
+    };
+    const Damage damages[] = {
+        {"magic", [](string &b, const ProfileHeader &) { b[0] = 'X'; }},
+        {"version", [](string &b, const ProfileHeader &) { b[4] ^= 0x40; }},
+        {"truncated", [](string &b, const ProfileHeader &) { b.resize(b.size() - 8); }},
+        {"negative days", [](string &b, const ProfileHeader &) {
+             int32_t v = -1828716484;
+             memcpy(&b[offsetof(ProfileHeader, days)], &v, sizeof v);
+         }},
+        {"days past MAX_DAYS", [](string &b, const ProfileHeader &) {
+             uint32_t v = MAX_DAYS + 1;
+             memcpy(&b[offsetof(ProfileHeader, days)], &v, sizeof v);
+         }},
+        {"minutes per day past a day", [](string &b, const ProfileHeader &) {
+             uint32_t v = MINUTES_PER_DAY + 1;
+             memcpy(&b[offsetof(ProfileHeader, minutesPerDay)], &v, sizeof v);
+         }},
+        {"unknown policy", [](string &b, const ProfileHeader &) {
+             uint32_t v = 7;
+             memcpy(&b[offsetof(ProfileHeader, weighting)], &v, sizeof v);
+         }},
+        {"subject count past the file", [](string &b, const ProfileHeader &) {
+             uint32_t v = 1u << 30;
+             memcpy(&b[offsetof(ProfileHeader, subjectCount)], &v, sizeof v);
+         }},
+        {"misaligned section", [](string &b, const ProfileHeader &) {
+             uint64_t v;
+             memcpy(&v, &b[offsetof(ProfileHeader, topicsOffset)], sizeof v);
+             v += 4;
+             memcpy(&b[offsetof(ProfileHeader, topicsOffset)], &v, sizeof v);
+         }},
+        {"difficulty out of range", [](string &b, const ProfileHeader &h) {
+             int32_t v = 77;
+             memcpy(&b[h.subjectsOffset + offsetof(SubjectRecord, difficulty)], &v, sizeof v);
+         }},
+        {"negative exam day", [](string &b, const ProfileHeader &h) {
+             int32_t v = -5;
+             memcpy(&b[h.subjectsOffset + offsetof(SubjectRecord, examDay)], &v, sizeof v);
+         }},
+        {"availability day past MAX_DAYS", [](string &b, const ProfileHeader &h) {
+             uint32_t v = MAX_DAYS;
+             memcpy(&b[h.availabilityOffset + offsetof(AvailabilityRecord, day)], &v, sizeof v);
+         }},
+        {"topic name past the strings", [](string &b, const ProfileHeader &h) {
+             uint32_t v = (uint32_t)h.stringsSize;
+             memcpy(&b[h.topicsOffset + offsetof(StringRef, offset)], &v, sizeof v);
+         }},
+        {"slot with an unknown subject", [](string &b, const ProfileHeader &h) {
+             uint32_t v = h.subjectCount;
+             memcpy(&b[h.slotsOffset + offsetof(ScheduleSlot, subject)], &v, sizeof v);
+         }},
+        {"day table out of order", [](string &b, const ProfileHeader &h) {
+             uint32_t v = h.slotCount + 1;
+             memcpy(&b[h.dayOffsetsOffset + sizeof(uint32_t)], &v, sizeof v);
+         }},
+    };
+    for (const Damage &d : damages) {
+        string damaged = bytes;
+        d.apply(damaged, header);
+        check(writeFile(damagedPath, damaged), string("profile with damaged ") + d.name + " is written");
+        MappedProfile bad;
+        error.clear();
+        bool badOpened = bad.open(damagedPath, error);
+        check(!badOpened && !error.empty(), string("profile with damaged ") + d.name + " is rejected");
+    }
+
+    // Writers racing on one path each use their own temporary file: the
+    // survivor is always a whole profile and nothing is left behind.
+    vector<thread> writers;
+    vector<uint8_t> saved(8, 0);
+    for (size_t w = 0; w < saved.size(); ++w)
+        writers.emplace_back([&, w] {
+            string writerError;
+            for (int k = 0; k < 20; ++k) saved[w] += saveProfile(path, plan, &schedule, writerError) ? 1 : 0;
+        });
+    for (thread &t : writers) t.join();
+    bool allSaved = true;
+    for (uint8_t n : saved) allSaved &= n == 20;
+    MappedProfile raced;
+    check(allSaved && raced.open(path, error) && raced.slotCount() == schedule.slotCount(),
+          "profile saved by racing writers is whole: " + error);
+    raced.close();
+    size_t leftovers = 0;
+    for (const filesystem::directory_entry &e : filesystem::directory_iterator("."))
+        leftovers += e.path().filename().string().rfind(path + ".tmp", 0) == 0 ? 1 : 0;
+    check(leftovers == 0, "profile writers leave no temporary files");
+
+    remove(path.c_str());
+    remove(damagedPath.c_str());
+}
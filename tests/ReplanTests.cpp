@@ -0,0 +1,166 @@
+// ReplanTests.cpp
+//  Replan checks: kept days stay as they were, skipped and partly done
+//  slots become debt that raises their subject's share of the remaining
+//  days, and their topics are studied again first.
+
+#include "Check.h"
+#include "ProgressJournal.h"
+#include "Replan.h"
+#include "Schedule.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "Subject.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+Subject makeSubject(const string &name, int difficulty, int importance, int topics) {
+    vector<string> list;
+    for (int t = 0; t < topics; ++t) list.push_back(name + " " + to_string(t + 1));
+    return Subject(name, difficulty, importance, topics, list);
+}
+
+bool sameDay(Schedule::DayView a, Schedule::DayView b) {
+    if (a.size() != b.size()) return false;
+    for (size_t k = 0; k < a.size(); ++k) {
+        const ScheduleSlot &x = a.begin()[k], &y = b.begin()[k];
+        if (x.subject != y.subject || x.topic != y.topic || x.minutes != y.minutes || x.kind != y.kind) return false;
+    }
+    return true;
+}
+
+// Study and review minutes per subject on days [firstDay, end).
+vector<uint64_t> minutesFrom(const Schedule &schedule, int firstDay, size_t subjects) {
+    vector<uint64_t> minutes(subjects, 0);
+    for (int d = firstDay; d < schedule.dayCount(); ++d)
+        for (const ScheduleSlot &s : schedule.day(d)) minutes[s.subject] += s.minutes;
+    return minutes;
+}
+
+void mark(ProgressJournal &journal, int day, uint32_t slot, const ScheduleSlot &s, ProgressStatus status, uint16_t minutes) {
+    string error;
+    journal.append(ProgressRecord{(uint32_t)day, slot, s.topic, minutes, status, 0}, error);
+}
+}
+
+void testReplan() {
+    PlanInput plan;
+    plan.days = 14;
+    plan.minutesPerDay = 4 * 60;
+    plan.subjects = {makeSubject("Maths", 6, 6, 12), makeSubject("Physics", 4, 4, 4), makeSubject("Art", 2, 2, 3)};
+    ScheduleGenerator gen(0, 0);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const Schedule &current = gen.getSchedule();
+    const int firstDay = 3;
+
+    // Every Maths slot of the first two days skipped, the first Physics slot
+    // of day 2 half done; everything else on the kept days counts as done.
+    ProgressJournal journal;
+    vector<uint32_t> debt(plan.subjects.size(), 0);
+    vector<uint32_t> mathsRedo;
+    for (int d = 0; d < 2; ++d) {
+        uint32_t k = 0;
+        for (const ScheduleSlot &s : current.day(d)) {
+            if (s.subject == 0) {
+                mark(journal, d, k, s, ProgressStatus::Skipped, 0);
+                debt[0] += s.minutes;
+                mathsRedo.push_back(s.topic);
+            }
+            ++k;
+        }
+    }
+    uint32_t physicsRedo = UINT32_MAX;
+    uint32_t k = 0;
+    for (const ScheduleSlot &s : current.day(2)) {
+        if (s.subject == 1) {
+            mark(journal, 2, k, s, ProgressStatus::Partial, (uint16_t)(s.minutes / 2));
+            debt[1] += s.minutes - s.minutes / 2;
+            physicsRedo = s.topic;
+            break;
+        }
+        ++k;
+    }
+    check(!mathsRedo.empty() && physicsRedo != UINT32_MAX, "replan: the test plan has slots to mark");
+
+    Replanner replanner;
+    Schedule out;
+    string error;
+    bool ok = replanner.replan(plan, current, journal, firstDay, out, error);
+    check(ok, "replan succeeds: " + error);
+    if (!ok) return;
+
+    bool keptOk = out.dayCount() == plan.days;
+    for (int d = 0; keptOk && d < firstDay; ++d) keptOk = sameDay(out.day(d), current.day(d));
+    check(keptOk, "replan: the kept days are unchanged");
+
+    const vector<SubjectProgress> &progress = replanner.progress();
+    bool debtOk = progress.size() == plan.subjects.size();
+    for (size_t i = 0; debtOk && i < progress.size(); ++i) debtOk = progress[i].debtMinutes() == debt[i];
+    check(debtOk && replanner.totalDebtMinutes() == debt[0] + debt[1], "replan: skipped and partial minutes are the debt");
+
+    bool fullOk = true;
+    for (int d = firstDay; d < out.dayCount(); ++d) fullOk &= out.dayStats(d).minutes == plan.minutesPerDay;
+    check(fullOk, "replan: the remaining days are full");
+
+    // The remaining days are shared by what each subject is still owed.
+    vector<uint64_t> later = minutesFrom(out, firstDay, plan.subjects.size());
+    uint64_t remaining = 0, owedTotal = 0;
+    for (int d = firstDay; d < out.dayCount(); ++d) remaining += out.dayStats(d).minutes;
+    for (const SubjectProgress &p : progress) owedTotal += p.owedMinutes;
+    bool sharesOk = owedTotal > 0;
+    for (size_t i = 0; sharesOk && i < later.size(); ++i) {
+        long long exact = (long long)(progress[i].owedMinutes * remaining / owedTotal);
+        sharesOk = llabs((long long)later[i] - exact) <= 2 * DEFAULT_MIN_SLOT_MINUTES;
+    }
+    check(sharesOk, "replan: the remaining days follow the owed minutes");
+
+    // Missed topics come first, in the order they were missed.
+    vector<uint32_t> maths, physics;
+    for (int d = firstDay; d < out.dayCount(); ++d)
+        for (const ScheduleSlot &s : out.day(d)) {
+            if (s.subject == 0 && maths.size() < mathsRedo.size()) maths.push_back(s.topic);
+            if (s.subject == 1 && physics.empty()) physics.push_back(s.topic);
+        }
+    check(maths == mathsRedo, "replan: skipped topics are studied again first, in order");
+    check(physics.size() == 1 && physics[0] == physicsRedo, "replan: a partly done topic is studied again first");
+
+    // Nothing reported: no debt, and the remaining days keep their shares
+    // to one slot. Against that, the debt takes time from the subjects
+    // without any: Physics, whose debt doubles what it still owes, gains and Art
+    // never does. (Maths owes little relative to its plan, so it may lose.)
+    ProgressJournal empty;
+    Schedule clean;
+    check(replanner.replan(plan, current, empty, firstDay, clean, error) && replanner.totalDebtMinutes() == 0,
+          "replan: an empty journal means no debt");
+    vector<uint64_t> planned = minutesFrom(current, firstDay, plan.subjects.size());
+    vector<uint64_t> kept = minutesFrom(clean, firstDay, plan.subjects.size());
+    bool unchangedOk = true;
+    for (size_t i = 0; i < plan.subjects.size(); ++i)
+        unchangedOk &= llabs((long long)kept[i] - (long long)planned[i]) <= 2 * DEFAULT_MIN_SLOT_MINUTES;
+    check(unchangedOk, "replan: without debt the remaining shares are kept");
+    check(later[1] > kept[1] && later[2] <= kept[2], "replan: debt raises its subject's share at the others' cost");
+
+    // A schedule of other subjects is refused and out is left alone.
+    PlanInput other = plan;
+    other.subjects.pop_back();
+    size_t slots = out.slotCount();
+    error.clear();
+    check(!replanner.replan(other, current, journal, firstDay, out, error) && !error.empty() && out.slotCount() == slots,
+          "replan: a schedule of other subjects is refused");
+
+    // The generator on its own plans only the days from a resume's first day.
+    PlanResume resume;
+    resume.firstDay = 5;
+    gen.setResume(resume);
+    gen.generateSchedule();
+    const Schedule &resumed = gen.getSchedule();
+    bool resumedOk = resumed.dayCount() == plan.days - resume.firstDay;
+    for (int d = 0; resumedOk && d < resumed.dayCount(); ++d) resumedOk = resumed.dayStats(d).minutes == plan.minutesPerDay;
+    check(resumedOk, "resume: only the days from the first day are planned, each full");
+}
@@ -0,0 +1,374 @@
+// ScheduleGeneratorTests.cpp
+//  Generator checks on small plans: slot lengths within the limits, full
+//  days, study time split by weight, exams met earliest first, spaced
+//  reviews within their share with the unused share given back to study,
+//  and the weighting and rotation policies.
+
+#include "Check.h"
+#include "Schedule.h"
+#include "ScheduleConfig.h"
+#include "ScheduleGenerator.h"
+#include "ScheduleIO.h"
+#include "SchedulePolicies.h"
+#include "Subject.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+Subject makeSubject(const string &name, int difficulty, int importance, int topics, int examDay = 0) {
+    vector<string> list;
+    for (int t = 0; t < topics; ++t) list.push_back(name + " " + to_string(t + 1));
+    Subject s(name, difficulty, importance, topics, list);
+    s.setExamDay(examDay);
+    return s;
+}
+
+// Minutes of kind per subject over the whole schedule.
+vector<uint64_t> minutesBySubject(const Schedule &schedule, size_t subjects, SlotKind kind = SlotKind::Study) {
+    vector<uint64_t> minutes(subjects, 0);
+    for (const ScheduleSlot &s : schedule.allSlots())
+        if (s.kind == kind && s.subject < subjects) minutes[s.subject] += s.minutes;
+    return minutes;
+}
+
+struct SlotLimitCase {
+    const char *name;
+    int minutesPerDay;
+    int maxChunk;
+    int minSlot;
+    int unit;    // the slot length every slot is a multiple of
+    int longest; // longest slot allowed
+};
+
+void testSlotLimits() {
+    const SlotLimitCase cases[] = {
+        {"defaults", 240, 120, 15, 15, 120},
+        {"half-hour slots", 240, 90, 30, 30, 90},
+        {"chunk not a multiple of the slot", 300, 50, 20, 20, 40},
+        {"slot longer than the chunk", 180, 30, 45, 30, 30},
+        {"slot longer than the day", 40, 120, 60, 40, 40},
+        {"one-minute slots", 61, 7, 1, 1, 7},
+    };
+    for (const SlotLimitCase &c : cases) {
+        PlanInput plan;
+        plan.days = 10;
+        plan.minutesPerDay = c.minutesPerDay;
+        plan.maxChunkMinutes = c.maxChunk;
+        plan.minSlotMinutes = c.minSlot;
+        plan.availability.push_back(DayAvailability{3, 0});
+        plan.availability.push_back(DayAvailability{4, c.minutesPerDay / 2});
+        plan.subjects = {makeSubject("Maths", 9, 8, 5), makeSubject("Art", 2, 3, 2), makeSubject("Law", 5, 5, 3)};
+        ScheduleGenerator gen(0, 0);
+        loadPlan(gen, plan);
+        gen.generateSchedule();
+        const Schedule &schedule = gen.getSchedule();
+        string name = string("slot limits, ") + c.name;
+
+        bool slotsOk = true;
+        for (const ScheduleSlot &s : schedule.allSlots())
+            slotsOk &= s.minutes > 0 && s.minutes % c.unit == 0 && s.minutes <= c.longest;
+        check(slotsOk, name + ": every slot is a whole number of slots within the chunk");
+
+        bool daysOk = schedule.dayCount() == plan.days;
+        for (int d = 0; daysOk && d < schedule.dayCount(); ++d) {
+            int available = d == 3 ? 0 : d == 4 ? c.minutesPerDay / 2 : c.minutesPerDay;
+            int minutes = 0;
+            for (const ScheduleSlot &s : schedule.day(d)) minutes += s.minutes;
+            daysOk = minutes == available / c.unit * c.unit && schedule.dayStats(d).minutes == minutes;
+        }
+        check(daysOk, name + ": every day is filled to its availability");
+    }
+}
+
+void testWeightedShares() {
+    PlanInput plan;
+    plan.days = 14;
+    plan.minutesPerDay = 4 * 60;
+    plan.subjects = {makeSubject("A", 6, 5, 4), makeSubject("B", 3, 5, 4), makeSubject("C", 1, 1, 1),
+                     makeSubject("D", 7, 3, 2)};
+    ScheduleGenerator gen(0, 0);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const SubjectTable &table = gen.subjectTable();
+    vector<uint64_t> minutes = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+
+    // Largest remainders over the whole plan: each share is its exact
+    // weighted share rounded down or up to a whole slot.
+    uint64_t total = (uint64_t)plan.days * plan.minutesPerDay;
+    uint64_t given = 0;
+    bool sharesOk = true;
+    for (size_t i = 0; i < minutes.size(); ++i) {
+        uint64_t exact = table.weights[i] * total; // over totalWeight
+        uint64_t low = exact / table.totalWeight / DEFAULT_MIN_SLOT_MINUTES * DEFAULT_MIN_SLOT_MINUTES;
+        sharesOk &= minutes[i] == low || minutes[i] == low + DEFAULT_MIN_SLOT_MINUTES;
+        given += minutes[i];
+    }
+    check(sharesOk && given == total, "weighted shares are exact to one slot");
+    check(gen.shortfalls().empty(), "a plan without exams has no shortfalls");
+
+    // The same subjects with one made twice as heavy get more time.
+    plan.subjects[2].setDifficulty(2);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    vector<uint64_t> heavier = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    check(heavier[2] > minutes[2] && heavier[0] <= minutes[0], "raising a weight raises that subject's share");
+}
+
+// Whether any study slot of a subject falls on or after its exam day.
+bool studiesAfterExam(const Schedule &schedule, const vector<Subject> &subjects) {
+    for (int d = 0; d < schedule.dayCount(); ++d)
+        for (const ScheduleSlot &s : schedule.day(d)) {
+            int exam = subjects[s.subject].getExamDay();
+            if (exam > 0 && d >= exam - 1) return true;
+        }
+    return false;
+}
+
+bool daysFull(const Schedule &schedule, int minutesPerDay) {
+    for (int d = 0; d < schedule.dayCount(); ++d)
+        if (schedule.dayStats(d).minutes != minutesPerDay) return false;
+    return true;
+}
+
+void testDeadlines() {
+    // Feasible: every exam leaves room for the subject's weighted share.
+    PlanInput plan;
+    plan.days = 14;
+    plan.minutesPerDay = 4 * 60;
+    plan.subjects = {makeSubject("Early", 2, 2, 2, 5), makeSubject("Middle", 5, 5, 3, 10), makeSubject("Open", 6, 6, 4)};
+    ScheduleGenerator gen(0, 0);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const SubjectTable &table = gen.subjectTable();
+    vector<uint64_t> minutes = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    check(!studiesAfterExam(gen.getSchedule(), plan.subjects), "deadlines: no study on or after an exam");
+    check(daysFull(gen.getSchedule(), plan.minutesPerDay), "deadlines: every day is full");
+    check(gen.shortfalls().empty(), "deadlines: feasible exams have no shortfalls");
+    bool sharesOk = true;
+    uint64_t total = (uint64_t)plan.days * plan.minutesPerDay;
+    for (size_t i = 0; i < minutes.size(); ++i) {
+        uint64_t exact = table.weights[i] * total / table.totalWeight;
+        uint64_t diff = minutes[i] > exact ? minutes[i] - exact : exact - minutes[i];
+        sharesOk &= diff < 2 * DEFAULT_MIN_SLOT_MINUTES;
+    }
+    check(sharesOk, "deadlines: feasible exams keep the weighted shares");
+
+    // Infeasible: the heaviest subject's exam leaves two days, which it
+    // must get whole; the time it cannot use goes to the others.
+    plan.subjects = {makeSubject("Soon", 10, 10, 4, 3), makeSubject("Later", 3, 3, 2, 12), makeSubject("Open", 2, 2, 2)};
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const Schedule &tight = gen.getSchedule();
+    minutes = minutesBySubject(tight, plan.subjects.size());
+    check(!studiesAfterExam(tight, plan.subjects) && daysFull(tight, plan.minutesPerDay),
+          "deadlines: a tight exam is met and the days stay full");
+    bool firstDaysOk = true;
+    for (int d = 0; d < 2; ++d)
+        for (const ScheduleSlot &s : tight.day(d)) firstDaysOk &= s.subject == 0;
+    check(firstDaysOk && minutes[0] == 2u * plan.minutesPerDay, "deadlines: the tight subject gets every day before its exam");
+    const vector<DeadlineShortfall> &shortfalls = gen.shortfalls();
+    check(shortfalls.size() == 1 && shortfalls[0].subject == 0 && shortfalls[0].plannedMinutes == minutes[0] &&
+              shortfalls[0].wantedMinutes > shortfalls[0].plannedMinutes,
+          "deadlines: the tight subject is the one shortfall");
+
+    // An exam on the first day leaves no time at all.
+    plan.subjects = {makeSubject("Today", 5, 5, 2, 1), makeSubject("Open", 5, 5, 2)};
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    minutes = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    check(minutes[0] == 0 && minutes[1] == (uint64_t)plan.days * plan.minutesPerDay,
+          "deadlines: an exam on day 1 gets nothing, the rest gets everything");
+    check(gen.shortfalls().size() == 1 && gen.shortfalls()[0].plannedMinutes == 0, "deadlines: and is a shortfall");
+
+    // Many staggered exams over weeks with a free day: each is met and the
+    // time none of them can use is still planned.
+    plan.days = 60;
+    plan.minutesPerDay = 3 * 60;
+    plan.subjects.clear();
+    for (int i = 0; i < 24; ++i)
+        plan.subjects.push_back(makeSubject("S" + to_string(i), 1 + i % 10, 1 + (i * 7) % 10, 1 + i % 5,
+                                            i % 4 == 3 ? 0 : 5 + (i * 13) % 55));
+    for (int d = 6; d < plan.days; d += 7) plan.availability.push_back(DayAvailability{d, 0});
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const Schedule &term = gen.getSchedule();
+    minutes = minutesBySubject(term, plan.subjects.size());
+    check(!studiesAfterExam(term, plan.subjects), "deadlines: staggered exams are all met");
+    bool plannedOk = true;
+    for (const DeadlineShortfall &f : gen.shortfalls())
+        plannedOk &= f.plannedMinutes == minutes[f.subject] && plan.subjects[f.subject].getExamDay() > 0;
+    check(plannedOk, "deadlines: shortfalls report what was planned, only for subjects with exams");
+    uint64_t placed = 0, available = 0;
+    for (uint64_t m : minutes) placed += m;
+    for (int d = 0; d < plan.days; ++d) available += d % 7 == 6 ? 0 : plan.minutesPerDay;
+    check(placed == available, "deadlines: staggered exams still use every free minute");
+}
+
+void testReviews() {
+    PlanInput plan;
+    plan.days = 60;
+    plan.minutesPerDay = 4 * 60;
+    plan.reviewMinutes = 15;
+    plan.reviewSharePercent = 25;
+    plan.subjects = {makeSubject("Maths", 8, 8, 12), makeSubject("History", 4, 5, 6, 40), makeSubject("Art", 2, 2, 3)};
+    ScheduleGenerator gen(0, 0);
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    const Schedule &schedule = gen.getSchedule();
+    const ScheduleNames &names = *schedule.nameTables();
+
+    // Days late in the plan have few reviews due; what they leave of the
+    // share must go back to study, not stay empty.
+    check(daysFull(schedule, plan.minutesPerDay), "reviews: unused review time is given back, every day is full");
+
+    const int share = plan.minutesPerDay * plan.reviewSharePercent / 100;
+    vector<int> firstStudy(names.topics.size(), -1);
+    bool sharesOk = true, orderOk = true, examOk = true, lengthOk = true;
+    size_t reviewCount = 0;
+    for (int d = 0; d < schedule.dayCount(); ++d) {
+        int reviewMinutes = 0;
+        for (const ScheduleSlot &s : schedule.day(d)) {
+            if (s.kind == SlotKind::Study) {
+                if (firstStudy[s.topic] < 0) firstStudy[s.topic] = d;
+                continue;
+            }
+            ++reviewCount;
+            reviewMinutes += s.minutes;
+            lengthOk &= s.minutes == plan.reviewMinutes;
+            orderOk &= firstStudy[s.topic] >= 0 && d - firstStudy[s.topic] >= REVIEW_INTERVALS[0];
+            int exam = plan.subjects[s.subject].getExamDay();
+            examOk &= exam == 0 || d < exam - 1;
+        }
+        sharesOk &= reviewMinutes <= share;
+    }
+    check(reviewCount > 0 && lengthOk, "reviews: are placed, each one review long");
+    check(sharesOk, "reviews: no day's reviews pass its share");
+    check(orderOk, "reviews: a topic is reviewed only after an interval past its first study");
+    check(examOk, "reviews: none on or after the subject's exam");
+
+    // Study time, given-back time included, still follows the weights.
+    const SubjectTable &table = gen.subjectTable();
+    vector<uint64_t> study = minutesBySubject(schedule, plan.subjects.size());
+    uint64_t studyTotal = study[0] + study[2]; // the two without exams share one deadline group
+    uint64_t exact = table.weights[0] * studyTotal / (table.weights[0] + table.weights[2]);
+    check(llabs((long long)study[0] - (long long)exact) <= 2 * plan.reviewMinutes,
+          "reviews: given-back time is shared by weight");
+
+    plan.reviewMinutes = 0;
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    check(minutesBySubject(gen.getSchedule(), plan.subjects.size(), SlotKind::Review) == vector<uint64_t>(3, 0),
+          "reviews: none when turned off");
+}
+
+struct WeightCase {
+    int difficulty, importance, topics;
+    uint64_t product, logDifficulty, importanceSquared;
+};
+
+void testPolicies() {
+    // log2Fixed8 in 1/256ths: log2(3) = 1.58496..., log2(11) = 3.45943...
+    const WeightCase weights[] = {
+        {1, 1, 1, 1, 256, 1},
+        {3, 2, 4, 24, 4 * 2 * 512, 3 * 4 * 4},
+        {2, 5, 1, 10, 5 * 405, 2 * 25},
+        {10, 10, 3, 300, 885 * 10 * 3, 10 * 100 * 3},
+        {0, 7, 2, 0, 0, 0},
+    };
+    for (const WeightCase &w : weights) {
+        vector<Subject> one = {makeSubject("S", w.difficulty, w.importance, w.topics)};
+        string name = "weights of " + to_string(w.difficulty) + "/" + to_string(w.importance) + "/" + to_string(w.topics);
+        check(makeSubjectTable(one, WeightingPolicy::Product)->weights[0] == w.product, name + ", product");
+        check(makeSubjectTable(one, WeightingPolicy::LogDifficulty)->weights[0] == w.logDifficulty, name + ", log-difficulty");
+        check(makeSubjectTable(one, WeightingPolicy::ImportanceSquared)->weights[0] == w.importanceSquared,
+              name + ", importance-squared");
+    }
+    const WeightingPolicy weightings[] = {WeightingPolicy::Product, WeightingPolicy::LogDifficulty,
+                                          WeightingPolicy::ImportanceSquared};
+    for (WeightingPolicy p : weightings) {
+        WeightingPolicy back = WeightingPolicy::Product;
+        check(parseWeighting(weightingName(p), back) && back == p, string("weighting name ") + weightingName(p));
+    }
+    RotationPolicy rotation = RotationPolicy::Cyclic;
+    check(parseRotation("least-recent", rotation) && rotation == RotationPolicy::LeastRecent &&
+              !parseRotation("random", rotation),
+          "rotation names");
+
+    // Least recent: unstudied topics in list order, skipping one studied
+    // out of turn, then the longest ago first.
+    vector<Subject> subjects = {makeSubject("A", 1, 1, 2), makeSubject("B", 1, 1, 4)};
+    shared_ptr<const SubjectTable> table = makeSubjectTable(subjects);
+    const ScheduleNames &names = *table->names;
+    LeastRecentRotation leastRecent;
+    leastRecent.reset(names, vector<size_t>());
+    uint32_t b = names.topicBase[1];
+    vector<uint32_t> picked;
+    picked.push_back(leastRecent.next(1));
+    picked.push_back(leastRecent.next(1));
+    leastRecent.studied(1, b + 3);
+    for (int k = 0; k < 5; ++k) picked.push_back(leastRecent.next(1));
+    check(picked == vector<uint32_t>{b, b + 1, b + 2, b, b + 1, b + 3, b + 2}, "least-recent rotation order");
+    leastRecent.reset(names, vector<size_t>{1, 2});
+    check(leastRecent.next(0) == 1 && leastRecent.next(1) == b + 2 && leastRecent.next(1) == b + 3 && leastRecent.next(1) == b,
+          "least-recent rotation continues from its start positions");
+
+    CyclicRotation cyclic;
+    cyclic.reset(names, vector<size_t>());
+    picked.clear();
+    cyclic.studied(1, b + 3); // ignored
+    for (int k = 0; k < 6; ++k) picked.push_back(cyclic.next(1));
+    check(picked == vector<uint32_t>{b, b + 1, b + 2, b + 3, b, b + 1}, "cyclic rotation order");
+
+    // In a plan: without reviews nothing is studied out of turn, so both
+    // rotations give the same schedule; reviews make them differ.
+    PlanInput plan;
+    plan.days = 30;
+    plan.minutesPerDay = 3 * 60;
+    plan.subjects = {makeSubject("Maths", 8, 7, 9), makeSubject("Art", 3, 9, 4), makeSubject("Law", 5, 2, 6)};
+    ScheduleGenerator gen(0, 0);
+    auto topicsOf = [&](RotationPolicy r, int reviewMinutes) {
+        plan.policies.rotation = r;
+        plan.reviewMinutes = reviewMinutes;
+        loadPlan(gen, plan);
+        gen.generateSchedule();
+        vector<uint32_t> topics;
+        for (const ScheduleSlot &s : gen.getSchedule().allSlots()) topics.push_back(s.topic);
+        return topics;
+    };
+    check(topicsOf(RotationPolicy::Cyclic, 0) == topicsOf(RotationPolicy::LeastRecent, 0),
+          "rotations agree without reviews");
+    check(topicsOf(RotationPolicy::Cyclic, 15) != topicsOf(RotationPolicy::LeastRecent, 15), "rotations differ with reviews");
+
+    // Weighting in a plan: squaring importance moves time to Art, the most
+    // important subject; log-scaling difficulty moves it away from Maths.
+    plan.reviewMinutes = 0;
+    plan.policies = SchedulePolicies();
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    vector<uint64_t> product = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    plan.policies.weighting = WeightingPolicy::ImportanceSquared;
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    vector<uint64_t> squared = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    plan.policies.weighting = WeightingPolicy::LogDifficulty;
+    loadPlan(gen, plan);
+    gen.generateSchedule();
+    vector<uint64_t> logScaled = minutesBySubject(gen.getSchedule(), plan.subjects.size());
+    check(squared[1] > product[1] && squared[2] < product[2], "importance-squared weighting favours importance");
+    check(logScaled[0] < product[0] && logScaled[1] > product[1], "log-difficulty weighting flattens difficulty");
+}
+}
+
+void testScheduleGenerator() {
+    testSlotLimits();
+    testWeightedShares();
+    testDeadlines();
+    testReviews();
+    testPolicies();
+}
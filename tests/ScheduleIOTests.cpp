@@ -0,0 +1,56 @@
+// ScheduleIOTests.cpp
+//  Plan file checks: settings read only from lines that are wholly a
+//  setting, topics that start with a setting's keyword, and malformed
+//  settings outside of a subject rejected with the line number.
+
+#include "Check.h"
+#include "ScheduleIO.h"
+#include "Subject.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void testScheduleIO() {
+    struct PlanCase {
+        const char *name;
+        const char *text;
+        bool ok;
+        int days;
+        vector<string> topics; // of the first subject
+        int examDay;           // of the first subject
+    };
+    const PlanCase plans[] = {
+        {"settings", "days 10\nhours 3\nsubject 5 5 Maths\nexam 8\nAlgebra\n", true, 10, {"Algebra"}, 8},
+        {"keyword topics", "subject 5 5 Maths\ndays of the week\nexam technique\nhours and minutes\nsubject matter\n",
+         true, DEFAULT_DAYS, {"days of the week", "exam technique", "hours and minutes", "subject matter"}, 0},
+        {"setting words as topics", "subject 5 5 English\nreviews\nweighting of evidence\nrotation of crops\navailable now\n",
+         true, DEFAULT_DAYS, {"reviews", "weighting of evidence", "rotation of crops", "available now"}, 0},
+        {"a number and more is a topic", "subject 5 5 History\nexam 1066 and all that\ndays 30 of summer\n", true,
+         DEFAULT_DAYS, {"exam 1066 and all that", "days 30 of summer"}, 0},
+        {"a whole setting still ends the block", "subject 5 5 Maths\nAlgebra\ndays 12\n", true, 12, {"Algebra"}, 0},
+        {"malformed setting outside a subject", "days fourteen\nsubject 5 5 Maths\nAlgebra\n", false, 0, {}, 0},
+        {"trailing text outside a subject", "hours 4 per day\nsubject 5 5 Maths\nAlgebra\n", false, 0, {}, 0},
+        {"setting out of range", "subject 5 5 Maths\nAlgebra\ndays 0\n", false, 0, {}, 0},
+        {"exam out of range", "subject 5 5 Maths\nexam 0\nAlgebra\n", false, 0, {}, 0},
+        {"subject scores out of range", "subject 11 5 Maths\nAlgebra\n", false, 0, {}, 0},
+        {"topic before any subject", "Algebra\n", false, 0, {}, 0},
+    };
+    for (const PlanCase &c : plans) {
+        istringstream in(c.text);
+        PlanInput plan;
+        string error;
+        bool ok = readPlan(in, plan, error);
+        check(ok == c.ok, string("plan ") + c.name + (c.ok ? " reads: " + error : " is rejected"));
+        if (!c.ok) {
+            check(error.compare(0, 5, "line ") == 0, string("plan ") + c.name + " names the line: " + error);
+            continue;
+        }
+        if (!ok) continue;
+        check(plan.days == c.days && !plan.subjects.empty() && plan.subjects[0].getTopicsList() == c.topics &&
+                  plan.subjects[0].getExamDay() == c.examDay,
+              string("plan ") + c.name + " reads its settings and topics");
+    }
+}
@@ -0,0 +1,76 @@
+// SyllabusImportTests.cpp
+//  Syllabus import checks: CSV quoted fields, doubled quotes, CRLF rows,
+//  scores, and rejected rows leaving the subjects unchanged; outline
+//  headers, exam days and topics that start with a keyword.
+
+#include "Check.h"
+#include "Subject.h"
+#include "SyllabusImport.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void testSyllabusImport() {
+    struct ImportCase {
+        const char *name;
+        const char *text;
+        bool ok;
+        const char *subject; // of the first subject
+        vector<string> topics;
+    };
+    const ImportCase imports[] = {
+        {"plain rows", "Math,Algebra\nMath,Calculus\n", true, "Math", {"Algebra", "Calculus"}},
+        {"header row skipped", "Subject,Topic\nMath,Algebra\n", true, "Math", {"Algebra"}},
+        {"quoted comma", "\"Math, Advanced\",\"Rings, fields\"\n", true, "Math, Advanced", {"Rings, fields"}},
+        {"doubled quotes", "Physics,\"The \"\"twin\"\" paradox\"\n", true, "Physics", {"The \"twin\" paradox"}},
+        {"quoted newline", "Art,\"two\nlines\"\n", true, "Art", {"two\nlines"}},
+        {"CRLF rows", "Math,Algebra\r\nMath,Geometry\r\n", true, "Math", {"Algebra", "Geometry"}},
+        {"scores", "Math,Algebra,7,3\n", true, "Math", {"Algebra"}},
+        {"unterminated quote", "Math,\"Algebra\n", false, "", {}},
+        {"text after a quote", "Math,\"Algebra\"x\n", false, "", {}},
+        {"score out of range", "Math,Algebra,11,3\n", false, "", {}},
+    };
+    for (const ImportCase &c : imports) {
+        vector<Subject> subjects;
+        string error;
+        bool ok = importSyllabusText(c.text, SyllabusFormat::Csv, subjects, error);
+        check(ok == c.ok, string("syllabus csv ") + c.name + (c.ok ? " imports: " + error : " is rejected"));
+        if (!ok || !c.ok) {
+            check(ok || subjects.empty(), string("syllabus csv ") + c.name + " leaves the subjects unchanged");
+            continue;
+        }
+        check(!subjects.empty() && subjects[0].getName() == c.subject && subjects[0].getTopicsList() == c.topics,
+              string("syllabus csv ") + c.name + " reads its fields");
+    }
+    vector<Subject> scored;
+    string error;
+    importSyllabusText("Math,Algebra,7,3\n", SyllabusFormat::Csv, scored, error);
+    check(scored.size() == 1 && scored[0].getDifficulty() == 7 && scored[0].getImportance() == 3, "syllabus csv scores");
+
+    struct OutlineCase {
+        const char *name;
+        const char *text;
+        bool ok;
+        vector<string> topics; // of the first subject
+        int examDay;           // of the first subject
+    };
+    const OutlineCase outlines[] = {
+        {"header and exam", "subject 7 3 Maths\nexam 9\nAlgebra\n", true, {"Algebra"}, 9},
+        {"keyword topics", "subject Maths\nexam technique\nexam 2024 papers\nsubject\nAlgebra\n", true,
+         {"exam technique", "exam 2024 papers", "subject", "Algebra"}, 0},
+        {"exam out of range", "subject Maths\nexam 0\nAlgebra\n", false, {}, 0},
+        {"bare header outside a subject", "subject\nAlgebra\n", false, {}, 0},
+        {"subject without topics", "subject Maths\nsubject Physics\nOptics\n", false, {}, 0},
+    };
+    for (const OutlineCase &c : outlines) {
+        vector<Subject> subjects;
+        string error;
+        bool ok = importSyllabusText(c.text, SyllabusFormat::Outline, subjects, error);
+        check(ok == c.ok, string("syllabus outline ") + c.name + (c.ok ? " imports: " + error : " is rejected"));
+        if (!ok || !c.ok) continue;
+        check(!subjects.empty() && subjects[0].getTopicsList() == c.topics && subjects[0].getExamDay() == c.examDay,
+              string("syllabus outline ") + c.name + " reads its topics");
+    }
+}
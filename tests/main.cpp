@@ -0,0 +1,40 @@
+// main.cpp
+//  adexa-tests: table-driven checks of the scheduling core, one suite per
+//  module. Prints each failure and exits with status 1 if there was any.
+
+#include "Check.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+int failures = 0;
+int checks = 0;
+}
+
+void check(bool ok, const string &what) {
+    ++checks;
+    if (ok) return;
+    ++failures;
+    cerr << "FAIL: " << what << "\n";
+}
+
+int main() {
+    testCalendar();
+    testJson();
+    testCsvWriter();
+    testSyllabusImport();
+    testScheduleIO();
+    testProfiles();
+    testEditHistory();
+    testScheduleGenerator();
+    testReplan();
+    if (failures) {
+        cerr << failures << " of " << checks << " checks failed\n";
+        return 1;
+    }
+    cout << checks << " checks passed\n";
+    return 0;
+}